@@ -0,0 +1,310 @@
+/*
+ * autoeq.h - Automatic EQ (fits the 10 graphic EQ bands to a measured response)
+ *
+ * Logic:
+ * 1. Input: the 1/6 octave response from measure.h, smoothed to 1/3 octave
+ *    (3 points, dB domain). Only fLo .. fHi is fitted (the speaker's own
+ *    roll-off is not corrected).
+ * 2. Model: the exact EQ filters (Biquad::setPeaking at EQ_FREQS, EQ_Q),
+ *    in the closed form of their analog prototype (RBJ peaking = bilinear
+ *    transform, W = tan(w/2) / tan(w0/2)):
+ *      |H|^2 = ((1 - W^2)^2 + (W*A/Q)^2) / ((1 - W^2)^2 + (W/(A*Q))^2)
+ *    The coefficient form cancels badly at low frequencies in float.
+ *    Plus a free level (the fit aims at the shape, the volume stays):
+ *      r_i = meas_i + level + sum_j eq_j(f_i; g_j) - target_i
+ *      target_i = tilt * log2(f_i / 1 kHz)
+ *      r_j = AUTOEQ_REG * g_j   (no band moves without need)
+ * 3. Solver: Levenberg-Marquardt, one iteration per step() on a core-0
+ *    task. Jacobian by forward difference (a band only changes its own
+ *    column), normal equations (J'J + mu*diag(J'J)) solved by Cholesky.
+ *    Gains are clamped to -AUTOEQ_MAX_CUT .. +maxBoost after each step:
+ *    deep room nulls are not filled.
+ * 4. Stop: cost improvement below AUTOEQ_TOL, mu runaway or
+ *    AUTOEQ_MAX_ITER iterations. Each iteration is a fixed amount of
+ *    float work (no allocation, no libm outside the model), so the run
+ *    time is bounded and the host build gives the same gains
+ *    (test/test_autoeq.cpp; no worker task there, the caller runs step()).
+ *
+ * The result goes through the preset path (web_server.h): stored in a
+ * preset slot and applied like /api/dsp.
+ */
+
+#ifndef AUTOEQ_H
+#define AUTOEQ_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <math.h>
+#include "dsp_engine.h"
+
+// ==========================================
+// CONFIGURATION
+// ==========================================
+#define AUTOEQ_MAX_POINTS   64      // >= MEAS_POINTS
+#define AUTOEQ_PARAMS       (EQ_BANDS + 1) // Gains + level
+#define AUTOEQ_MAX_CUT      12.0f   // dB (EQ slider range)
+#define AUTOEQ_MAX_BOOST    6.0f    // dB, default (user: 0 .. 12)
+#define AUTOEQ_F_LO         40.0f   // Default fit range (Hz)
+#define AUTOEQ_F_HI         16000.0f
+#define AUTOEQ_REG          0.5f    // Gain penalty weight (per band, vs. per point)
+#define AUTOEQ_STEP_DB      0.5f    // Result rounding (EQ slider step)
+#define AUTOEQ_DELTA_DB     0.05f   // Jacobian finite difference
+#define AUTOEQ_MAX_ITER     40
+#define AUTOEQ_TOL          1e-4f   // Relative cost improvement to continue
+#define AUTOEQ_TASK_PRIORITY 1
+#define AUTOEQ_TASK_CORE    0       // Audio runs in loop() on core 1
+
+enum AutoEqState { AEQ_IDLE, AEQ_RUNNING, AEQ_DONE, AEQ_ERROR };
+
+class AutoEQ {
+private:
+    // Fit data
+    float freq[AUTOEQ_MAX_POINTS];
+    float dev[AUTOEQ_MAX_POINTS];       // Smoothed measurement - target (dB)
+    float tw[AUTOEQ_MAX_POINTS];        // tan(w/2)
+    int first = 0, count = 0;           // Fitted points
+    float maxBoost = AUTOEQ_MAX_BOOST;
+
+    // Solver state
+    float x[AUTOEQ_PARAMS];             // Gains (dB), level (dB)
+    float bandDb[EQ_BANDS][AUTOEQ_MAX_POINTS]; // Response of each band at x
+    float jac[EQ_BANDS][AUTOEQ_MAX_POINTS];    // d(band dB) / d(gain)
+    float trialDb[EQ_BANDS][AUTOEQ_MAX_POINTS]; // Same at the trial step (off the task stack)
+    float cost = 0, mu = 0;
+    float errBefore = 0, errAfter = 0;  // RMS deviation (dB)
+    int iter = 0;
+
+    std::atomic<int> state{AEQ_IDLE};
+#ifdef ARDUINO
+    TaskHandle_t task = nullptr;
+#endif
+
+public:
+    // Starts the worker task
+    void begin() {
+#ifdef ARDUINO
+        if (!task) xTaskCreatePinnedToCore(workerTask, "autoeq", 4096, this,
+                                           AUTOEQ_TASK_PRIORITY, &task, AUTOEQ_TASK_CORE);
+#endif
+    }
+
+    // Copies the response (freqs ascending, dB) and starts fitting.
+    // Returns false if busy or fewer than 3 points fall in fLo .. fHi.
+    bool start(const float* f, const float* db, int n, float fLo = AUTOEQ_F_LO, float fHi = AUTOEQ_F_HI,
+               float tiltDbOct = 0.0f, float boostDb = AUTOEQ_MAX_BOOST) {
+        if (isBusy()) return false;
+        if (n > AUTOEQ_MAX_POINTS) n = AUTOEQ_MAX_POINTS;
+        maxBoost = constrain(boostDb, 0.0f, AUTOEQ_MAX_CUT);
+
+        // 1/3 octave smoothing (neighbours on the 1/6 octave grid), minus the target
+        first = n;
+        count = 0;
+        for (int i = 0; i < n; i++) {
+            float sum = db[i];
+            int k = 1;
+            if (i > 0) { sum += db[i - 1]; k++; }
+            if (i < n - 1) { sum += db[i + 1]; k++; }
+            if (f[i] < fLo || f[i] > fHi || f[i] >= 22050.0f) continue;
+            if (i < first) first = i;
+            int j = i - first;
+            if (j != count) continue; // fLo .. fHi must be contiguous
+            freq[j] = f[i];
+            dev[j] = sum / k - tiltDbOct * log2f(f[i] / 1000.0f);
+            tw[j] = tanf(PI * f[i] / 44100.0f);
+            count++;
+        }
+        if (count < 3) {
+            state = AEQ_ERROR;
+            return false;
+        }
+
+        // Flat EQ, level at the mean deviation
+        float mean = 0;
+        for (int i = 0; i < count; i++) mean += dev[i];
+        mean /= count;
+        for (int j = 0; j < EQ_BANDS; j++) x[j] = 0.0f;
+        x[EQ_BANDS] = -mean;
+        for (int j = 0; j < EQ_BANDS; j++) bandResponse(j, 0.0f, bandDb[j]);
+        cost = evalCost(x, bandDb);
+        errBefore = errAfter = residualRms(x, bandDb);
+        mu = 1e-3f;
+        iter = 0;
+
+        state.store(AEQ_RUNNING, std::memory_order_release);
+#ifdef ARDUINO
+        if (task) xTaskNotifyGive(task);
+#endif
+        return true;
+    }
+
+    bool isBusy() { return state.load(std::memory_order_acquire) == AEQ_RUNNING; }
+    int getState() { return state.load(std::memory_order_acquire); }
+    int getIterations() { return iter; }
+
+    // ==========================================
+    // SOLVER (one LM iteration per call, worker task)
+    // ==========================================
+    // Returns true while more work is pending
+    bool step() {
+        if (state.load(std::memory_order_acquire) != AEQ_RUNNING) return false;
+
+        // Jacobian at x (gains only: d r / d level = 1)
+        for (int j = 0; j < EQ_BANDS; j++) {
+            bandResponse(j, x[j] + AUTOEQ_DELTA_DB, jac[j]);
+            for (int i = 0; i < count; i++) jac[j][i] = (jac[j][i] - bandDb[j][i]) / AUTOEQ_DELTA_DB;
+        }
+
+        // Normal equations: A = J'J (+ penalty), g = J'r
+        float A[AUTOEQ_PARAMS][AUTOEQ_PARAMS];
+        float g[AUTOEQ_PARAMS];
+        memset(A, 0, sizeof(A));
+        memset(g, 0, sizeof(g));
+        for (int i = 0; i < count; i++) {
+            float r = residual(i, x, bandDb);
+            float J[AUTOEQ_PARAMS];
+            for (int j = 0; j < EQ_BANDS; j++) J[j] = jac[j][i];
+            J[EQ_BANDS] = 1.0f;
+            for (int a = 0; a < AUTOEQ_PARAMS; a++) {
+                g[a] += J[a] * r;
+                for (int b = 0; b <= a; b++) A[a][b] += J[a] * J[b];
+            }
+        }
+        for (int j = 0; j < EQ_BANDS; j++) {
+            A[j][j] += AUTOEQ_REG * AUTOEQ_REG;
+            g[j] += AUTOEQ_REG * AUTOEQ_REG * x[j];
+        }
+
+        // Damped steps until one lowers the cost (bounded by mu)
+        float trial[AUTOEQ_PARAMS];
+        bool accepted = false;
+        float newCost = cost;
+        while (!accepted && mu < 1e6f) {
+            float M[AUTOEQ_PARAMS][AUTOEQ_PARAMS];
+            float d[AUTOEQ_PARAMS];
+            for (int a = 0; a < AUTOEQ_PARAMS; a++) {
+                for (int b = 0; b <= a; b++) M[a][b] = A[a][b];
+                M[a][a] += mu * A[a][a];
+                d[a] = -g[a];
+            }
+            if (!cholSolve(M, d)) { mu *= 4.0f; continue; }
+
+            for (int j = 0; j < EQ_BANDS; j++) {
+                trial[j] = constrain(x[j] + d[j], -AUTOEQ_MAX_CUT, maxBoost);
+                bandResponse(j, trial[j], trialDb[j]);
+            }
+            trial[EQ_BANDS] = x[EQ_BANDS] + d[EQ_BANDS];
+            newCost = evalCost(trial, trialDb);
+            if (newCost < cost) accepted = true;
+            else mu *= 4.0f;
+        }
+
+        iter++;
+        bool done = !accepted || iter >= AUTOEQ_MAX_ITER;
+        if (accepted) {
+            done = done || (cost - newCost) < AUTOEQ_TOL * cost;
+            memcpy(x, trial, sizeof(x));
+            memcpy(bandDb, trialDb, sizeof(bandDb));
+            cost = newCost;
+            mu = fmaxf(mu * 0.3f, 1e-7f);
+        }
+        if (done) finish();
+        return !done;
+    }
+
+    // ==========================================
+    // RESULTS (valid in AEQ_DONE)
+    // ==========================================
+    float getGain(int band) { return x[band]; }   // dB, rounded to AUTOEQ_STEP_DB
+    float getLevel() { return x[EQ_BANDS]; }      // Offset that was fitted away
+    float getErrorBefore() { return errBefore; }  // RMS deviation in the fit range (dB)
+    float getErrorAfter() { return errAfter; }
+
+private:
+    // dB response of band j with gain gDb at the fitted points
+    void bandResponse(int j, float gDb, float* out) {
+        float A = powf(10.0f, gDb / 40.0f);
+        float zq = A / EQ_Q, pq = 1.0f / (A * EQ_Q);
+        float k0 = 1.0f / tanf(PI * EQ_FREQS[j] / 44100.0f);
+        for (int i = 0; i < count; i++) {
+            float W = tw[i] * k0;
+            float u = 1.0f - W * W;
+            u *= u;
+            float num = u + W * W * zq * zq;
+            float den = u + W * W * pq * pq;
+            out[i] = 10.0f * log10f(num / den);
+        }
+    }
+
+    inline float residual(int i, const float* p, const float (*bands)[AUTOEQ_MAX_POINTS]) {
+        float r = dev[i] + p[EQ_BANDS];
+        for (int j = 0; j < EQ_BANDS; j++) r += bands[j][i];
+        return r;
+    }
+
+    float evalCost(const float* p, const float (*bands)[AUTOEQ_MAX_POINTS]) {
+        float c = 0;
+        for (int i = 0; i < count; i++) {
+            float r = residual(i, p, bands);
+            c += r * r;
+        }
+        for (int j = 0; j < EQ_BANDS; j++) c += AUTOEQ_REG * AUTOEQ_REG * p[j] * p[j];
+        return c;
+    }
+
+    float residualRms(const float* p, const float (*bands)[AUTOEQ_MAX_POINTS]) {
+        float c = 0;
+        for (int i = 0; i < count; i++) {
+            float r = residual(i, p, bands);
+            c += r * r;
+        }
+        return sqrtf(c / count);
+    }
+
+    // Rounds to the slider step and reports the error of what gets applied
+    void finish() {
+        for (int j = 0; j < EQ_BANDS; j++) {
+            x[j] = roundf(x[j] / AUTOEQ_STEP_DB) * AUTOEQ_STEP_DB + 0.0f; // No -0
+            bandResponse(j, x[j], bandDb[j]);
+        }
+        errAfter = residualRms(x, bandDb);
+        state.store(AEQ_DONE, std::memory_order_release);
+    }
+
+    // M (lower triangle) x = d, in place (d becomes x). False if not positive definite.
+    static bool cholSolve(float (*M)[AUTOEQ_PARAMS], float* d) {
+        const int n = AUTOEQ_PARAMS;
+        for (int a = 0; a < n; a++) {
+            for (int b = 0; b <= a; b++) {
+                float s = M[a][b];
+                for (int k = 0; k < b; k++) s -= M[a][k] * M[b][k];
+                if (a == b) {
+                    if (s <= 0.0f) return false;
+                    M[a][a] = sqrtf(s);
+                } else {
+                    M[a][b] = s / M[b][b];
+                }
+            }
+        }
+        for (int a = 0; a < n; a++) {
+            for (int k = 0; k < a; k++) d[a] -= M[a][k] * d[k];
+            d[a] /= M[a][a];
+        }
+        for (int a = n - 1; a >= 0; a--) {
+            for (int k = a + 1; k < n; k++) d[a] -= M[k][a] * d[k];
+            d[a] /= M[a][a];
+        }
+        return true;
+    }
+
+#ifdef ARDUINO
+    static void workerTask(void* arg) {
+        AutoEQ* e = (AutoEQ*)arg;
+        for (;;) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            while (e->step()) vTaskDelay(1); // One iteration per tick
+        }
+    }
+#endif
+};
+
+#endif // AUTOEQ_H
@@ -10,6 +10,7 @@ class BlueStream {
 private:
     BluetoothA2DPSink sink;
     BluetoothA2DPSource source;
+    A2DPNoVolumeControl noVolume; // Sink PCM stays full scale: AudioDSP does the volume
 
     bool isTxMode = false; // false = Sink (RX), true = Source (TX)
     String deviceName;     // My Name (for RX)
@@ -27,22 +28,40 @@ public:
     // data_cb: Funzione che riceve l'audio (bt_data_callback)
     // meta_cb: Funzione opzionale per leggere Titolo/Artista
     // vol_cb:  [NEW] Funzione opzionale per sincronizzare il volume (Telefono -> ESP32)
+    // play_cb: Funzione opzionale per lo stato di riproduzione (Play/Pausa/Stop)
+    // pos_cb:  Funzione opzionale per la posizione nel brano (ms)
     void startRX(void (*data_cb)(const uint8_t*, uint32_t), 
                  void (*meta_cb)(uint8_t, const uint8_t*) = nullptr,
-                 void (*vol_cb)(int) = nullptr) {
+                 void (*vol_cb)(int) = nullptr,
+                 void (*play_cb)(esp_avrc_playback_stat_t) = nullptr,
+                 void (*pos_cb)(uint32_t) = nullptr) {
         
         // Se eravamo in TX, spegni tutto
         if (isTxMode) stop();
         isTxMode = false;
 
-        // Configura Callback Audio (stream reader)
-        sink.set_stream_reader(data_cb);
+        // Configura Callback Audio (stream reader). Niente I2S della libreria:
+        // data_cb scrive su I2S0, installato dallo sketch (stessi buffer DMA di I2S1)
+        sink.set_stream_reader(data_cb, false);
+
+        // Volume applicato dal DSP (AVRCP serve solo a sincronizzare il cursore)
+        sink.set_volume_control(&noVolume);
 
         // Configura Callback Metadata (opzionale per Display)
         if (meta_cb != nullptr) {
+            sink.set_avrc_metadata_attribute_mask(ESP_AVRC_MD_ATTR_TITLE | ESP_AVRC_MD_ATTR_ARTIST |
+                                                  ESP_AVRC_MD_ATTR_ALBUM | ESP_AVRC_MD_ATTR_PLAYING_TIME);
             sink.set_avrc_metadata_callback(meta_cb);
         }
 
+        // Stato e posizione (notifiche AVRCP, posizione ogni secondo)
+        if (play_cb != nullptr) {
+            sink.set_avrc_rn_playstatus_callback(play_cb);
+        }
+        if (pos_cb != nullptr) {
+            sink.set_avrc_rn_play_pos_callback(pos_cb, 1);
+        }
+
         // [NEW] Configura Callback Volume (opzionale per sincronizzazione)
         if (vol_cb != nullptr) {
             sink.set_avrc_rn_volumechange(vol_cb);
@@ -0,0 +1,310 @@
+/*
+ * convolver.h - Uniformly Partitioned FFT Convolution (FIR Room Correction)
+ *
+ * Logic (overlap-save, partition size B, FFT size 2B):
+ * 1. The IR is cut into P partitions of B taps. Each is zero-padded to 2B
+ *    and transformed once at load time (spectra in PSRAM when available).
+ * 2. Every B input samples: FFT of [previous B | new B] -> pushed into the
+ *    frequency-domain delay line (FDL, internal RAM: read every block).
+ * 3. Y = sum over p of FDL[p] * IR[p] (complex multiply-accumulate).
+ * 4. Inverse FFT, the last B samples are the output (the first B are aliased).
+ *
+ * process() is a per-sample FIFO adapter for processMasterChain: the block
+ * runs when the FIFO is full. Latency is exactly one partition (B samples).
+ *
+ * IR files (loadFile): WAV PCM 16/24/32-bit or float32, mono or stereo,
+ * or headerless float32 little-endian mono. Kept in RAM only.
+ *
+ * Integration:
+ * 1. Load (audio paused with dsp.isUpdating): conv.load(irL, irR, taps)
+ *    or conv.loadFile(bytes, len)
+ * 2. Per sample: conv.process(l, r)
+ */
+
+#ifndef CONVOLVER_H
+#define CONVOLVER_H
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include "rfft.h"
+
+// ==========================================
+// CONFIGURATION
+// ==========================================
+#define CONV_BLOCK            128     // Partition size B = latency (2.9 ms)
+#define CONV_MAX_TAPS         4096    // Per channel (FDL: 2 x 2 x taps floats internal RAM)
+#define CONV_CYCLE_BUDGET     2700    // Cycles per stereo sample (~50% of a core)
+#define CONV_BENCH_PARTITIONS 16      // Partitions used by the boot benchmark
+
+#define CONV_FFT              (CONV_BLOCK * 2)
+
+class Convolver {
+private:
+    RealFFT fft;
+    int partitions = 0;
+    int taps = 0;
+    bool stereoIR = false;
+
+    // Spectra: [channel][partition][CONV_FFT] packed (see rfft.h)
+    float* irSpec[2] = {nullptr, nullptr};  // PSRAM if present
+    float* fdl[2] = {nullptr, nullptr};     // Internal RAM
+    int fdlHead = 0;
+
+    // Time domain
+    float overlap[2][CONV_FFT];             // [previous B | current B]
+    float work[CONV_FFT];
+    float acc[CONV_FFT];
+    float inBuf[2][CONV_BLOCK];
+    float outBuf[2][CONV_BLOCK];
+    int fill = 0;
+
+    int tapLimit = CONV_MAX_TAPS;           // Lowered by the boot benchmark
+    bool truncated = false;
+
+public:
+    bool enabled = false;
+
+    ~Convolver() { clear(); }
+
+    // irR == nullptr: the same IR for both channels (stored once).
+    // Call with the audio paused. Returns false on bad size / no memory.
+    bool load(const float* irL, const float* irR, int numTaps) {
+        clear();
+        if (!irL || numTaps <= 0) return false;
+        truncated = (numTaps > tapLimit);
+        if (truncated) numTaps = tapLimit; // Room correction IRs decay: keep the head
+        if (fft.size() != CONV_FFT && !fft.begin(CONV_FFT)) return false;
+
+        partitions = (numTaps + CONV_BLOCK - 1) / CONV_BLOCK;
+        taps = numTaps;
+        stereoIR = (irR != nullptr);
+        size_t bytes = sizeof(float) * CONV_FFT * partitions;
+
+        // IR spectra: read sequentially once per block -> PSRAM is fine
+        int irCount = stereoIR ? 2 : 1;
+        for (int c = 0; c < irCount; c++) {
+            irSpec[c] = (float*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+            if (!irSpec[c]) irSpec[c] = (float*)heap_caps_malloc(bytes, MALLOC_CAP_8BIT);
+        }
+        if (!stereoIR) irSpec[1] = irSpec[0];
+
+        // FDL: written and read every block -> internal RAM
+        for (int c = 0; c < 2; c++) {
+            fdl[c] = (float*)heap_caps_calloc(CONV_FFT * partitions, sizeof(float),
+                                             MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        }
+        if (!irSpec[0] || !irSpec[1] || !fdl[0] || !fdl[1]) {
+            clear();
+            return false;
+        }
+
+        // Transform the partitions. 2/N undoes the unscaled inverse FFT.
+        const float scale = 2.0f / CONV_FFT;
+        for (int c = 0; c < irCount; c++) {
+            const float* ir = (c == 0) ? irL : irR;
+            for (int p = 0; p < partitions; p++) {
+                float* dst = irSpec[c] + p * CONV_FFT;
+                for (int i = 0; i < CONV_FFT; i++) {
+                    int t = p * CONV_BLOCK + i;
+                    dst[i] = (i < CONV_BLOCK && t < numTaps) ? ir[t] * scale : 0.0f;
+                }
+                fft.forward(dst);
+            }
+        }
+
+        reset();
+        enabled = true;
+        return true;
+    }
+
+    void clear() {
+        enabled = false;
+        if (irSpec[1] && irSpec[1] != irSpec[0]) heap_caps_free(irSpec[1]);
+        if (irSpec[0]) heap_caps_free(irSpec[0]);
+        if (fdl[0]) heap_caps_free(fdl[0]);
+        if (fdl[1]) heap_caps_free(fdl[1]);
+        irSpec[0] = irSpec[1] = fdl[0] = fdl[1] = nullptr;
+        partitions = 0;
+        taps = 0;
+    }
+
+    void reset() {
+        memset(overlap, 0, sizeof(overlap));
+        memset(inBuf, 0, sizeof(inBuf));
+        memset(outBuf, 0, sizeof(outBuf));
+        for (int c = 0; c < 2; c++) {
+            if (fdl[c]) memset(fdl[c], 0, sizeof(float) * CONV_FFT * partitions);
+        }
+        fdlHead = 0;
+        fill = 0;
+    }
+
+    // Taps the CPU can afford (see maxTaps). Applies to the next load.
+    void setTapLimit(int limit) {
+        tapLimit = constrain(limit, CONV_BLOCK, CONV_MAX_TAPS);
+    }
+
+    bool isLoaded() { return partitions > 0; }
+    bool wasTruncated() { return truncated; }
+    int getTapLimit() { return tapLimit; }
+    int getTaps() { return taps; }
+    int getPartitions() { return partitions; }
+    int getLatency() { return CONV_BLOCK; }
+
+    // ==========================================
+    // PROCESS (per sample FIFO, one block every CONV_BLOCK samples)
+    // ==========================================
+    inline void process(float &l, float &r) {
+        inBuf[0][fill] = l;
+        inBuf[1][fill] = r;
+        l = outBuf[0][fill];
+        r = outBuf[1][fill];
+        if (++fill == CONV_BLOCK) {
+            fill = 0;
+            processBlock();
+        }
+    }
+
+    // Synthetic IR (decaying noise) of the given size, for the benchmark
+    bool loadTest(int numPartitions) {
+        int n = numPartitions * CONV_BLOCK;
+        float* ir = (float*)malloc(sizeof(float) * n);
+        if (!ir) return false;
+        for (int i = 0; i < n; i++) ir[i] = (random(-1000, 1000) / 1000.0f) * expf(-4.0f * i / n) * 0.05f;
+        bool ok = load(ir, nullptr, n);
+        free(ir);
+        return ok;
+    }
+
+    // Cost is linear in the partition count: fixed (FFTs) + per partition (MACs).
+    // Returns the taps that fit in 'budget' cycles per stereo sample.
+    static int maxTaps(uint32_t cyclesOne, uint32_t cyclesMany, int many, uint32_t budget) {
+        if (many <= 1 || cyclesMany <= cyclesOne) return 0;
+        float perPartition = (float)(cyclesMany - cyclesOne) / (many - 1);
+        float fixed = cyclesOne - perPartition;
+        if (budget <= fixed) return 0;
+        int p = (int)((budget - fixed) / perPartition);
+        return p * CONV_BLOCK;
+    }
+
+    // ==========================================
+    // FILE LOADING (WAV or raw float32)
+    // ==========================================
+    // Decodes and loads (call with the audio paused). sampleRate: the rate
+    // the DSP runs at, a WAV with another rate is rejected.
+    bool loadFile(const uint8_t* data, size_t len, uint32_t sampleRate = 44100) {
+        const uint8_t* pcm = data;
+        size_t pcmLen = len;
+        int format = 3, bits = 32, channels = 1;
+
+        if (len >= 12 && memcmp(data, "RIFF", 4) == 0 && memcmp(data + 8, "WAVE", 4) == 0) {
+            pcm = nullptr;
+            bool haveFmt = false;
+            size_t pos = 12;
+            while (pos + 8 <= len) {
+                uint32_t size = rd32(data + pos + 4);
+                const uint8_t* body = data + pos + 8;
+                if (size > len - pos - 8) size = len - pos - 8; // Truncated upload / streamed size
+                if (memcmp(data + pos, "fmt ", 4) == 0 && size >= 16) {
+                    format = rd16(body);
+                    channels = rd16(body + 2);
+                    if (rd32(body + 4) != sampleRate) return false;
+                    bits = rd16(body + 14);
+                    if (format == 0xFFFE && size >= 26) format = rd16(body + 24); // WAVE_FORMAT_EXTENSIBLE
+                    haveFmt = true;
+                } else if (memcmp(data + pos, "data", 4) == 0) {
+                    pcm = body;
+                    pcmLen = size;
+                    break;
+                }
+                pos += 8 + size + (size & 1); // Chunks are word aligned
+            }
+            if (!haveFmt || !pcm) return false;
+        }
+
+        if (channels < 1 || channels > 2) return false;
+        if (format == 1 && bits != 16 && bits != 24 && bits != 32) return false;
+        if (format == 3 && bits != 32) return false;
+        if (format != 1 && format != 3) return false;
+
+        int frameBytes = (bits / 8) * channels;
+        int total = pcmLen / frameBytes;
+        if (total <= 0) return false;
+        int frames = (total > tapLimit) ? tapLimit : total; // Only decode what will be used
+
+        float* ir = (float*)heap_caps_malloc(sizeof(float) * frames * channels, MALLOC_CAP_SPIRAM);
+        if (!ir) ir = (float*)malloc(sizeof(float) * frames * channels);
+        if (!ir) return false;
+
+        // Deinterleave to [L...][R...]
+        for (int i = 0; i < frames; i++) {
+            for (int c = 0; c < channels; c++) {
+                const uint8_t* p = pcm + i * frameBytes + c * (bits / 8);
+                float v;
+                if (format == 3) {
+                    uint32_t u = rd32(p);
+                    memcpy(&v, &u, 4);
+                } else if (bits == 16) {
+                    v = (int16_t)rd16(p) * (1.0f / 32768.0f);
+                } else if (bits == 24) {
+                    v = (int32_t)(rd32_24(p) << 8) * (1.0f / 2147483648.0f);
+                } else {
+                    v = (int32_t)rd32(p) * (1.0f / 2147483648.0f);
+                }
+                ir[c * frames + i] = v;
+            }
+        }
+
+        bool ok = load(ir, channels == 2 ? ir + frames : nullptr, frames);
+        free(ir);
+        truncated = (total > frames);
+        return ok;
+    }
+
+private:
+    static uint16_t rd16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+    static uint32_t rd32_24(const uint8_t* p) { return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16); }
+    static uint32_t rd32(const uint8_t* p) { return rd32_24(p) | ((uint32_t)p[3] << 24); }
+
+    void processBlock() {
+        int prev = (fdlHead == 0) ? partitions - 1 : fdlHead - 1;
+        fdlHead = prev; // Newest spectrum goes in front of the previous ones
+
+        for (int c = 0; c < 2; c++) {
+            // 1. Slide the input window: [old B | new B]
+            float* ov = overlap[c];
+            memcpy(ov, ov + CONV_BLOCK, sizeof(float) * CONV_BLOCK);
+            memcpy(ov + CONV_BLOCK, inBuf[c], sizeof(float) * CONV_BLOCK);
+
+            // 2. Spectrum into the FDL
+            float* x = fdl[c] + fdlHead * CONV_FFT;
+            memcpy(x, ov, sizeof(float) * CONV_FFT);
+            fft.forward(x);
+
+            // 3. Multiply-accumulate over all partitions
+            memset(acc, 0, sizeof(acc));
+            const float* h = irSpec[c];
+            int slot = fdlHead;
+            for (int p = 0; p < partitions; p++) {
+                const float* xs = fdl[c] + slot * CONV_FFT;
+                const float* hs = h + p * CONV_FFT;
+                acc[0] += xs[0] * hs[0]; // DC (real)
+                acc[1] += xs[1] * hs[1]; // Nyquist (real)
+                for (int k = 2; k < CONV_FFT; k += 2) {
+                    float xr = xs[k], xi = xs[k + 1];
+                    float hr = hs[k], hi = hs[k + 1];
+                    acc[k]     += xr * hr - xi * hi;
+                    acc[k + 1] += xr * hi + xi * hr;
+                }
+                if (++slot == partitions) slot = 0;
+            }
+
+            // 4. Back to time domain, keep the valid half
+            memcpy(work, acc, sizeof(work));
+            fft.inverse(work);
+            memcpy(outBuf[c], work + CONV_BLOCK, sizeof(float) * CONV_BLOCK);
+        }
+    }
+};
+
+#endif // CONVOLVER_H
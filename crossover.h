@@ -0,0 +1,99 @@
+/*
+ * crossover.h - Linkwitz-Riley Crossover (2.1 / Bi-Amp Output)
+ *
+ * Logic:
+ * 1. High way (tops, I2S0): HP on L/R.
+ * 2. Low way (sub, I2S1): LP on the mono sum (L+R)/2, or on L/R (bi-amp).
+ *    LR4 = two Butterworth sections (Q 0.707), LR2 = one section (Q 0.5).
+ * 3. Per way: trim (cut only) and polarity folded into one multiply.
+ *    The ways run after the limiter: a boost would clip at the safety clamp.
+ *    Alignment delays are per output, see delayline.h.
+ *
+ * LR2 ways are 180 degrees apart at the crossover: the high way is inverted
+ * internally so the acoustic sum is flat; 'invert' flips on top of that.
+ *
+ * Both ways are computed in the same per-sample pass as the master chain.
+ * Requires Biquad: include after its definition (as vintage.h).
+ */
+
+#ifndef CROSSOVER_H
+#define CROSSOVER_H
+
+#include <Arduino.h>
+#include <math.h>
+
+// ==========================================
+// CONFIGURATION
+// ==========================================
+#define XOVER_DEFAULT_FREQ  80.0f   // Hz
+#define XOVER_MIN_FREQ      40.0f
+#define XOVER_MAX_FREQ      5000.0f // Bi-amp woofer/tweeter
+#define XOVER_MAX_TRIM_DB   12.0f   // Way gain range: -12..0 dB
+#define XOVER_CYCLE_BUDGET  200     // CPU cycles per stereo sample (LR4, mono sub)
+
+struct XoverWay {
+    float gainDb = 0.0f;
+    bool invert = false;
+};
+
+class Crossover {
+private:
+    Biquad hp1, hp2, lp1, lp2;
+    float gainHi = 1.0f, gainLo = 1.0f; // Linear, sign = polarity
+    bool lr4 = true;
+
+public:
+    bool enabled = false;   // Output routing: read at boot (I2S1 TX install)
+    bool subMono = true;    // 2.1: mono sub. false: stereo low way (bi-amp)
+    int order = 4;          // 2 or 4 (LR2 / LR4)
+    float freq = XOVER_DEFAULT_FREQ;
+    XoverWay high, low;
+
+    // Recompute coefficients from the public config (call with the audio paused)
+    void apply() {
+        freq = constrain(freq, XOVER_MIN_FREQ, XOVER_MAX_FREQ);
+        lr4 = (order != 2);
+        float q = lr4 ? 0.7071f : 0.5f;
+        hp1.setHighPass(freq, q); hp2.setHighPass(freq, q);
+        lp1.setLowPass(freq, q);  lp2.setLowPass(freq, q);
+
+        high.gainDb = constrain(high.gainDb, -XOVER_MAX_TRIM_DB, 0.0f);
+        low.gainDb = constrain(low.gainDb, -XOVER_MAX_TRIM_DB, 0.0f);
+        bool flipHi = lr4 ? high.invert : !high.invert; // LR2: inverted for a flat sum
+        gainHi = powf(10.0f, high.gainDb / 20.0f) * (flipHi ? -1.0f : 1.0f);
+        gainLo = powf(10.0f, low.gainDb / 20.0f) * (low.invert ? -1.0f : 1.0f);
+        reset();
+    }
+
+    void reset() {
+        hp1.resetState(); hp2.resetState();
+        lp1.resetState(); lp2.resetState();
+    }
+
+    // ==========================================
+    // PROCESS (l/r in: full range, out: high way; lowL/lowR out: low way)
+    // ==========================================
+    inline void process(float &l, float &r, float &lowL, float &lowR) {
+        // 1. Low way
+        if (subMono) {
+            float m = 0.5f * (l + r);
+            lp1.processMono(m);
+            if (lr4) lp2.processMono(m);
+            lowL = lowR = m;
+        } else {
+            lowL = l; lowR = r;
+            lp1.process(lowL, lowR);
+            if (lr4) lp2.process(lowL, lowR);
+        }
+
+        // 2. High way
+        hp1.process(l, r);
+        if (lr4) hp2.process(l, r);
+
+        // 3. Gain + polarity
+        l *= gainHi; r *= gainHi;
+        lowL *= gainLo; lowR *= gainLo;
+    }
+};
+
+#endif // CROSSOVER_H
@@ -0,0 +1,199 @@
+/*
+ * delayline.h - Per-Output Time Alignment (Speaker / Sub Distance)
+ *
+ * Logic:
+ * 1. Each output pair (main L/R, crossover low L/R) has one ring of
+ *    interleaved int32 frames in PSRAM. Size is a power of two: every
+ *    index is masked, never taken modulo.
+ * 2. The block is appended with at most two memcpy (wraparound split).
+ * 3. Read back:
+ *    - both channels same integer delay -> at most two memcpy
+ *    - otherwise per channel with mask indexing
+ *    - fractional delay (only if interpolation is on): 4-tap Lagrange,
+ *      coefficients fixed at configuration time
+ * 4. A channel at 0 is untouched; all at 0 -> the stage is skipped and
+ *    the rings are never allocated.
+ *
+ * Runs on the int32 output blocks, after processMasterChain.
+ */
+
+#ifndef DELAYLINE_H
+#define DELAYLINE_H
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+
+// ==========================================
+// CONFIGURATION
+// ==========================================
+#define DELAY_CHANNELS        4        // Main L, Main R, Low L, Low R
+#define DELAY_MAX_MS          100.0f
+#define DELAY_RING_FRAMES     8192     // PSRAM: 185 ms > max delay + block
+#define DELAY_RING_FALLBACK   1024     // Internal RAM (no PSRAM): 23 ms
+#define DELAY_MAX_BLOCK       128      // Largest block passed to process()
+#define DELAY_SOUND_CM_S      34300.0f // Speed of sound (20 C)
+#define DELAY_FS              44100.0f
+
+enum DelayChannel { DELAY_MAIN_L = 0, DELAY_MAIN_R, DELAY_LOW_L, DELAY_LOW_R };
+
+class DelayPair {
+private:
+    int32_t* ring = nullptr;     // Interleaved L/R frames
+    uint32_t mask = 0;
+    uint32_t wr = 0;             // Frames written (wraps)
+
+    int whole[2] = {0, 0};       // Integer part (samples)
+    bool frac[2] = {false, false};
+    float h[2][4];               // Lagrange taps for delays whole-1 .. whole+2
+
+public:
+    ~DelayPair() { end(); }
+
+    // Allocates on first use. Returns the ring capacity in frames (0 = no memory).
+    uint32_t begin() {
+        if (ring) return mask + 1;
+        uint32_t frames = DELAY_RING_FRAMES;
+        ring = (int32_t*)heap_caps_calloc(frames * 2, sizeof(int32_t), MALLOC_CAP_SPIRAM);
+        if (!ring) {
+            frames = DELAY_RING_FALLBACK;
+            ring = (int32_t*)heap_caps_calloc(frames * 2, sizeof(int32_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        }
+        if (!ring) return 0;
+        mask = frames - 1;
+        wr = 0;
+        return frames;
+    }
+
+    void end() {
+        if (ring) heap_caps_free(ring);
+        ring = nullptr;
+        mask = 0;
+    }
+
+    bool isAllocated() { return ring != nullptr; }
+
+    // Largest usable delay (samples): the block and the interpolator tap must fit
+    int maxDelay() { return ring ? (int)(mask + 1) - DELAY_MAX_BLOCK - 2 : 0; }
+
+    // samples >= 0. interp: keep the fraction (>= 1 sample), else round.
+    void set(int ch, float samples, bool interp) {
+        if (samples < 0.0f) samples = 0.0f;
+        if (samples > maxDelay()) samples = maxDelay();
+        int n = (int)samples;
+        float f = samples - n;
+        if (!interp || n < 1 || f < 0.001f || f > 0.999f) {
+            whole[ch] = (int)(samples + 0.5f);
+            frac[ch] = false;
+            return;
+        }
+        whole[ch] = n;
+        frac[ch] = true;
+        // 3rd order Lagrange, taps at delays n-1, n, n+1, n+2
+        h[ch][0] = -f * (f - 1.0f) * (f - 2.0f) / 6.0f;
+        h[ch][1] = (f + 1.0f) * (f - 1.0f) * (f - 2.0f) / 2.0f;
+        h[ch][2] = -(f + 1.0f) * f * (f - 2.0f) / 2.0f;
+        h[ch][3] = (f + 1.0f) * f * (f - 1.0f) / 6.0f;
+    }
+
+    bool isActive() { return whole[0] || whole[1]; }
+
+    void clear() {
+        if (ring) memset(ring, 0, sizeof(int32_t) * 2 * (mask + 1));
+    }
+
+    // In place, interleaved L/R, frames <= DELAY_MAX_BLOCK
+    void process(int32_t* buf, int frames) {
+        // 1. Append (wraparound-aware)
+        uint32_t pos = wr & mask;
+        copyIn(pos, buf, frames);
+
+        // 2. Same integer delay on both channels: plain block copy
+        if (whole[0] == whole[1] && !frac[0] && !frac[1]) {
+            copyOut((wr - whole[0]) & mask, buf, frames);
+        } else {
+            for (int c = 0; c < 2; c++) {
+                if (!whole[c]) continue;
+                uint32_t rd = wr - whole[c];
+                if (!frac[c]) {
+                    for (int i = 0; i < frames; i++) buf[i * 2 + c] = ring[((rd + i) & mask) * 2 + c];
+                } else {
+                    const float* k = h[c];
+                    for (int i = 0; i < frames; i++) {
+                        uint32_t t = rd + i;
+                        float y = k[0] * ring[((t + 1) & mask) * 2 + c]
+                                + k[1] * ring[(t & mask) * 2 + c]
+                                + k[2] * ring[((t - 1) & mask) * 2 + c]
+                                + k[3] * ring[((t - 2) & mask) * 2 + c];
+                        buf[i * 2 + c] = (int32_t)constrain(y, -2147483520.0f, 2147483520.0f);
+                    }
+                }
+            }
+        }
+        wr += frames;
+    }
+
+private:
+    inline void copyIn(uint32_t pos, const int32_t* src, int frames) {
+        uint32_t first = (mask + 1) - pos;
+        if (first >= (uint32_t)frames) {
+            memcpy(ring + pos * 2, src, frames * 8);
+        } else {
+            memcpy(ring + pos * 2, src, first * 8);
+            memcpy(ring, src + first * 2, (frames - first) * 8);
+        }
+    }
+
+    inline void copyOut(uint32_t pos, int32_t* dst, int frames) {
+        uint32_t first = (mask + 1) - pos;
+        if (first >= (uint32_t)frames) {
+            memcpy(dst, ring + pos * 2, frames * 8);
+        } else {
+            memcpy(dst, ring + pos * 2, first * 8);
+            memcpy(dst + first * 2, ring, (frames - first) * 8);
+        }
+    }
+};
+
+class OutputDelay {
+private:
+    DelayPair pairs[2];          // Main, Low
+    float samples[DELAY_CHANNELS] = {0, 0, 0, 0};
+    bool interp = false;
+
+public:
+    bool active = false;         // Any channel > 0 (read by the audio thread)
+
+    static float cmToSamples(float cm) { return cm * DELAY_FS / DELAY_SOUND_CM_S; }
+    static float samplesToCm(float s) { return s * DELAY_SOUND_CM_S / DELAY_FS; }
+
+    // Call with the audio paused. Allocates the rings on the first non-zero delay.
+    void configure(const float* delaySamples, bool interpolate) {
+        interp = interpolate;
+        float maxSamples = DELAY_MAX_MS * DELAY_FS / 1000.0f;
+        bool any = false;
+        for (int p = 0; p < 2; p++) {
+            float a = constrain(delaySamples[p * 2], 0.0f, maxSamples);
+            float b = constrain(delaySamples[p * 2 + 1], 0.0f, maxSamples);
+            if (a == 0.0f && b == 0.0f) pairs[p].end(); // Unused: give the memory back
+            else if (!pairs[p].begin()) a = b = 0.0f;   // No memory
+            pairs[p].set(0, a, interp);
+            pairs[p].set(1, b, interp);
+            samples[p * 2] = pairs[p].isAllocated() ? fminf(a, pairs[p].maxDelay()) : 0.0f;
+            samples[p * 2 + 1] = pairs[p].isAllocated() ? fminf(b, pairs[p].maxDelay()) : 0.0f;
+            pairs[p].clear();
+            any |= pairs[p].isActive();
+        }
+        active = any;
+    }
+
+    float getSamples(int ch) { return samples[ch]; }
+    bool getInterp() { return interp; }
+
+    // Interleaved int32 blocks; low may be nullptr (crossover off)
+    inline void process(int32_t* main, int32_t* low, int frames) {
+        if (pairs[0].isActive()) pairs[0].process(main, frames);
+        if (low && pairs[1].isActive()) pairs[1].process(low, frames);
+    }
+};
+
+#endif // DELAYLINE_H
@@ -4,6 +4,10 @@
 #include <Arduino.h>
 #include <LiquidCrystal_I2C.h>
 #include <Wire.h>
+#include "lcdframe.h"
+
+// Longest text line handled by the UI (scrolling rows), including null
+#define UI_TEXT_MAX 96
 
 // --- CUSTOM CHARACTERS FOR VU METER ---
 // These create a smooth progress bar effect
@@ -13,17 +17,30 @@ const byte bar3[8] = {0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C};
 const byte bar4[8] = {0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E};
 const byte bar5[8] = {0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F}; // Full Block
 
+// --- CUSTOM CHARACTERS FOR SPECTRUM ROW (vertical, full block = bar5) ---
+const byte col1[8] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F};
+const byte col2[8] = {0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F, 0x1F, 0x1F};
+const byte col3[8] = {0x00, 0x00, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F};
+
+#define UI_SPECTRUM_BANDS    10
+#define UI_SPECTRUM_FLOOR_DB -60.0f // Empty cell below this
+
 class DisplayUI {
 private:
     LiquidCrystal_I2C* lcd;
+    LcdFrameBuffer fb; // Screens draw here, flush() sends only the changes
 
-    // Scrolling State Variables
-    String lastScrollText = "";
+    // Scrolling State Variables (fixed buffer, no heap)
+    char lastScrollText[UI_TEXT_MAX] = {0};
     int scrollPos = 0;
     unsigned long lastScrollTime = 0;
     const int scrollDelay = 400; // Speed of scrolling
     const int rowWidth = 20;
 
+    // Spectrum row (replaces the VU row when enabled)
+    bool spectrumRow = false;
+    uint8_t spectrumLevel[UI_SPECTRUM_BANDS] = {0}; // 0 (empty) .. 4 (full)
+
 public:
     DisplayUI(LiquidCrystal_I2C* _lcd) {
         lcd = _lcd;
@@ -39,54 +56,64 @@ public:
         lcd->createChar(2, (uint8_t*)bar3);
         lcd->createChar(3, (uint8_t*)bar4);
         lcd->createChar(4, (uint8_t*)bar5);
+
+        // Spectrum columns (Indices 5-7)
+        lcd->createChar(5, (uint8_t*)col1);
+        lcd->createChar(6, (uint8_t*)col2);
+        lcd->createChar(7, (uint8_t*)col3);
+
+        lcd->clear();
+        fb.invalidate();
+    }
+
+    // HD44780 bytes sent by the last frame (x LCD_I2C_WRITES_PER_BYTE on I2C)
+    uint16_t getLastFrameBytes() { return fb.lastFrameBytes; }
+    uint32_t getTotalBytes() { return fb.totalBytes; }
+
+    // ==========================================
+    // SPECTRUM ROW
+    // ==========================================
+    void setSpectrumRow(bool enabled) { spectrumRow = enabled; }
+    bool isSpectrumRow() { return spectrumRow; }
+
+    // db: UI_SPECTRUM_BANDS levels in dBFS (EQ band centers). 12 dB per step.
+    void setSpectrum(const float* db) {
+        for (int i = 0; i < UI_SPECTRUM_BANDS; i++) {
+            int lvl = (int)((db[i] - UI_SPECTRUM_FLOOR_DB) * (5.0f / -UI_SPECTRUM_FLOOR_DB));
+            spectrumLevel[i] = constrain(lvl, 0, 4);
+        }
     }
 
     // ==========================================
     // HELPER: STATUS BAR (Top Row)
     // Layout: |SOURCE   LOUD WIDE 30|
     // ==========================================
-    void drawStatusBar(String source, bool loud, bool wide, int vol) {
-        lcd->setCursor(0, 0);
-
-        // 1. Source (Left, padded to 8 chars)
-        String s = source;
-        while(s.length() < 8) s += " ";
-        lcd->print(s);
-
-        // 2. Indicators (Middle)
-        if(loud) lcd->print("L "); else lcd->print("  "); // Tiny L indicator or full LOUD if space permits
-        if(wide) lcd->print("W "); else lcd->print("  ");
-
-        // 3. Volume (Right justified)
-        lcd->setCursor(17, 0);
-        if(vol < 10) lcd->print(" ");
-        lcd->print(vol);
-
-        // Note: Modified slightly to fit 20 chars: "AUX     L W    30"
-        // To match your exact "LOUD WIDE" mockup, source name must be short.
-        // Revised based on mockup:
-        lcd->setCursor(0,0);
-        lcd->print(source.substring(0, 7)); // Cap source len
-        lcd->setCursor(8, 0);
-        lcd->print(loud ? "LOUD" : "    ");
-        lcd->setCursor(13, 0);
-        lcd->print(wide ? "WIDE" : "    ");
-        lcd->setCursor(18, 0);
-        if(vol < 10) lcd->print("0");
-        lcd->print(vol);
+    void drawStatusBar(TextSpan source, bool loud, bool wide, int vol) {
+        // Source name must be short to match the "LOUD WIDE" mockup
+        fb.setCursor(0,0);
+        fb.print(source.sub(0, 7)); // Cap source len
+        fb.setCursor(8, 0);
+        fb.print(loud ? "LOUD" : "    ");
+        fb.setCursor(13, 0);
+        fb.print(wide ? "WIDE" : "    ");
+        fb.setCursor(18, 0);
+        if(vol < 10) fb.print("0");
+        fb.print(vol);
     }
 
     // ==========================================
     // HELPER: VU METER (Bottom Row)
     // Layout: |   ||||| LR |||||   |
     // ==========================================
-    void drawVUMeter(int leftVal, int rightVal, String centerText = "LR") {
+    void drawVUMeter(int leftVal, int rightVal, const char* centerText = "LR") {
+        if (spectrumRow) { drawSpectrumRow(3); return; }
+
         // Map 0-100 input to 0-25 (5 chars * 5 segments)
         int lMap = map(leftVal, 0, 100, 0, 25);
         int rMap = map(rightVal, 0, 100, 0, 25);
 
-        lcd->setCursor(0, 3);
-        lcd->print("   "); // Padding
+        fb.setCursor(0, 3);
+        fb.print("   "); // Padding
 
         // Draw Left Bar (Reverse direction is tricky on LCD, drawing standard L->R)
         // Ideally Left bar grows Right-to-Left, but L->R is standard.
@@ -96,115 +123,134 @@ public:
         // LEFT CHANNEL (5 Chars)
         for(int i=0; i<5; i++) {
             int segs = lMap - (i*5);
-            if(segs >= 5) lcd->write(4);      // Full block
-            else if(segs > 0) lcd->write(segs-1); // Partial
-            else lcd->print(" ");             // Empty
+            if(segs >= 5) fb.write(4);      // Full block
+            else if(segs > 0) fb.write(segs-1); // Partial
+            else fb.print(" ");             // Empty
         }
 
-        lcd->print(" ");
-        lcd->print(centerText); // "LR" or "ST" or "MO"
-        lcd->print(" ");
+        fb.print(" ");
+        fb.print(centerText); // "LR" or "ST" or "MO"
+        fb.print(" ");
 
         // RIGHT CHANNEL (5 Chars)
         for(int i=0; i<5; i++) {
             int segs = rMap - (i*5);
-            if(segs >= 5) lcd->write(4);
-            else if(segs > 0) lcd->write(segs-1);
-            else lcd->print(" ");
+            if(segs >= 5) fb.write(4);
+            else if(segs > 0) fb.write(segs-1);
+            else fb.print(" ");
         }
 
-        lcd->print("   ");
+        fb.print("   ");
     }
 
     // ==========================================
-    // HELPER: SCROLLING TEXT
+    // HELPER: SPECTRUM (Bottom Row)
+    // Layout: 10 bands x 2 columns, 32 Hz .. 16 kHz
     // ==========================================
-    void drawScrollingText(int row, String text) {
-        // Only update if text changed
-        if (text != lastScrollText) {
-            lastScrollText = text;
-            scrollPos = 0;
-            lcd->setCursor(0, row);
-            String displayTxt = text;
-            while(displayTxt.length() < 20) displayTxt += " "; // Pad
-            lcd->print(displayTxt.substring(0, 20));
-            return;
+    void drawSpectrumRow(int row) {
+        // Level -> char: empty, 1/4, 1/2, 3/4 (5-7), full (4)
+        static const uint8_t glyph[5] = {' ', 5, 6, 7, 4};
+        fb.setCursor(0, row);
+        for (int i = 0; i < UI_SPECTRUM_BANDS; i++) {
+            fb.write(glyph[spectrumLevel[i]]);
+            fb.write(glyph[spectrumLevel[i]]);
         }
+    }
 
-        // If text fits, don't scroll
-        if (text.length() <= 20) {
-             lcd->setCursor(0, row);
-             String displayTxt = text;
-             while(displayTxt.length() < 20) displayTxt += " ";
-             lcd->print(displayTxt);
-             return;
-        }
+    // ==========================================
+    // HELPER: SCROLLING TEXT
+    // ==========================================
+    void drawScrollingText(int row, TextSpan text) {
+        if (text.len > UI_TEXT_MAX - 1) text.len = UI_TEXT_MAX - 1;
 
-        // Timer for scrolling
-        if (millis() - lastScrollTime > scrollDelay) {
+        // Restart from the beginning if text changed
+        if (strncmp(text.ptr, lastScrollText, text.len) != 0 || lastScrollText[text.len] != '\0') {
+            memcpy(lastScrollText, text.ptr, text.len);
+            lastScrollText[text.len] = '\0';
+            scrollPos = 0;
+            lastScrollTime = millis();
+        }
+        // Timer for scrolling (only if text doesn't fit)
+        else if (text.len > rowWidth && millis() - lastScrollTime > scrollDelay) {
             lastScrollTime = millis();
             scrollPos++;
-            if (scrollPos > (text.length() - 20 + 4)) { // +4 pause at end
+            if (scrollPos > (text.len - rowWidth + 4)) { // +4 pause at end
                 scrollPos = 0;
             }
-
-            lcd->setCursor(0, row);
-            int start = scrollPos;
-            if (start < 0) start = 0; // Handle pause at start if implemented
-
-            String slice = text.substring(start);
-            // If slice is shorter than 20 (end of scroll), pad with spaces
-            while(slice.length() < 20) slice += " ";
-            lcd->print(slice.substring(0, 20));
         }
+
+        // Drawn every frame: the framebuffer only sends the cells that moved
+        // If slice is shorter than 20 (end of scroll), it is padded with spaces
+        fb.setCursor(0, row);
+        fb.printField(text.sub(scrollPos), rowWidth);
     }
 
     // ==========================================
     // SCREEN 1: LOADING
     // ==========================================
-    void screenLoading(String version) {
-        lcd->clear();
-        lcd->setCursor(0, 1);
-        lcd->print("    MUSICAL DSP     ");
-        lcd->setCursor(15, 3);
-        lcd->print(version);
+    void screenLoading(const char* version) {
+        fb.clear();
+        fb.setCursor(0, 1);
+        fb.print("    MUSICAL DSP     ");
+        fb.setCursor(15, 3);
+        fb.print(version);
+        fb.flush(lcd);
     }
 
     // ==========================================
     // SCREEN 2: BLUETOOTH
     // ==========================================
-    void screenBT(bool loud, bool wide, int vol, String deviceName, String trackInfo, int vuL, int vuR) {
+    // playState: AVRCP status (0 stop, 1 play, 2 pause), positionMs: 0xFFFFFFFF if unknown
+    void screenBT(bool loud, bool wide, int vol, TextSpan deviceName, TextSpan trackInfo,
+                  uint8_t playState, uint32_t positionMs, int vuL, int vuR) {
+        fb.clear();
         drawStatusBar("BLUE", loud, wide, vol);
 
-        lcd->setCursor(0, 1);
-        if(deviceName.length() > 0) lcd->print(deviceName.substring(0, 20));
-        else lcd->print("Waiting Connection..");
+        // ROW 1: |Pixel        > 12:34|
+        fb.setCursor(0, 1);
+        if(!deviceName.empty()) fb.print(deviceName.sub(0, 13));
+        else fb.print("Waiting Connection..");
+
+        if (!deviceName.empty()) {
+            char status[8];
+            const char* icon = (playState == 1) ? ">" : (playState == 2) ? "=" : " ";
+            if (positionMs != 0xFFFFFFFF) {
+                uint32_t sec = positionMs / 1000;
+                snprintf(status, sizeof(status), "%s%3lu:%02lu", icon,
+                         (unsigned long)((sec / 60) % 1000), (unsigned long)(sec % 60));
+            } else {
+                snprintf(status, sizeof(status), "%s", icon);
+            }
+            fb.setCursor(LCD_COLS - strlen(status), 1);
+            fb.print(status);
+        }
 
         drawScrollingText(2, trackInfo);
 
         drawVUMeter(vuL, vuR, "LR");
+        fb.flush(lcd);
     }
 
     // ==========================================
     // SCREEN 3: RADIO
     // ==========================================
-    void screenRadio(bool loud, bool wide, int vol, float freq, int memIdx, String rdsName, String signalInfo, bool stereo, int vuL, int vuR) {
+    void screenRadio(bool loud, bool wide, int vol, float freq, int memIdx, TextSpan rdsName, TextSpan signalInfo, bool stereo, int vuL, int vuR) {
+        fb.clear();
         drawStatusBar("RADIO", loud, wide, vol);
 
         // ROW 1: |108.80 M1 VIRGIN 70S|
-        lcd->setCursor(0, 1);
-        lcd->print(freq, 2);
+        fb.setCursor(0, 1);
+        fb.print(freq, 2);
 
-        lcd->setCursor(7, 1);
+        fb.setCursor(7, 1);
         if(memIdx > 0) {
-            lcd->print("M"); lcd->print(memIdx);
+            fb.print("M"); fb.print(memIdx);
         } else {
-            lcd->print("  ");
+            fb.print("  ");
         }
 
-        lcd->setCursor(10, 1);
-        if(rdsName.length() > 10) lcd->print(rdsName.substring(0, 10)); // Clip RDS name on this line
-        else lcd->print(rdsName);
+        fb.setCursor(10, 1);
+        fb.print(rdsName.sub(0, 10)); // Clip RDS name on this line
 
         // ROW 2: Scrolling or Signal
         // Mockup says: |Queen - Innuendo    | OR Signal
@@ -212,6 +258,7 @@ public:
 
         // ROW 3: VU
         drawVUMeter(vuL, vuR, stereo ? "ST" : "MO");
+        fb.flush(lcd);
     }
 
     // ==========================================
@@ -223,8 +270,9 @@ public:
     // Row 2: |3 NAME     7 NAME    |
     // Row 3: |4 NAME     8 NAME    |
     // ==========================================
-    void screenMemories(String memNames[], int selIdx) {
+    void screenMemories(const char* const memNames[], int selIdx) {
         // No Status bar, No Title. Full grid.
+        fb.clear();
 
         for (int i = 0; i < 8; i++) {
             // Calculate Position
@@ -233,82 +281,74 @@ public:
             int colOffset = (i < 4) ? 0 : 10;
             int rowIdx = (i % 4);
 
-            lcd->setCursor(colOffset, rowIdx);
+            fb.setCursor(colOffset, rowIdx);
 
             // 1. Draw Index Number (1-8)
-            lcd->print(i + 1);
+            fb.print(i + 1);
 
             // 2. Draw Cursor ">" or Space
             // selIdx is 1-based (1-8)
             if ((i + 1) == selIdx) {
-                lcd->print(">");
+                fb.print(">");
             } else {
-                lcd->print(" ");
+                fb.print(" ");
             }
 
             // 3. Draw Name (Max 7 chars to fit in 10-char half-width)
             // Format: "1>NAME..." is 1+1+7 = 9 chars. One space padding at end = 10.
-            String n = memNames[i];
-            if (n.length() == 0) n = "Empty";
+            TextSpan n(memNames[i]);
+            if (n.empty()) n = TextSpan("Empty");
 
-            // Pad or truncate to exactly 7 chars
-            if (n.length() > 7) {
-                n = n.substring(0, 7);
-            }
-
-            lcd->print(n);
-
-            // Ensure column clean-up (padding to fill the 10-char block)
-            // If name was "ABC", we printed "1 ABC", length 5. Need 5 spaces.
-            // Current printed len: 1 (digit) + 1 (cursor) + n.length().
-            int printedLen = 2 + n.length();
-            for(int k=printedLen; k<10; k++) {
-                lcd->print(" ");
-            }
+            // Truncate to 7 chars and pad to fill the 10-char block
+            // (1 digit + 1 cursor + 8 cells)
+            fb.printField(n.sub(0, 7), 8);
         }
+        fb.flush(lcd);
     }
 
     // ==========================================
     // SCREEN 5: AUX
     // ==========================================
     void screenAux(bool loud, bool wide, int vol, bool riaa, int nrMode, bool lowPass, float gain, int vuL, int vuR, bool isTx = false) {
+        fb.clear();
 
         if (isTx) drawStatusBar("AUX-TX", loud, wide, vol);
         else      drawStatusBar("AUX", loud, wide, vol);
 
         // ROW 1: |RIAA            NR-B|
-        lcd->setCursor(0, 1);
-        if(riaa) lcd->print("RIAA");
-        else     lcd->print("    ");
+        fb.setCursor(0, 1);
+        if(riaa) fb.print("RIAA");
+        else     fb.print("    ");
 
         // Justify Right for NR
-        String nrStr = "";
-        if(nrMode == 1) nrStr = "NR-B";
-        else if(nrMode == 2) nrStr = "NR-C";
-        else if(nrMode == 3) nrStr = " DBX";
+        TextSpan nrStr;
+        if(nrMode == 1) nrStr = TextSpan("NR-B");
+        else if(nrMode == 2) nrStr = TextSpan("NR-C");
+        else if(nrMode == 3) nrStr = TextSpan(" DBX");
 
-        lcd->setCursor(20 - nrStr.length(), 1);
-        lcd->print(nrStr);
+        fb.setCursor(20 - nrStr.len, 1);
+        fb.print(nrStr);
 
         // ROW 2: |GAIN 100%    LOWPASS| OR |BLUE OUT   CONNECTED|
-        lcd->setCursor(0, 2);
+        fb.setCursor(0, 2);
         if (isTx) {
-            lcd->print("BLUE OUT   ");
+            fb.print("BLUE OUT   ");
             // TX Status passed in "gain" var or separate? Assuming connected for now based on mockup
-            lcd->print("CONNECTED");
+            fb.print("CONNECTED");
         } else {
-            lcd->print("GAIN ");
-            lcd->print((int)gain); lcd->print("%");
+            fb.print("GAIN ");
+            fb.print((int)gain); fb.print("%");
 
             if(lowPass) {
-                 String lp = "LOWPASS";
-                 lcd->setCursor(20 - lp.length(), 2);
-                 lcd->print(lp);
+                 TextSpan lp("LOWPASS");
+                 fb.setCursor(20 - lp.len, 2);
+                 fb.print(lp);
             }
         }
 
         // ROW 3: VU
         drawVUMeter(vuL, vuR, isTx ? "MO" : "LR"); // TX usually Mono or Joint
+        fb.flush(lcd);
     }
 };
 
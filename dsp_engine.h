@@ -8,6 +8,21 @@
 // --- INCLUDES ---
 #include "loud.h"
 #include "stereoexpander.h"
+#include "limiter.h"
+#include "convolver.h"
+#include "delayline.h"
+
+// --- MASTER VOLUME (0-30 steps, dB taper) ---
+#define VOL_STEPS          30
+#define VOL_MIN_DB         -70.0f  // Step 1 (step 0 = mute)
+#define VOL_KNEE_STEP      10      // Steeper taper below this step
+#define VOL_KNEE_DB        -40.0f
+#define VOL_RAMP_SAMPLES   441     // 10 ms: no zipper noise, no clicks
+
+// --- GRAPHIC EQ (peaking, Q = 1) ---
+#define EQ_BANDS           10
+#define EQ_Q               1.0f
+static const float EQ_FREQS[EQ_BANDS] = {32, 64, 125, 250, 500, 1000, 2000, 4000, 8000, 16000};
 
 // 32-bit audio handling
 struct StereoSample {
@@ -88,6 +103,35 @@ public:
         a1 = (-2 * cosw0) / a0; a2 = (1 - alpha) / a0;
     }
 
+    // Filter Type 5: Low Pass
+    void setLowPass(float cutoffFreq, float Q = 0.707) {
+        float sampleRate = 44100.0;
+        float w0 = 2 * PI * cutoffFreq / sampleRate;
+        float alpha = sin(w0) / (2 * Q);
+        float cosw0 = cos(w0);
+        float a0 = 1 + alpha;
+        b0 = (1 - cosw0) / 2 / a0; b1 = (1 - cosw0) / a0; b2 = (1 - cosw0) / 2 / a0;
+        a1 = (-2 * cosw0) / a0; a2 = (1 - alpha) / a0;
+    }
+
+    // Filter Type 6: All Pass (phase only, for crossover compensation)
+    void setAllPass(float centerFreq, float Q = 0.707) {
+        float sampleRate = 44100.0;
+        float w0 = 2 * PI * centerFreq / sampleRate;
+        float alpha = sin(w0) / (2 * Q);
+        float cosw0 = cos(w0);
+        float a0 = 1 + alpha;
+        b0 = (1 - alpha) / a0; b1 = (-2 * cosw0) / a0; b2 = 1.0f;
+        a1 = (-2 * cosw0) / a0; a2 = (1 - alpha) / a0;
+    }
+
+    // Process Mono Sample (left state only)
+    inline void processMono(float &x) {
+        float out = b0*x + b1*x1_l + b2*x2_l - a1*y1_l - a2*y2_l;
+        x2_l = x1_l; x1_l = x; y2_l = y1_l; y1_l = out;
+        x = out;
+    }
+
     // Process Stereo Sample
     inline void process(float &l, float &r) {
         float out_l = b0*l + b1*x1_l + b2*x2_l - a1*y1_l - a2*y2_l;
@@ -102,6 +146,8 @@ public:
 // --- INCLUDE VINTAGE SUITE ---
 // This must be INCLUDED AFTER Biquad is defined
 #include "vintage.h"
+#include "crossover.h"
+#include "mbcomp.h"
 
 // ==========================================================
 // MAIN DSP ENGINE
@@ -115,7 +161,10 @@ public:
     bool stereoExpand = false;
     bool subsonicFilter = false;
     bool loudnessEnabled = false;
+    bool loudnessLevelMode = false; // Loudness from the listening level (loud.h)
+    bool limiterEnabled = true;
     float outputGain = 1.0;
+    volatile float sourceTrim = 1.0f; // Loudness normalization per source (lufs.h)
 
     // PREAMP MODE (AUX Input)
     // 0 = Flat
@@ -126,13 +175,27 @@ public:
     int preampMode = 0;
 
     // State Tracking
-    float eqGains[10];
+    float eqGains[EQ_BANDS];
+
+    // Master volume (Q31 gain). volTarget is written by any task,
+    // the ramp state only by the audio thread.
+    int32_t volTable[VOL_STEPS + 1];
+    volatile int32_t volTarget = 0;
+    volatile int volStep = 0;
+    int32_t volGain = 0;
+    int32_t rampTarget = 0;
+    int32_t rampStep = 0;
 
     // --- ENGINES ---
     std::vector<Biquad> eqFilters;
     Biquad subsonicFilterBP;
     LoudnessEngine loudL, loudR;
     StereoExpander expander;
+    Limiter limiter;
+    Convolver conv;           // FIR room correction (enabled when an IR is loaded)
+    Crossover xover;          // 2.1 / bi-amp split (low way -> I2S1)
+    MultibandComp mbc;        // 3-band dynamics (small speakers)
+    OutputDelay delays;       // Per-output time alignment (block stage)
 
     // --- VINTAGE ENGINES (From vintage.h) ---
     RIAA_Engine riaa;
@@ -142,10 +205,9 @@ public:
 
     AudioDSP() {
         // 1. Init EQ (10 Bands)
-        float freqs[] = {32, 64, 125, 250, 500, 1000, 2000, 4000, 8000, 16000};
-        for(int i=0; i<10; i++) {
+        for(int i=0; i<EQ_BANDS; i++) {
             Biquad bq;
-            bq.setPeaking(freqs[i], 0, 1.0); // Q=1.0 Musical
+            bq.setPeaking(EQ_FREQS[i], 0, EQ_Q); // Q=1.0 Musical
             eqFilters.push_back(bq);
             eqGains[i] = 0.0;
         }
@@ -158,6 +220,13 @@ public:
         Loudness_Init(&loudR);
         StereoExpander_Init(&expander);
         StereoExpander_SetWidth(&expander, 1.5f);
+        limiter.init(LIMITER_CEILING_DB);
+
+        // 3b. Volume taper: step -> Q31 gain
+        volTable[0] = 0;
+        for (int i = 1; i <= VOL_STEPS; i++) {
+            volTable[i] = (int32_t)(powf(10.0f, volumeDb(i) / 20.0f) * 2147483647.0);
+        }
 
         // 4. Init Vintage Engines
         riaa.init();
@@ -167,58 +236,108 @@ public:
     }
 
     void updateEQBand(int index, float gaindB) {
-        float freqs[] = {32, 64, 125, 250, 500, 1000, 2000, 4000, 8000, 16000};
-        if(index >= 0 && index < 10) {
-            eqFilters[index].setPeaking(freqs[index], gaindB, 1.0);
+        if(index >= 0 && index < EQ_BANDS) {
+            eqFilters[index].setPeaking(EQ_FREQS[index], gaindB, EQ_Q);
             eqGains[index] = gaindB;
             eqFilters[index].resetState(); // Prevent POP
         }
     }
 
     void setVolume(int step) {
+        step = constrain(step, 0, VOL_STEPS);
+        volStep = step;
+        volTarget = volTable[step]; // Audio thread ramps towards it
+
         int dspStep = (step * 100) / 30;
         if (dspStep > 100) dspStep = 100;
         Loudness_SetVolumeStep(&loudL, dspStep);
         Loudness_SetVolumeStep(&loudR, dspStep);
     }
 
+    // Taper: VOL_MIN_DB..VOL_KNEE_DB over steps 1..VOL_KNEE_STEP, then to 0 dB
+    static float volumeDb(int step) {
+        if (step <= 0) return -144.0f;
+        if (step <= VOL_KNEE_STEP) {
+            return VOL_MIN_DB + (VOL_KNEE_DB - VOL_MIN_DB) * (step - 1) / (VOL_KNEE_STEP - 1);
+        }
+        return VOL_KNEE_DB * (VOL_STEPS - step) / (VOL_STEPS - VOL_KNEE_STEP);
+    }
+
+    float getVolumeDb() { return volumeDb(volStep); }
+
+    // Slow control (dB/s), applied as is
+    void setSourceTrim(float db) { sourceTrim = powf(10.0f, db / 20.0f); }
+
+    // Level-mode loudness: listening level = programme loudness (source,
+    // LUFS) + gain + trim + volume, calibrated to phon. Display rate.
+    void setProgramLevel(float lufs) {
+        if (lufs < LOUD_GATE_LUFS) return; // Pause: keep the last level
+        float gainDb = 20.0f * log10f(fmaxf(outputGain * sourceTrim, 1e-5f));
+        float phon = lufs + gainDb + getVolumeDb() + LOUD_CAL_PHON;
+        Loudness_SetLevel(&loudL, phon);
+        Loudness_SetLevel(&loudR, phon);
+    }
+
     // =========================================================
     // PART 1: PREAMP STAGE (AUX INPUT)
     // =========================================================
-    StereoSample processAuxPreamp(StereoSample input) {
-        float l = (float)input.l;
-        float r = (float)input.r;
+    // In place, interleaved int32. Engines run on planar float blocks
+    // (block envelope detection, control-rate gain computers).
+    void processAuxPreampBlock(int32_t* buf, int frames) {
+        if (preampMode == 0) return; // 0 = Line (Flat)
+        float l[ENV_MAX_BLOCK], r[ENV_MAX_BLOCK];
+
+        while (frames > 0) {
+            int n = frames < ENV_MAX_BLOCK ? frames : ENV_MAX_BLOCK;
+            for (int i = 0; i < n; i++) {
+                l[i] = (float)buf[i * 2];
+                r[i] = (float)buf[i * 2 + 1];
+            }
 
-        switch(preampMode) {
-            case 1: riaa.process(l, r); break;   // RIAA
-            case 2: dolbyB.process(l, r); break; // Dolby B
-            case 3: dolbyC.process(l, r); break; // Dolby C
-            case 4: dbx.process(l, r); break;    // DBX
-            default: break; // 0 = Line (Flat)
-        }
+            switch(preampMode) {
+                case 1: riaa.processBlock(l, r, n); break;   // RIAA
+                case 2: dolbyB.processBlock(l, r, n); break; // Dolby B
+                case 3: dolbyC.processBlock(l, r, n); break; // Dolby C
+                case 4: dbx.processBlock(l, r, n); break;    // DBX
+                default: break;
+            }
 
-        return { (int32_t)l, (int32_t)r };
+            for (int i = 0; i < n; i++) {
+                buf[i * 2] = (int32_t)constrain(l[i], -2147483520.0f, 2147483520.0f);
+                buf[i * 2 + 1] = (int32_t)constrain(r[i], -2147483520.0f, 2147483520.0f);
+            }
+            buf += n * 2;
+            frames -= n;
+        }
     }
 
     // =========================================================
     // PART 2: MASTER CHAIN (ALL SOURCES)
     // =========================================================
     inline StereoSample processMasterChain(StereoSample input) {
+        StereoSample low;
+        return processMasterChain(input, low);
+    }
+
+    // low: crossover low way (sub / woofers), silent when the crossover is off
+    inline StereoSample processMasterChain(StereoSample input, StereoSample &low) {
+        low = {0, 0};
         if (isUpdating) return {0, 0};
 
         float l = (float)input.l;
         float r = (float)input.r;
 
-        // 1. Gain
-        l *= outputGain;
-        r *= outputGain;
+        // 1. Gain (user gain x source trim)
+        float gain = outputGain * sourceTrim;
+        l *= gain;
+        r *= gain;
 
         // 2. Subsonic
         if (subsonicFilter) subsonicFilterBP.process(l, r);
 
         // 3. EQ (With Optimization)
         if (eqEnabled) {
-            for(int i=0; i<10; i++) {
+            for(int i=0; i<EQ_BANDS; i++) {
                 // CPU OPTIMIZATION: Skip bands with 0 gain
                 if(fabs(eqGains[i]) > 0.1f) {
                     eqFilters[i].process(l, r);
@@ -226,6 +345,9 @@ public:
             }
         }
 
+        // 3b. Multiband dynamics (bass excursion, after the EQ boosts)
+        if (mbc.enabled) mbc.process(l, r);
+
         // 4. Stereo Expander
         static bool lastExpState = false;
         if (stereoExpand != lastExpState) {
@@ -241,16 +363,61 @@ public:
             Loudness_SetState(&loudR, loudnessEnabled ? 1 : 0);
             lastLoudState = loudnessEnabled;
         }
+        static bool lastLevelMode = false;
+        if (loudnessLevelMode != lastLevelMode) {
+            Loudness_SetLevelMode(&loudL, loudnessLevelMode ? 1 : 0);
+            Loudness_SetLevelMode(&loudR, loudnessLevelMode ? 1 : 0);
+            lastLevelMode = loudnessLevelMode;
+        }
         if (loudnessEnabled) {
             l = Loudness_ProcessSample(&loudL, l);
             r = Loudness_ProcessSample(&loudR, r);
         }
 
-        // 6. Hard Limit
+        // 6. FIR room correction (partitioned convolution, one block latency)
+        if (conv.enabled) conv.process(l, r);
+
+        // 7. Look-ahead true-peak limiter (EQ + loudness boost can exceed 0 dBFS)
+        if (limiterEnabled) limiter.process(l, r);
+
+        // 8. Crossover: high way stays in l/r, low way to the second output
+        float lowL = 0.0f, lowR = 0.0f;
+        if (xover.enabled) xover.process(l, r, lowL, lowR);
+
+        // 9. Safety clip (float -> int32 conversion)
         if (l > 2147000000.0f) l = 2147000000.0f; else if (l < -2147000000.0f) l = -2147000000.0f;
         if (r > 2147000000.0f) r = 2147000000.0f; else if (r < -2147000000.0f) r = -2147000000.0f;
 
-        return { (int32_t)l, (int32_t)r };
+        // 10. Master volume: ramped Q31 gain, 64-bit multiply
+        int32_t tgt = volTarget;
+        if (volGain != tgt) {
+            if (tgt != rampTarget) {
+                rampTarget = tgt;
+                rampStep = (tgt - volGain) / VOL_RAMP_SAMPLES;
+                if (rampStep == 0) rampStep = (tgt > volGain) ? 1 : -1;
+            }
+            volGain += rampStep;
+            if ((rampStep > 0 && volGain > tgt) || (rampStep < 0 && volGain < tgt)) volGain = tgt;
+        }
+
+        if (xover.enabled) {
+            lowL = constrain(lowL, -2147000000.0f, 2147000000.0f);
+            lowR = constrain(lowR, -2147000000.0f, 2147000000.0f);
+            low = { (int32_t)(((int64_t)(int32_t)lowL * volGain) >> 31),
+                    (int32_t)(((int64_t)(int32_t)lowR * volGain) >> 31) };
+        }
+
+        return { (int32_t)(((int64_t)(int32_t)l * volGain) >> 31),
+                 (int32_t)(((int64_t)(int32_t)r * volGain) >> 31) };
+    }
+
+    // =========================================================
+    // PART 3: OUTPUT BLOCK STAGE (after processMasterChain)
+    // =========================================================
+    // main/low: interleaved int32 output blocks (low as from processMasterChain)
+    inline void processOutputBlock(int32_t* main, int32_t* low, int frames) {
+        if (isUpdating || !delays.active) return; // Zero cost without delays
+        delays.process(main, xover.enabled ? low : nullptr, frames);
     }
 };
 
@@ -0,0 +1,138 @@
+/*
+ * dspbench.h - Cycle Benchmark for DSP Stages
+ *
+ * Logic:
+ * 1. A synthetic loud two-tone test buffer is generated once (not timed),
+ *    so dynamic stages (limiter, compressors) run their busy path.
+ * 2. The stage runs over the buffer (per sample, or in DSP_BENCH_BLOCK
+ *    planar blocks), timed with the CPU cycle counter.
+ *    Best of DSP_BENCH_RUNS passes (interrupts only ever add cycles).
+ * 3. The result is compared with the stage's per-sample cycle budget.
+ *
+ * Run at boot, before audio starts. Results: Serial and /api/status.
+ *
+ * Usage:
+ *   bench.run("limiter", LIMITER_CYCLE_BUDGET, [&](float& l, float& r) { lim.process(l, r); });
+ *   bench.runBlock("dbx", DBX_CYCLE_BUDGET, [&](float* l, float* r, int n) { dbx.processBlock(l, r, n); });
+ */
+
+#ifndef DSPBENCH_H
+#define DSPBENCH_H
+
+#include <Arduino.h>
+#include <math.h>
+
+// ==========================================
+// CONFIGURATION
+// ==========================================
+#define DSP_BENCH_FRAMES    512
+#define DSP_BENCH_RUNS      3
+#define DSP_BENCH_MAX       16     // Stages in the report
+#define DSP_BENCH_CPU_HZ    240000000.0f
+#define DSP_BENCH_FS        44100.0f
+#define DSP_BENCH_BLOCK     128    // runBlock(): frames per call
+
+struct BenchEntry {
+    const char* name;
+    uint32_t cyclesPerSample;  // Per stereo sample
+    uint32_t budget;
+};
+
+class DspBench {
+private:
+    BenchEntry entries[DSP_BENCH_MAX];
+    int count = 0;
+
+public:
+    volatile float sink = 0.0f; // Keeps the compiler from removing the work
+
+    // fn(float& l, float& r): one stereo sample, int32-scale floats
+    template <typename Fn>
+    uint32_t run(const char* name, uint32_t budget, Fn fn) {
+        float* buf = (float*)malloc(sizeof(float) * DSP_BENCH_FRAMES * 2);
+        if (!buf) return 0;
+        fillTest(buf, buf + 1, 2);
+
+        uint32_t best = UINT32_MAX;
+        float acc = 0.0f;
+        for (int run = 0; run < DSP_BENCH_RUNS; run++) {
+            uint32_t start = ESP.getCycleCount();
+            for (int i = 0; i < DSP_BENCH_FRAMES; i++) {
+                float l = buf[i * 2];
+                float r = buf[i * 2 + 1];
+                fn(l, r);
+                acc += l + r;
+            }
+            uint32_t cycles = ESP.getCycleCount() - start;
+            if (cycles < best) best = cycles;
+        }
+        sink = acc;
+        free(buf);
+
+        return record(name, budget, best);
+    }
+
+    // fn(float* l, float* r, int n): planar block in place, n <= DSP_BENCH_BLOCK.
+    // The input is restored before each pass (not timed).
+    template <typename Fn>
+    uint32_t runBlock(const char* name, uint32_t budget, Fn fn) {
+        float* src = (float*)malloc(sizeof(float) * DSP_BENCH_FRAMES * 4);
+        if (!src) return 0;
+        float* work = src + DSP_BENCH_FRAMES * 2; // L block, then R block
+        fillTest(src, src + DSP_BENCH_FRAMES, 1);
+
+        uint32_t best = UINT32_MAX;
+        float acc = 0.0f;
+        for (int run = 0; run < DSP_BENCH_RUNS; run++) {
+            memcpy(work, src, sizeof(float) * DSP_BENCH_FRAMES * 2);
+            float* l = work;
+            float* r = work + DSP_BENCH_FRAMES;
+            uint32_t start = ESP.getCycleCount();
+            for (int i = 0; i < DSP_BENCH_FRAMES; i += DSP_BENCH_BLOCK) {
+                fn(l + i, r + i, DSP_BENCH_BLOCK);
+            }
+            uint32_t cycles = ESP.getCycleCount() - start;
+            if (cycles < best) best = cycles;
+            acc += l[DSP_BENCH_FRAMES - 1] + r[DSP_BENCH_FRAMES - 1];
+        }
+        sink = acc;
+        free(src);
+
+        return record(name, budget, best);
+    }
+
+    void print() {
+        for (int i = 0; i < count; i++) {
+            Serial.printf("DSP bench: %-10s %5u cycles/sample (budget %u, %.1f%% CPU) %s\n",
+                          entries[i].name, entries[i].cyclesPerSample, entries[i].budget,
+                          getLoad(i), entries[i].cyclesPerSample <= entries[i].budget ? "OK" : "OVER");
+        }
+    }
+
+    int getCount() { return count; }
+    const BenchEntry& get(int i) { return entries[i]; }
+
+private:
+    // Two tones at +3 dBFS peak: forces limiting/compression
+    void fillTest(float* l, float* r, int stride) {
+        for (int i = 0; i < DSP_BENCH_FRAMES; i++) {
+            float t = (float)i / DSP_BENCH_FS;
+            l[i * stride] = 2147483647.0f * (1.0f * sinf(2.0f * PI * 997.0f * t) + 0.41f * sinf(2.0f * PI * 60.0f * t));
+            r[i * stride] = 2147483647.0f * (0.8f * sinf(2.0f * PI * 1499.0f * t) + 0.61f * sinf(2.0f * PI * 60.0f * t));
+        }
+    }
+
+    uint32_t record(const char* name, uint32_t budget, uint32_t cycles) {
+        uint32_t perSample = cycles / DSP_BENCH_FRAMES;
+        if (count < DSP_BENCH_MAX) entries[count++] = { name, perSample, budget };
+        return perSample;
+    }
+
+public:
+    // Share of one core at 44.1 kHz, in %
+    float getLoad(int i) {
+        return entries[i].cyclesPerSample * DSP_BENCH_FS * 100.0f / DSP_BENCH_CPU_HZ;
+    }
+};
+
+#endif // DSPBENCH_H
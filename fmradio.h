@@ -5,27 +5,93 @@
 #include <Wire.h>
 #include <Preferences.h>
 #include <RDA5807.h> // REQUIRED LIBRARY: "PU2CLR RDA5807" by Ricardo Lima Caratti
+#include "settingstore.h"
+#include "rdsdecoder.h"
+
+// RDS Polling Interval (groups arrive every ~87.6 ms)
+#define RDS_POLL_MS 40
+
+// Memory Slots (1-based in the API)
+#define RADIO_MEM_SLOTS 8
+
+// --- TUNER STATE MACHINE ---
+// Band 87.5-108 MHz, 100 kHz spacing (frequencies in 10 kHz units)
+#define RADIO_BAND_BASE      8700  // Channel 0 of BAND=00 (87-108 MHz) on the RDA5807
+#define RADIO_BAND_MIN       8750  // Seek/scan lower limit
+#define RADIO_BAND_MAX       10800
+#define RADIO_BAND_STEP      10
+#define SEEK_SETTLE_MS       40    // PLL lock + RSSI integration per channel
+#define SEEK_RSSI_MIN        25    // Minimum RSSI to stop on a channel
+#define SCAN_RDS_DWELL_MS    2500  // Max time per station to collect the PS name
+#define SCAN_MAX_STATIONS    32
+
+// RDA5807 direct register access (bypasses the library's blocking tune)
+#define RDA_I2C_SEQ          0x10  // Sequential access: reads start at 0x0A
+#define RDA_I2C_RAND         0x11  // Random access: write reg index + data
+#define RDA_REG03_TUNE       0x0010
+#define RDA_REG0A_RDSR       0x8000
+#define RDA_REG0A_STC        0x4000
+#define RDA_REG0B_FM_TRUE    0x0100
+
+enum TunerState {
+    TUNER_IDLE,
+    TUNER_SEEK,       // Stepping until a station is found
+    TUNER_SCAN,       // Stepping through the whole band
+    TUNER_SCAN_RDS    // Dwelling on each found station for its PS name
+};
 
-// RDS Polling Interval
-#define RDS_POLL_MS 50
+struct StationInfo {
+    uint16_t freq;    // 10 kHz units
+    uint8_t rssi;
+    char ps[9];       // RDS Program Service (8 chars + null)
+};
 
 class RadioManager {
 private:
     RDA5807 rx;
     Preferences prefs;
+    SettingsStore store; // Write-behind cache for "last_freq"
 
     // RDS State
+    RdsDecoder rds;
     char rdsStationName[32]; // Buffer for Station Name
     char rdsText[65];        // Buffer for Radio Text (64 chars + null)
     unsigned long lastRDSPoll = 0;
+    RdsRepeatFilter rdsRepeat; // RDSR may still be set on the next poll
+    uint32_t rdsI2cReads = 0;
 
     // Tuning State
-    bool isSeeking = false;
     float currentFreq = 87.50;
 
+    // Async Tuner (advanced from loop(), never blocks)
+    TunerState tunerState = TUNER_IDLE;
+    unsigned long tunerTimer = 0;
+    uint16_t tunerFreq = 0;    // Channel being measured
+    uint16_t tunerOrigin = 0;  // Where the seek/scan started
+    int8_t tunerDir = 1;
+    uint16_t tunerSteps = 0;   // Guards against endless seeks
+
+    // Band Scan Results (sorted by RSSI after the scan)
+    StationInfo stations[SCAN_MAX_STATIONS];
+    int stationCount = 0;
+    int scanRdsIdx = 0;
+
+    // Memory Table (loaded once from NVS, kept in sync by saveMemory)
+    int memFreq[RADIO_MEM_SLOTS];      // 10 kHz units, 0 = Empty
+    char memLabel[RADIO_MEM_SLOTS][8]; // Preformatted for the UI
+    const char* memLabelPtr[RADIO_MEM_SLOTS];
+
 public:
     bool rdsAvailable = false;
 
+    RadioManager() {
+        for (int i = 0; i < RADIO_MEM_SLOTS; i++) {
+            memFreq[i] = 0;
+            formatMemoryLabel(i);
+            memLabelPtr[i] = memLabel[i];
+        }
+    }
+
     void begin(int sda, int scl) {
         // Init I2C
         Wire.begin(sda, scl);
@@ -39,119 +105,174 @@ public:
 
         // Load Last Frequency
         prefs.begin("radio_mem", false); 
-        int lastF = prefs.getInt("last_freq", 9800); 
+        store.begin(&prefs);
+        int lastF = store.getInt("last_freq", 9800); 
         setFrequency(lastF / 100.0f);
 
+        loadMemoryTable();
+
         // Clear Buffers
         memset(rdsStationName, 0, sizeof(rdsStationName));
         memset(rdsText, 0, sizeof(rdsText));
     }
 
     void stop() {
+        stopTuner();
+        store.flush();
         rx.powerDown();
     }
 
+    // Commit pending tuning state (call before reboot)
+    void flushSettings() {
+        store.flush();
+    }
+
+    uint32_t nvsWritesAvoided() {
+        return store.writesAvoided();
+    }
+
     // --- TUNING ---
 
     void setFrequency(float freq) {
+        stopTuner(); // Manual tune cancels seek/scan
+
         // Save for next boot
-        int fInt = (int)(freq * 100);
-        prefs.putInt("last_freq", fInt);
+        int fInt = (int)(freq * 100 + 0.5f);
+        store.putInt("last_freq", fInt);
 
-        rx.setFrequency((uint16_t)(freq * 100)); 
+        rx.setFrequency((uint16_t)fInt); 
         currentFreq = freq;
         clearRDS();
     }
 
+    // Cached: follows the tuner while seeking, no I2C access
     float getFrequency() {
-        return rx.getFrequency() / 100.0f;
+        return currentFreq;
     }
 
-    void seekUp() {
+    // Non-blocking: the tuner steps in loop()
+    void seekUp()   { startSeek(1); }
+    void seekDown() { startSeek(-1); }
+
+    // Full-band scan: builds the station list (RSSI + PS name)
+    void startScan() {
         clearRDS();
-        rx.seek(RDA_SEEK_WRAP, RDA_SEEK_UP, notifySeek);
-        delay(200); 
-        float newF = getFrequency();
-        prefs.putInt("last_freq", (int)(newF * 100));
+        stationCount = 0;
+        tunerOrigin = (uint16_t)(currentFreq * 100 + 0.5f);
+        rx.setMute(true); // Avoid noise bursts while sweeping
+        tunerState = TUNER_SCAN;
+        tuneChannel(RADIO_BAND_MIN);
     }
 
-    void seekDown() {
-        clearRDS();
-        rx.seek(RDA_SEEK_WRAP, RDA_SEEK_DOWN, notifySeek);
-        delay(200);
-        float newF = getFrequency();
-        prefs.putInt("last_freq", (int)(newF * 100));
+    bool isBusy() { return tunerState != TUNER_IDLE; }
+    bool isScanning() { return tunerState == TUNER_SCAN || tunerState == TUNER_SCAN_RDS; }
+
+    // 0-100 while scanning
+    int getScanProgress() {
+        if (tunerState == TUNER_SCAN) {
+            return (int)((tunerFreq - RADIO_BAND_MIN) * 90L / (RADIO_BAND_MAX - RADIO_BAND_MIN));
+        }
+        if (tunerState == TUNER_SCAN_RDS && stationCount > 0) {
+            return 90 + scanRdsIdx * 10 / stationCount;
+        }
+        return 100;
     }
 
-    // Callback required by library (must be static)
-    static void notifySeek() {}
+    int getStationCount() { return stationCount; }
+    const StationInfo& getStation(int idx) { return stations[idx]; }
 
     // --- MEMORIES ---
 
     void saveMemory(int slot) {
-        if (slot < 1 || slot > 8) return;
+        if (slot < 1 || slot > RADIO_MEM_SLOTS) return;
         char key[8];
         sprintf(key, "mem_%d", slot);
-        int freqInt = (int)(getFrequency() * 100);
+        int freqInt = (int)(getFrequency() * 100 + 0.5f);
         prefs.putInt(key, freqInt);
+
+        // Keep the RAM table in sync
+        memFreq[slot - 1] = freqInt;
+        formatMemoryLabel(slot - 1);
     }
 
     void loadMemory(int slot) {
-        if (slot < 1 || slot > 8) return;
-        char key[8];
-        sprintf(key, "mem_%d", slot);
-        int freqInt = prefs.getInt(key, 0);
+        if (slot < 1 || slot > RADIO_MEM_SLOTS) return;
+        int freqInt = memFreq[slot - 1];
         if (freqInt > 6000) { 
             setFrequency(freqInt / 100.0f);
         }
     }
 
-    String getMemoryLabel(int slot) {
-        char key[8];
-        sprintf(key, "mem_%d", slot);
-        int f = prefs.getInt(key, 0);
-        if (f == 0) return "Empty";
-        return String(f / 100.0f, 2);
+    // Preformatted labels for all slots (RAM only, no NVS access)
+    const char* const* getMemoryLabels() {
+        return memLabelPtr;
     }
 
-    // --- RDS LOOP ---
+    // --- MAIN LOOP (Tuner + RDS) ---
     void loop() {
-        if (millis() - lastRDSPoll > RDS_POLL_MS) {
-            lastRDSPoll = millis();
-
-            if (rx.getRdsReady()) {
-                rdsAvailable = true;
-
-                // [FIX 1] Correct Method for Station Name
-                // Old: getRdsProgramService() -> New: getRdsStationInformation()
-                char* ps = rx.getRdsStationInformation();
-                if (ps && strlen(ps) > 0) {
-                     strncpy(rdsStationName, ps, 31);
-                     rdsStationName[31] = '\0';
-                }
-
-                // [FIX 2] Correct Method for Scrolling Text
-                // Old: getRdsText() -> New: getRdsText0A()
-                char* rt = rx.getRdsText0A();
-                 if (rt && strlen(rt) > 0) {
-                     strncpy(rdsText, rt, 64);
-                     rdsText[64] = '\0';
-                }
-            }
+        store.loop();
+
+        if (tunerState != TUNER_IDLE) {
+            tunerStep();
+            if (tunerState != TUNER_SCAN_RDS) return; // No RDS while sweeping
         }
+
+        pollRDS();
     }
 
-    // Getters for Display
-    String getRDSName() {
-        if (strlen(rdsStationName) > 0) return String(rdsStationName);
-        return "";
+    // --- RDS POLLING ---
+    // One 12-byte burst per poll: status, BLER and blocks A-D (0x0A-0x0F)
+    void pollRDS() {
+        if (millis() - lastRDSPoll < RDS_POLL_MS) return;
+        lastRDSPoll = millis();
+
+        if (Wire.requestFrom((uint8_t)RDA_I2C_SEQ, (uint8_t)12) != 12) return;
+        rdsI2cReads++;
+
+        uint16_t regs[6];
+        for (int i = 0; i < 6; i++) {
+            regs[i] = Wire.read() << 8;
+            regs[i] |= Wire.read();
+        }
+        if (!(regs[0] & RDA_REG0A_RDSR)) return;
+
+        uint16_t* blocks = &regs[2];
+        if (rdsRepeat.isRepeat(blocks, millis())) return;
+
+        // RDA5807M reports BLER for blocks A and B only
+        uint8_t bler[4];
+        bler[0] = (regs[1] >> 2) & 0x03;
+        bler[1] = regs[1] & 0x03;
+        bler[2] = RDS_BLER_UNKNOWN;
+        bler[3] = RDS_BLER_UNKNOWN;
+        rds.feedGroup(blocks, bler);
+
+        // Publish validated text only
+        rdsAvailable = rds.getPI() != 0;
+        strncpy(rdsStationName, rds.getPS(), 31);
+        rdsStationName[31] = '\0';
+        strncpy(rdsText, rds.getRadioText(), 64);
+        rdsText[64] = '\0';
+    }
+
+    // Getters for Display (internal buffers, valid until the next loop())
+    const char* getRDSName() {
+        return rdsStationName;
     }
 
-    String getRDSText() {
-         if (strlen(rdsText) > 0) return String(rdsText);
-         return "";
+    const char* getRDSText() {
+        return rdsText;
     }
 
+    uint8_t getRDSPty() { return rds.getPTY(); }
+    const RdsClock& getRDSClock() { return rds.getClock(); }
+    uint8_t getRDSAFCount() { return rds.getAFCount(); }
+    uint16_t getRDSAF(int idx) { return rds.getAF(idx); }
+
+    // Efficiency: I2C bursts per accepted RDS character
+    uint32_t getRDSReads() { return rdsI2cReads; }
+    uint32_t getRDSChars() { return rds.getStats().acceptedChars; }
+
     int getRSSI() {
         return rx.getRssi(); 
     }
@@ -161,7 +282,165 @@ public:
     }
 
 private:
+    // ==========================================
+    // ASYNC TUNER
+    // ==========================================
+    void startSeek(int8_t dir) {
+        clearRDS();
+        tunerDir = dir;
+        tunerOrigin = (uint16_t)(currentFreq * 100 + 0.5f);
+        tunerSteps = 0;
+        stopTuner(); // Seek during a scan: unmute first
+        tunerState = TUNER_SEEK;
+        tuneChannel(nextChannel(tunerOrigin, dir));
+    }
+
+    // Leave seek/scan. The scan mutes the audio: every way out unmutes.
+    void stopTuner() {
+        if (isScanning()) rx.setMute(false);
+        tunerState = TUNER_IDLE;
+    }
+
+    uint16_t nextChannel(uint16_t f, int8_t dir) {
+        int next = (int)f + dir * RADIO_BAND_STEP;
+        if (next > RADIO_BAND_MAX) next = RADIO_BAND_MIN;
+        if (next < RADIO_BAND_MIN) next = RADIO_BAND_MAX;
+        return (uint16_t)next;
+    }
+
+    // Start tuning (single register write, returns immediately)
+    void tuneChannel(uint16_t f) {
+        uint16_t chan = (f - RADIO_BAND_BASE) / RADIO_BAND_STEP;
+        writeReg(0x03, (uint16_t)((chan << 6) | RDA_REG03_TUNE));
+        tunerFreq = f;
+        currentFreq = f / 100.0f;
+        tunerTimer = millis();
+    }
+
+    // Called from loop(): at most one I2C status read per call
+    void tunerStep() {
+        unsigned long now = millis();
+
+        if (tunerState == TUNER_SCAN_RDS) {
+            // Move on once the PS is in, or the dwell time is over
+            bool psDone = rds.psComplete();
+            if (!psDone && now - tunerTimer < SCAN_RDS_DWELL_MS) return;
+
+            StationInfo& st = stations[scanRdsIdx];
+            strncpy(st.ps, rdsStationName, 8);
+            st.ps[8] = '\0';
+            scanRdsIdx++;
+            nextScanRds();
+            return;
+        }
+
+        if (now - tunerTimer < SEEK_SETTLE_MS) return;
+
+        uint16_t r0a, r0b;
+        if (!readStatus(r0a, r0b)) return;
+        if (!(r0a & RDA_REG0A_STC)) return; // Tune not complete yet, poll again
+
+        uint8_t rssi = r0b >> 9;
+        bool isStation = (r0b & RDA_REG0B_FM_TRUE) && rssi >= SEEK_RSSI_MIN;
+
+        if (tunerState == TUNER_SEEK) {
+            if (isStation) {
+                finishTune(tunerFreq);
+                return;
+            }
+            uint16_t next = nextChannel(tunerFreq, tunerDir);
+            if (next == tunerOrigin || ++tunerSteps > (RADIO_BAND_MAX - RADIO_BAND_MIN) / RADIO_BAND_STEP) {
+                finishTune(tunerOrigin); // Full circle: nothing found
+                return;
+            }
+            tuneChannel(next);
+        }
+        else if (tunerState == TUNER_SCAN) {
+            if (isStation && stationCount < SCAN_MAX_STATIONS) {
+                StationInfo& st = stations[stationCount++];
+                st.freq = tunerFreq;
+                st.rssi = rssi;
+                st.ps[0] = '\0';
+            }
+            if (tunerFreq + RADIO_BAND_STEP > RADIO_BAND_MAX) {
+                scanRdsIdx = 0;
+                tunerState = TUNER_SCAN_RDS;
+                nextScanRds();
+                return;
+            }
+            tuneChannel(tunerFreq + RADIO_BAND_STEP);
+        }
+    }
+
+    // Dwell on the next found station, or wrap up the scan
+    void nextScanRds() {
+        if (scanRdsIdx < stationCount) {
+            clearRDS();
+            tuneChannel(stations[scanRdsIdx].freq);
+            return;
+        }
+
+        // Sort strongest first (insertion sort, list is small)
+        for (int i = 1; i < stationCount; i++) {
+            StationInfo key = stations[i];
+            int j = i - 1;
+            while (j >= 0 && stations[j].rssi < key.rssi) {
+                stations[j + 1] = stations[j];
+                j--;
+            }
+            stations[j + 1] = key;
+        }
+
+        finishTune(tunerOrigin); // Unmutes
+    }
+
+    void finishTune(uint16_t f) {
+        stopTuner();
+        if (f != tunerFreq) tuneChannel(f);
+        clearRDS();
+        store.putInt("last_freq", f);
+    }
+
+    // ==========================================
+    // LOW LEVEL I2C
+    // ==========================================
+    void writeReg(uint8_t reg, uint16_t value) {
+        Wire.beginTransmission(RDA_I2C_RAND);
+        Wire.write(reg);
+        Wire.write(value >> 8);
+        Wire.write(value & 0xFF);
+        Wire.endTransmission();
+    }
+
+    // One burst: status (0x0A) + RSSI/FM_TRUE (0x0B)
+    bool readStatus(uint16_t& r0a, uint16_t& r0b) {
+        if (Wire.requestFrom((uint8_t)RDA_I2C_SEQ, (uint8_t)4) != 4) return false;
+        r0a = Wire.read() << 8;
+        r0a |= Wire.read();
+        r0b = Wire.read() << 8;
+        r0b |= Wire.read();
+        return true;
+    }
+
+    // Read all slots from NVS (once per begin())
+    void loadMemoryTable() {
+        for (int i = 0; i < RADIO_MEM_SLOTS; i++) {
+            char key[8];
+            sprintf(key, "mem_%d", i + 1);
+            memFreq[i] = prefs.getInt(key, 0);
+            formatMemoryLabel(i);
+            memLabelPtr[i] = memLabel[i];
+        }
+    }
+
+    void formatMemoryLabel(int idx) {
+        if (memFreq[idx] == 0) snprintf(memLabel[idx], sizeof(memLabel[idx]), "Empty");
+        else snprintf(memLabel[idx], sizeof(memLabel[idx]), "%.2f", memFreq[idx] / 100.0f);
+    }
+
     void clearRDS() {
+        rds.reset();
+        rdsRepeat.reset();
         memset(rdsStationName, 0, sizeof(rdsStationName));
         memset(rdsText, 0, sizeof(rdsText));
         rdsAvailable = false;
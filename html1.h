@@ -70,6 +70,9 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
       <label class="switch" style="margin-left:20px"><input type="checkbox" id="eqEnable"><span class="slider"></span></label> Enable EQ
       <button style="margin-left:auto" onclick="applyDSP()">Apply & Save</button>
     </div>
+    <div class="row">
+      <label>Limiter GR:</label><span id="limiterGR">0.0 dB</span>
+    </div>
     <div class="slider-container">
       <label>Gain:</label>
       <input type="range" id="mainGain" min="0" max="200" value="100">
@@ -91,7 +94,8 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
         <option value="0">Sine</option>
         <option value="1">White Noise</option>
         <option value="2">Pink Noise</option>
-        <option value="3">Sweep</option>
+        <option value="3">Log Sweep</option>
+        <option value="4">Lin Sweep</option>
       </select>
       <button onclick="applyGen()">Apply</button>
     </div>
@@ -105,11 +109,132 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
     </div>
   </div>
 
+  <div class="section">
+    <h2>4. FM Radio</h2>
+    <div class="row">
+      <button onclick="startScan()">Scan Band</button>
+      <span id="scanState" style="margin-left:10px"></span>
+    </div>
+    <div id="stationList"></div>
+  </div>
+
+  <div class="section">
+    <h2>5. Spectrum</h2>
+    <div class="row">
+      <label class="switch"><input type="checkbox" id="specLive" onchange="pollSpectrum()"><span class="slider"></span></label> Live
+      <select id="specBands" style="margin-left: 10px;">
+        <option value="10">10 Bands (EQ)</option>
+        <option value="31">31 Bands (1/3 Oct)</option>
+      </select>
+      <label class="switch" style="margin-left:20px"><input type="checkbox" id="specLcd" onchange="sendData('/api/spectrum', {lcd: this.checked})"><span class="slider"></span></label> LCD Row
+    </div>
+    <canvas id="specCanvas" width="600" height="150" style="width:100%; border:1px solid #000;"></canvas>
+  </div>
+
+  <div class="section">
+    <h2>6. Crossover (2.1 / Bi-Amp)</h2>
+    <div class="row">
+      <label class="switch"><input type="checkbox" id="xoEnable"><span class="slider"></span></label> Enable (reboot)
+      <label class="switch" style="margin-left:20px"><input type="checkbox" id="xoMono"><span class="slider"></span></label> Mono Sub
+      <select id="xoOrder" style="margin-left: 10px;">
+        <option value="2">LR2 (12 dB/oct)</option>
+        <option value="4">LR4 (24 dB/oct)</option>
+      </select>
+      <label>Freq (Hz):</label><input type="number" id="xoFreq" value="80">
+    </div>
+    <div class="row">
+      <label>Tops dB:</label><input type="number" id="xoHiGain" value="0" min="-12" max="0" step="0.5">
+      <label class="switch"><input type="checkbox" id="xoHiInv"><span class="slider"></span></label> Invert
+    </div>
+    <div class="row">
+      <label>Sub dB:</label><input type="number" id="xoLoGain" value="0" min="-12" max="0" step="0.5">
+      <label class="switch"><input type="checkbox" id="xoLoInv"><span class="slider"></span></label> Invert
+      <button style="margin-left:auto" onclick="applyXover()">Apply & Save</button>
+    </div>
+  </div>
+
+  <div class="section">
+    <h2>7. Time Alignment</h2>
+    <div class="row">
+      <label>Left (cm):</label><input type="number" id="dlyML" value="0" step="0.1">
+      <label>Right (cm):</label><input type="number" id="dlyMR" value="0" step="0.1">
+    </div>
+    <div class="row">
+      <label>Sub L (cm):</label><input type="number" id="dlyLL" value="0" step="0.1">
+      <label>Sub R (cm):</label><input type="number" id="dlyLR" value="0" step="0.1">
+    </div>
+    <div class="row">
+      <label class="switch"><input type="checkbox" id="dlyInterp"><span class="slider"></span></label> Fractional
+      <button style="margin-left:auto" onclick="applyDelay()">Apply & Save</button>
+    </div>
+  </div>
+
+  <div class="section">
+    <h2>8. Room Correction (FIR)</h2>
+    <div class="row">
+      <input type="file" id="irFile" accept=".wav,.bin,.raw">
+      <button onclick="uploadIR()">Load IR</button>
+      <button onclick="clearIR()">Clear</button>
+    </div>
+    <div class="row">
+      <label>IR:</label><span id="irState">-</span>
+    </div>
+  </div>
+
+  <div class="section">
+    <h2>9. Measurement</h2>
+    <div class="row">
+      <button onclick="startMeasure()">Measure (AUX mic)</button>
+      <span id="measState" style="margin-left:10px">-</span>
+      <a id="measIR" href="/api/measure/ir" style="margin-left:auto; display:none">Download IR</a>
+    </div>
+    <canvas id="measCanvas" width="600" height="150" style="width:100%; border:1px solid #000;"></canvas>
+    <div class="row">
+      <label>Auto EQ (Hz):</label><input type="number" id="aeqLo" value="40"><input type="number" id="aeqHi" value="16000">
+      <label>Tilt dB/oct:</label><input type="number" id="aeqTilt" value="0" step="0.1">
+      <label>Max boost dB:</label><input type="number" id="aeqBoost" value="6">
+    </div>
+    <div class="row">
+      <button onclick="startAutoEQ()">Fit EQ</button>
+      <span id="aeqState" style="margin-left:10px">-</span>
+      <button style="margin-left:auto" onclick="applyAutoEQ()">Save to Preset & Apply</button>
+    </div>
+  </div>
+
+  <div class="section">
+    <h2>10. Loudness</h2>
+    <div class="row">
+      <label class="switch"><input type="checkbox" id="lufsOn"><span class="slider"></span></label> Per-source trim
+      <label style="margin-left:20px">Target (LUFS):</label><input type="number" id="lufsTarget" value="-18">
+      <button style="margin-left:auto" onclick="applyLufs()">Apply & Save</button>
+    </div>
+    <div class="row">
+      <label>M / S / I:</label><span id="lufsRead">-</span>
+      <label style="margin-left:20px">Trim:</label><span id="lufsTrim">-</span>
+    </div>
+    <div class="row">
+      <label class="switch"><input type="checkbox" id="loudLevel"><span class="slider"></span></label> Loudness follows listening level (ISO 226)
+    </div>
+  </div>
+
+  <div class="section">
+    <h2>11. Multiband Dynamics</h2>
+    <div class="row">
+      <label class="switch"><input type="checkbox" id="mbcOn"><span class="slider"></span></label> Enable
+      <label style="margin-left:20px">Low / Mid (Hz):</label><input type="number" id="mbcFLow" value="150">
+      <label>Mid / High (Hz):</label><input type="number" id="mbcFHigh" value="2500">
+    </div>
+    <div id="mbcBands"></div>
+    <div class="row">
+      <button style="margin-left:auto" onclick="applyMbc()">Apply & Save</button>
+    </div>
+  </div>
+
 <script>
   const freqs = [32, 64, 125, 250, 500, 1000, 2000, 4000, 8000, 16000];
   let html = '<div style="display:flex; justify-content:space-between;">';
   freqs.forEach((f, i) => {
-    html += `<div class="eq-band"><input type="range" orient="vertical" id="eq${i}" min="-12" max="12" value="0" style="-webkit-appearance: slider-vertical; height: 100px;"><span>${f}</span></div>`;
+    html += `<div class="eq-band"><input type="range" orient="vertical" id="eq${i}" min="-12" max="12" step="0.5" value="0" style="-webkit-appearance: slider-vertical; height: 100px;"><span>${f}</span></div>`;
   });
   html += '</div>';
   document.getElementById('eqBands').innerHTML = html;
@@ -181,6 +306,209 @@ function loadPreset() {
       .catch(e => alert("Preset empty or load error"));
   }
 
+  function startScan() {
+    fetch('/api/scan', { method: 'POST' }).then(res => {
+      if(!res.ok) { document.getElementById('scanState').innerText = 'Radio not active'; return; }
+      pollScan();
+    });
+  }
+
+  function pollScan() {
+    fetch('/api/scan').then(res => res.json()).then(data => {
+      document.getElementById('scanState').innerText = data.busy ? ('Scanning ' + data.progress + '%') : (data.stations.length + ' stations');
+      let html = '';
+      data.stations.forEach(st => { html += `<div>${st.f.toFixed(2)} MHz &nbsp; RSSI ${st.rssi} &nbsp; ${st.ps}</div>`; });
+      document.getElementById('stationList').innerHTML = html;
+      if(data.busy) setTimeout(pollScan, 1000);
+    });
+  }
+
+  function pollSpectrum() {
+    if(!document.getElementById('specLive').checked) return;
+    fetch('/api/spectrum?bands=' + document.getElementById('specBands').value).then(res => res.json()).then(data => {
+      const c = document.getElementById('specCanvas'), g = c.getContext('2d');
+      g.clearRect(0, 0, c.width, c.height);
+      const w = c.width / data.db.length;
+      data.db.forEach((db, i) => {
+        const h = Math.max(0, (db + 80) / 80) * (c.height - 15);
+        g.fillStyle = '#000';
+        g.fillRect(i * w + 1, c.height - 15 - h, w - 2, h);
+        if(data.db.length <= 10) g.fillText(data.freqs[i], i * w + 2, c.height - 3);
+      });
+      document.getElementById('specLcd').checked = data.lcd;
+      setTimeout(pollSpectrum, 150);
+    });
+  }
+
+  function showXover(d) {
+    const v = (id, x) => document.getElementById(id).value = x;
+    const c = (id, x) => document.getElementById(id).checked = x;
+    c('xoEnable', d.enabled); c('xoMono', d.mono); v('xoOrder', d.order); v('xoFreq', d.freq);
+    v('xoHiGain', d.high.gain); c('xoHiInv', d.high.invert);
+    v('xoLoGain', d.low.gain); c('xoLoInv', d.low.invert);
+  }
+
+  function applyXover() {
+    const num = id => parseFloat(document.getElementById(id).value);
+    const chk = id => document.getElementById(id).checked;
+    sendData('/api/xover', {
+      enabled: chk('xoEnable'), mono: chk('xoMono'), order: num('xoOrder'), freq: num('xoFreq'),
+      high: { gain: num('xoHiGain'), invert: chk('xoHiInv') },
+      low: { gain: num('xoLoGain'), invert: chk('xoLoInv') }
+    });
+  }
+  fetch('/api/xover').then(res => res.json()).then(showXover);
+
+  const dlyIds = ['dlyML', 'dlyMR', 'dlyLL', 'dlyLR'];
+  function applyDelay() {
+    sendData('/api/delay', {
+      unit: 'cm',
+      interp: document.getElementById('dlyInterp').checked,
+      delays: dlyIds.map(id => parseFloat(document.getElementById(id).value) || 0)
+    });
+  }
+  fetch('/api/delay').then(res => res.json()).then(d => {
+    dlyIds.forEach((id, i) => document.getElementById(id).value = d.cm[i]);
+    document.getElementById('dlyInterp').checked = d.interp;
+  });
+
+  function showIR(data) {
+    document.getElementById('irState').innerText = data.loaded
+      ? (data.taps + ' taps, ' + data.partitions + ' partitions, ' + data.latency + ' samples latency' + (data.truncated ? ' (truncated)' : ''))
+      : ('None (max ' + data.maxTaps + ' taps)');
+  }
+
+  function uploadIR() {
+    const f = document.getElementById('irFile').files[0];
+    if(!f) return;
+    const form = new FormData();
+    form.append('ir', f);
+    fetch('/api/ir', { method: 'POST', body: form }).then(res => {
+      if(!res.ok) { res.text().then(t => alert(t)); return; }
+      res.json().then(showIR);
+    });
+  }
+
+  function clearIR() {
+    fetch('/api/ir', { method: 'DELETE' }).then(res => res.json()).then(showIR);
+  }
+  fetch('/api/ir').then(res => res.json()).then(showIR);
+
+  function startMeasure() {
+    fetch('/api/measure', { method: 'POST' }).then(res => {
+      if(!res.ok) { res.text().then(t => document.getElementById('measState').innerText = t); return; }
+      pollMeasure();
+    });
+  }
+
+  function pollMeasure() {
+    fetch('/api/measure').then(res => res.json()).then(data => {
+      const busy = !['idle', 'done', 'error'].includes(data.state);
+      let txt = data.state + (busy ? ' ' + data.progress + '%' : '');
+      if(data.state == 'done') txt = data.db ? ('Latency ' + data.latencyMs.toFixed(2) + ' ms, peak ' + data.peakDb + ' dB') : 'No signal';
+      document.getElementById('measState').innerText = txt;
+      document.getElementById('measIR').style.display = data.db ? 'inline' : 'none';
+      if(data.db) {
+        // Response (black, +/-24 dB) and THD (grey, 0..10 %) on a log axis
+        const c = document.getElementById('measCanvas'), g = c.getContext('2d');
+        g.clearRect(0, 0, c.width, c.height);
+        const x = f => Math.log(f / 20) / Math.log(1000) * c.width;
+        const y = db => c.height / 2 - db / 24 * (c.height / 2);
+        g.strokeStyle = '#ccc'; g.beginPath(); g.moveTo(0, y(0)); g.lineTo(c.width, y(0)); g.stroke();
+        const plot = (vals, ys, col) => {
+          g.strokeStyle = col; g.beginPath();
+          vals.forEach((v, i) => i ? g.lineTo(x(data.freqs[i]), ys(v)) : g.moveTo(x(data.freqs[i]), ys(v)));
+          g.stroke();
+        };
+        plot(data.db, y, '#000');
+        plot(data.thd, t => c.height - Math.min(t, 10) / 10 * c.height, '#999');
+      }
+      if(busy) setTimeout(pollMeasure, 500);
+    });
+  }
+  pollMeasure();
+
+  function startAutoEQ() {
+    const num = id => parseFloat(document.getElementById(id).value);
+    fetch('/api/autoeq', { method: 'POST', body: JSON.stringify({ fLo: num('aeqLo'), fHi: num('aeqHi'), tilt: num('aeqTilt'), boost: num('aeqBoost') }) })
+    .then(res => {
+      if(!res.ok) { res.text().then(t => document.getElementById('aeqState').innerText = t); return; }
+      pollAutoEQ();
+    });
+  }
+
+  function pollAutoEQ() {
+    fetch('/api/autoeq').then(res => res.json()).then(data => {
+      document.getElementById('aeqState').innerText = data.state == 'done'
+        ? ('RMS ' + data.errBefore + ' -> ' + data.errAfter + ' dB: ' + data.eq.join(' '))
+        : (data.state + ' (' + data.iter + ')');
+      if(data.state == 'running') setTimeout(pollAutoEQ, 300);
+    });
+  }
+
+  // Stored in the selected preset (section 2), then shown on the sliders
+  function applyAutoEQ() {
+    const idx = document.getElementById('presetSelect').value;
+    fetch('/api/autoeq', { method: 'POST', body: JSON.stringify({ apply: parseInt(idx) }) })
+    .then(res => { if(res.ok) loadPreset(); else res.text().then(t => alert(t)); });
+  }
+
+  function applyLufs() {
+    sendData('/api/lufs', { enabled: document.getElementById('lufsOn').checked,
+                            target: parseFloat(document.getElementById('lufsTarget').value),
+                            loudLevel: document.getElementById('loudLevel').checked });
+  }
+
+  function pollLufs(first) {
+    fetch('/api/lufs').then(res => res.json()).then(d => {
+      document.getElementById('lufsRead').innerText = d.momentary + ' / ' + d.shortTerm + ' / ' + d.integrated + ' LUFS';
+      document.getElementById('lufsTrim').innerText = (d.trim > 0 ? '+' : '') + d.trim + ' dB' + (d.enabled ? '' : ' (off)');
+      if(first) {
+        document.getElementById('lufsOn').checked = d.enabled;
+        document.getElementById('lufsTarget').value = d.target;
+        document.getElementById('loudLevel').checked = d.loudLevel;
+      }
+    }).finally(() => setTimeout(pollLufs, 1000));
+  }
+  pollLufs(true);
+
+  // Per band: threshold (dBFS), ratio, attack/release (ms), makeup (dB), expander threshold (dBFS)
+  const mbcNames = ['Low', 'Mid', 'High'];
+  const mbcKeys = ['thresh', 'ratio', 'attack', 'release', 'makeup', 'exp'];
+  const mbcLabels = ['Thr', 'Ratio', 'Att', 'Rel', 'Makeup', 'Exp'];
+  document.getElementById('mbcBands').innerHTML = mbcNames.map((n, b) =>
+    `<div class="row"><label>${n}:</label>` +
+    mbcKeys.map((k, i) => `<label>${mbcLabels[i]}</label><input type="number" id="mbc${b}${k}" step="0.5" style="width:55px">`).join('') +
+    `<label>GR:</label><span id="mbcGr${b}">-</span></div>`).join('');
+
+  function applyMbc() {
+    const num = id => parseFloat(document.getElementById(id).value);
+    sendData('/api/mbc', {
+      enabled: document.getElementById('mbcOn').checked, fLow: num('mbcFLow'), fHigh: num('mbcFHigh'),
+      bands: mbcNames.map((n, b) => Object.fromEntries(mbcKeys.map(k => [k, num('mbc' + b + k)])))
+    });
+  }
+
+  function pollMbc(first) {
+    fetch('/api/mbc').then(res => res.json()).then(d => {
+      d.gr.forEach((g, b) => document.getElementById('mbcGr' + b).innerText = g.toFixed(1) + ' dB');
+      if(first) {
+        document.getElementById('mbcOn').checked = d.enabled;
+        document.getElementById('mbcFLow').value = d.fLow;
+        document.getElementById('mbcFHigh').value = d.fHigh;
+        d.bands.forEach((p, b) => mbcKeys.forEach(k => document.getElementById('mbc' + b + k).value = p[k]));
+      }
+    }).finally(() => setTimeout(pollMbc, 1000));
+  }
+  pollMbc(true);
+
+  function pollStatus() {
+    fetch('/api/status').then(res => res.json()).then(data => {
+      document.getElementById('limiterGR').innerText = data.limiterGR.toFixed(1) + ' dB';
+    }).finally(() => setTimeout(pollStatus, 1000));
+  }
+  pollStatus();
+
   function savePreset() {
       let idx = document.getElementById('presetSelect').value;
 
@@ -0,0 +1,166 @@
+/*
+ * lcdframe.h - Shadow Framebuffer for HD44780 Character LCDs (I2C Backpack)
+ *
+ * Logic:
+ * 1. The UI draws into a RAM "back" buffer (same API as LiquidCrystal).
+ * 2. flush() diffs it against the "front" buffer (what is on the glass).
+ * 3. Only changed cells are sent, coalesced into runs so the LCD's
+ *    auto-increment saves the setCursor() commands.
+ *
+ * Each HD44780 byte costs LCD_I2C_WRITES_PER_BYTE transactions on the I2C
+ * bus (shared with the RDA5807), so an unchanged frame costs nothing.
+ */
+
+#ifndef LCDFRAME_H
+#define LCDFRAME_H
+
+#include <Arduino.h>
+#include <LiquidCrystal_I2C.h>
+
+// ==========================================
+// CONFIGURATION
+// ==========================================
+#define LCD_COLS                 20
+#define LCD_ROWS                 4
+
+// Unchanged cells inside a run cost 1 byte each, a new setCursor() costs 1.
+// Gaps up to this length are re-sent instead of repositioning.
+#define LCD_RUN_MERGE_GAP        1
+
+// PCF8574 4-bit mode: 2 nibbles x (data, E high, E low)
+#define LCD_I2C_WRITES_PER_BYTE  6
+
+// ==========================================
+// TEXT SPAN (string_view style, no heap)
+// ==========================================
+// Non-owning view of a character range. Slicing never copies.
+struct TextSpan {
+    const char* ptr;
+    uint16_t len;
+
+    TextSpan() : ptr(""), len(0) {}
+    TextSpan(const char* s) : ptr(s ? s : ""), len(s ? (uint16_t)strlen(s) : 0) {}
+    TextSpan(const char* s, uint16_t n) : ptr(s), len(n) {}
+
+    TextSpan sub(uint16_t start, uint16_t n = 0xFFFF) const {
+        if (start >= len) return TextSpan(ptr + len, 0);
+        uint16_t avail = len - start;
+        return TextSpan(ptr + start, n < avail ? n : avail);
+    }
+
+    bool empty() const { return len == 0; }
+};
+
+class LcdFrameBuffer {
+private:
+    uint8_t back[LCD_ROWS][LCD_COLS];
+    uint8_t front[LCD_ROWS][LCD_COLS];
+    uint8_t curCol = 0;
+    uint8_t curRow = 0;
+
+public:
+    // Statistics (HD44780 bytes: commands + data)
+    uint16_t lastFrameBytes = 0;
+    uint32_t totalBytes = 0;
+
+    LcdFrameBuffer() {
+        memset(back, ' ', sizeof(back));
+        memset(front, ' ', sizeof(front));
+    }
+
+    // Call right after lcd->clear(): the glass is blank
+    void invalidate() {
+        memset(front, ' ', sizeof(front));
+    }
+
+    // ==========================================
+    // DRAWING (RAM only)
+    // ==========================================
+    void clear() {
+        memset(back, ' ', sizeof(back));
+        curCol = 0; curRow = 0;
+    }
+
+    void setCursor(uint8_t col, uint8_t row) {
+        curCol = col;
+        curRow = row;
+    }
+
+    // Raw byte (custom chars 0-7 included)
+    void write(uint8_t c) {
+        if (curRow < LCD_ROWS && curCol < LCD_COLS) back[curRow][curCol] = c;
+        curCol++;
+    }
+
+    void print(const char* s) {
+        while (*s) write((uint8_t)*s++);
+    }
+
+    void print(TextSpan s) {
+        for (uint16_t i = 0; i < s.len; i++) write((uint8_t)s.ptr[i]);
+    }
+
+    // Exactly 'width' cells: truncated or padded with spaces
+    void printField(TextSpan s, uint8_t width) {
+        for (uint8_t i = 0; i < width; i++) write(i < s.len ? (uint8_t)s.ptr[i] : ' ');
+    }
+
+    void print(int v) {
+        char buf[12];
+        snprintf(buf, sizeof(buf), "%d", v);
+        print(buf);
+    }
+
+    void print(float v, int digits) {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%.*f", digits, v);
+        print(buf);
+    }
+
+    // ==========================================
+    // DIFF & SEND
+    // ==========================================
+    // Returns the number of HD44780 bytes sent
+    uint16_t flush(LiquidCrystal_I2C* lcd) {
+        uint16_t bytes = 0;
+
+        for (uint8_t r = 0; r < LCD_ROWS; r++) {
+            uint8_t c = 0;
+            while (c < LCD_COLS) {
+                // Find start of a dirty run
+                if (back[r][c] == front[r][c]) { c++; continue; }
+                uint8_t start = c;
+                uint8_t end = c; // Last dirty cell (inclusive)
+
+                // Extend the run, swallowing small clean gaps
+                uint8_t k = c + 1;
+                while (k < LCD_COLS) {
+                    if (back[r][k] != front[r][k]) {
+                        end = k;
+                        k++;
+                    } else if (k - end <= LCD_RUN_MERGE_GAP) {
+                        k++;
+                    } else {
+                        break;
+                    }
+                }
+
+                // Send the run
+                lcd->setCursor(start, r);
+                bytes++;
+                for (uint8_t i = start; i <= end; i++) {
+                    lcd->write(back[r][i]);
+                    front[r][i] = back[r][i];
+                    bytes++;
+                }
+                c = end + 1;
+            }
+        }
+
+        lastFrameBytes = bytes;
+        totalBytes += bytes;
+        return bytes;
+    }
+};
+
+#endif // LCDFRAME_H
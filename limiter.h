@@ -0,0 +1,186 @@
+/*
+ * limiter.h - Look-ahead True-Peak Brickwall Limiter (Master Output)
+ *
+ * Logic:
+ * 1. Detect: 4x polyphase interpolation finds the inter-sample peaks
+ *    (phases 1-3, phase 0 is the sample itself). Stereo-linked.
+ * 2. Required gain per sample: min(1, ceiling / peak).
+ * 3. Sliding minimum over the look-ahead window (monotonic deque, O(1)).
+ * 4. Release: one-pole recovery, attack is never slowed down.
+ * 5. Box filter over the same window: the gain ramps down smoothly and
+ *    reaches the required value exactly when the peak leaves the delay line.
+ * 6. Audio is delayed by the window (+ interpolator latency) and multiplied.
+ *
+ * Steps 3 and 5 guarantee gain <= required gain for every delayed sample,
+ * so the output never exceeds the ceiling (brickwall, no clipping).
+ * Between the 4x points the true peak can still exceed it by ~0.1 dB.
+ *
+ * Signals are floats on the int32 scale (as in AudioDSP).
+ */
+
+#ifndef LIMITER_H
+#define LIMITER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <math.h>
+
+// ==========================================
+// CONFIGURATION
+// ==========================================
+#define LIMITER_LOOKAHEAD     64      // Samples (1.45 ms @ 44.1k). Power of two.
+#define LIMITER_TP_TAPS       8       // Taps per interpolator phase (even)
+#define LIMITER_CEILING_DB    -1.0f   // dBTP
+#define LIMITER_RELEASE_MS    80.0f
+#define LIMITER_CYCLE_BUDGET  600     // CPU cycles per stereo sample (240 MHz)
+#define LIMITER_FULL_SCALE    2147483647.0f
+
+#define LIMITER_DELAY         (LIMITER_LOOKAHEAD + LIMITER_TP_TAPS / 2 - 1)
+#define LIMITER_DELAY_RING    128     // Power of two > LIMITER_DELAY
+#define LIMITER_GAIN_ONE      (1 << 23) // Q23 gain, exact box filter sums
+
+class Limiter {
+private:
+    // --- True-peak interpolator ---
+    float coef[3][LIMITER_TP_TAPS];           // Phases 1/4, 2/4, 3/4
+    float histL[LIMITER_TP_TAPS * 2];         // Doubled ring: contiguous reads
+    float histR[LIMITER_TP_TAPS * 2];
+    int histPos = 0;
+
+    // --- Sliding minimum (monotonic deque) ---
+    int32_t dqVal[LIMITER_LOOKAHEAD];
+    uint32_t dqIdx[LIMITER_LOOKAHEAD];
+    uint32_t dqHead = 0, dqTail = 0;          // tail - head = size
+    uint32_t n = 0;                           // Sample counter
+
+    // --- Release + box smoothing ---
+    int32_t released = LIMITER_GAIN_ONE;
+    float releaseCoef = 0.0f;
+    int32_t box[LIMITER_LOOKAHEAD];
+    int32_t boxSum = LIMITER_LOOKAHEAD * LIMITER_GAIN_ONE;
+    int boxPos = 0;
+
+    // --- Delay line ---
+    float delayL[LIMITER_DELAY_RING];
+    float delayR[LIMITER_DELAY_RING];
+    int delayPos = 0;
+
+    float ceiling = 0.0f;
+
+    // --- Gain reduction meter (published every 64 samples) ---
+    int32_t blockMin = LIMITER_GAIN_ONE;
+    std::atomic<int32_t> grMin;
+
+public:
+    Limiter() : grMin(LIMITER_GAIN_ONE) {}
+
+    void init(float ceilingDb = LIMITER_CEILING_DB, float sampleRate = 44100.0f) {
+        ceiling = LIMITER_FULL_SCALE * powf(10.0f, ceilingDb / 20.0f);
+        releaseCoef = 1.0f - expf(-1.0f / (LIMITER_RELEASE_MS * 0.001f * sampleRate));
+
+        // Windowed-sinc polyphase interpolator (Hann window over the taps)
+        const float half = LIMITER_TP_TAPS / 2;
+        for (int p = 1; p <= 3; p++) {
+            float sum = 0.0f;
+            for (int j = 0; j < LIMITER_TP_TAPS; j++) {
+                float t = (half - 1) + p * 0.25f - j; // Distance to tap j
+                float sinc = (fabsf(t) < 1e-6f) ? 1.0f : sinf(PI * t) / (PI * t);
+                float win = 0.5f + 0.5f * cosf(PI * t / half);
+                coef[p - 1][j] = sinc * win;
+                sum += coef[p - 1][j];
+            }
+            for (int j = 0; j < LIMITER_TP_TAPS; j++) coef[p - 1][j] /= sum; // Unity DC
+        }
+        reset();
+    }
+
+    void reset() {
+        memset(histL, 0, sizeof(histL));
+        memset(histR, 0, sizeof(histR));
+        memset(delayL, 0, sizeof(delayL));
+        memset(delayR, 0, sizeof(delayR));
+        for (int i = 0; i < LIMITER_LOOKAHEAD; i++) box[i] = LIMITER_GAIN_ONE;
+        boxSum = LIMITER_LOOKAHEAD * LIMITER_GAIN_ONE;
+        released = LIMITER_GAIN_ONE;
+        dqHead = dqTail = 0;
+        histPos = boxPos = delayPos = 0;
+        blockMin = LIMITER_GAIN_ONE;
+    }
+
+    // ==========================================
+    // PROCESS (per sample, stereo-linked)
+    // ==========================================
+    inline void process(float &l, float &r) {
+        // 1. Interpolator history (written twice: taps read without wrapping)
+        histL[histPos] = histL[histPos + LIMITER_TP_TAPS] = l;
+        histR[histPos] = histR[histPos + LIMITER_TP_TAPS] = r;
+        histPos = (histPos + 1) & (LIMITER_TP_TAPS - 1);
+        const float* hl = &histL[histPos]; // Oldest .. newest
+        const float* hr = &histR[histPos];
+
+        // 2. True peak: sample (phase 0) + 3 interpolated phases
+        float peak = fmaxf(fabsf(hl[LIMITER_TP_TAPS / 2 - 1]), fabsf(hr[LIMITER_TP_TAPS / 2 - 1]));
+        for (int p = 0; p < 3; p++) {
+            float il = 0.0f, ir = 0.0f;
+            for (int j = 0; j < LIMITER_TP_TAPS; j++) {
+                il += coef[p][j] * hl[j];
+                ir += coef[p][j] * hr[j];
+            }
+            peak = fmaxf(peak, fmaxf(fabsf(il), fabsf(ir)));
+        }
+
+        // 3. Required gain (Q23)
+        int32_t need = LIMITER_GAIN_ONE;
+        if (peak > ceiling) need = (int32_t)((ceiling / peak) * LIMITER_GAIN_ONE);
+
+        // 4. Sliding minimum over the look-ahead window
+        //    (expire first: at most LIMITER_LOOKAHEAD entries after the push)
+        if (dqTail != dqHead && n - dqIdx[dqHead & (LIMITER_LOOKAHEAD - 1)] >= LIMITER_LOOKAHEAD) dqHead++;
+        while (dqTail != dqHead && dqVal[(dqTail - 1) & (LIMITER_LOOKAHEAD - 1)] >= need) dqTail--;
+        dqVal[dqTail & (LIMITER_LOOKAHEAD - 1)] = need;
+        dqIdx[dqTail & (LIMITER_LOOKAHEAD - 1)] = n;
+        dqTail++;
+        int32_t held = dqVal[dqHead & (LIMITER_LOOKAHEAD - 1)];
+        n++;
+
+        // 5. Release (instant down, one-pole up)
+        if (held < released) released = held;
+        else released += (int32_t)((held - released) * releaseCoef) + (held > released);
+
+        // 6. Box smoothing (exact integer running sum)
+        boxSum += released - box[boxPos];
+        box[boxPos] = released;
+        boxPos = (boxPos + 1) & (LIMITER_LOOKAHEAD - 1);
+        int32_t gain = boxSum / LIMITER_LOOKAHEAD;
+        if (gain < blockMin) blockMin = gain;
+
+        // 7. Delay and apply
+        delayL[delayPos] = l;
+        delayR[delayPos] = r;
+        int rd = (delayPos - LIMITER_DELAY) & (LIMITER_DELAY_RING - 1);
+        delayPos = (delayPos + 1) & (LIMITER_DELAY_RING - 1);
+        float g = gain * (1.0f / LIMITER_GAIN_ONE);
+        l = delayL[rd] * g;
+        r = delayR[rd] * g;
+
+        // 8. Publish the deepest reduction every 64 samples
+        if ((n & 63) == 0) {
+            int32_t cur = grMin.load(std::memory_order_relaxed);
+            while (blockMin < cur && !grMin.compare_exchange_weak(cur, blockMin, std::memory_order_relaxed)) {}
+            blockMin = LIMITER_GAIN_ONE;
+        }
+    }
+
+    // Deepest gain reduction since the last call, in dB (>= 0)
+    float getGainReductionDb() {
+        int32_t g = grMin.exchange(LIMITER_GAIN_ONE);
+        if (g >= LIMITER_GAIN_ONE) return 0.0f;
+        if (g <= 0) return 96.0f;
+        return -20.0f * log10f((float)g / LIMITER_GAIN_ONE);
+    }
+
+    // Output latency in samples
+    int getLatency() { return LIMITER_DELAY; }
+};
+
+#endif // LIMITER_H
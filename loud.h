@@ -2,11 +2,25 @@
  * Loud.h - Vintage Hi-Fi Loudness DSP Engine
  * Implements Fletcher-Munson style compensation with Logarithmic Taper.
  *
+ * Two modes:
+ * - Step (default): boost from the volume knob step (log taper below
+ *   LOUD_THRESHOLD_STEP), whatever the signal level.
+ * - Level: boost from the estimated listening level in phon (programme
+ *   loudness + volume + calibration). The shelf gains follow the ISO
+ *   226:2003 equal-loudness contours relative to LOUD_REF_PHON. Shelf
+ *   coefficients are precomputed at every LOUD_PHON_STEP node in Init;
+ *   a level change only interpolates two nodes and ramps the coefficients
+ *   over LOUD_RAMP_SAMPLES (no transcendental math, no zipper noise).
+ *   Linear interpolation keeps the filter stable: all nodes share w0/Q
+ *   and the 2nd-order stability region is convex.
+ *
  * Integration:
  * 1. #include "Loud.h"
  * 2. Create instance: LoudnessEngine myLoudness;
  * 3. Init: Loudness_Init(&myLoudness);
  * 4. On Volume Change: Loudness_SetVolumeStep(&myLoudness, currentStep);
+ *    Level mode: Loudness_SetLevelMode(&myLoudness, 1), then
+ *    Loudness_SetLevel(&myLoudness, phon) at display rate (any thread)
  * 5. In Audio Loop: output = Loudness_ProcessSample(&myLoudness, input);
  */
 
@@ -36,6 +50,20 @@
 // Steps 0 to 19 = Boost applied. Steps 20 to 30 = Flat.
 #define LOUD_THRESHOLD_STEP    20
 
+// Level mode: ISO 226 nodes at 20, 30, .. 90 phon
+#define LOUD_PHON_MIN          20.0f
+#define LOUD_PHON_STEP         10.0f
+#define LOUD_PHON_NODES        8
+#define LOUD_REF_PHON          80.0f   // Mixing level: flat at and above
+#define LOUD_CAL_PHON          100.0f  // Phon of a 0 LUFS programme at 0 dB volume (speaker + room)
+#define LOUD_GATE_LUFS         -50.0f  // Quieter programme (pause): keep the last level
+#define LOUD_RAMP_SAMPLES      64      // Coefficient ramp per level change (1.5 ms)
+
+// ISO 226:2003 equal-loudness contours minus their 1 kHz value (dB), per node:
+// bass sampled at 63 Hz (below the 100 Hz shelf corner), treble at 10 kHz
+static const float LOUD_ISO_BASS[LOUD_PHON_NODES]   = { 38.5f, 36.2f, 33.1f, 29.6f, 25.9f, 22.2f, 18.3f, 14.5f };
+static const float LOUD_ISO_TREBLE[LOUD_PHON_NODES] = { 14.4f, 14.6f, 14.3f, 13.8f, 13.1f, 12.5f, 11.7f, 11.0f };
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846f
 #endif
@@ -54,6 +82,15 @@ typedef struct {
     L_Biquad trebleFilter;
     int currentVolumeStep;
     int isEnabled;            // 1 = ON, 0 = OFF
+
+    // Level mode
+    int levelMode;            // 1 = follow Loudness_SetLevel()
+    L_Biquad bassNodes[LOUD_PHON_NODES];   // Coefficients only
+    L_Biquad trebleNodes[LOUD_PHON_NODES];
+    volatile float targetPhon;             // Written by the control side
+    float activePhon;                      // Ramp target (audio side)
+    L_Biquad bassStep, trebleStep;         // Per-sample coefficient increments
+    int rampLeft;
 } LoudnessEngine;
 
 // ==========================================
@@ -75,16 +112,9 @@ static inline void L_Biquad_Reset(L_Biquad* f) {
     f->a1 = 0.0f; f->a2 = 0.0f;
 }
 
-// Calculate Shelf Coefficients
-// type: 0 = Low Shelf, 1 = High Shelf
-static inline void L_Calc_Shelf(L_Biquad* f, float freq, float gainDB, int type) {
-    // If gain is effectively 0, set to pass-through to save precision
-    if (fabsf(gainDB) < 0.1f) {
-        f->b0 = 1.0f; f->b1 = 0.0f; f->b2 = 0.0f;
-        f->a1 = 0.0f; f->a2 = 0.0f;
-        return;
-    }
-
+// Shelf Coefficients, also for 0 dB (exact pass-through: b = a), so that
+// nodes of the same corner can be interpolated
+static inline void L_Shelf_Coefs(L_Biquad* f, float freq, float gainDB, int type) {
     float A = powf(10.0f, gainDB / 40.0f);
     float w0 = 2.0f * M_PI * freq / LOUD_SAMPLE_RATE;
     float sin_w0 = sinf(w0);
@@ -116,6 +146,49 @@ static inline void L_Calc_Shelf(L_Biquad* f, float freq, float gainDB, int type)
     f->a2 = a2 / a0;
 }
 
+// Calculate Shelf Coefficients
+// type: 0 = Low Shelf, 1 = High Shelf
+static inline void L_Calc_Shelf(L_Biquad* f, float freq, float gainDB, int type) {
+    // If gain is effectively 0, set to pass-through to save precision
+    if (fabsf(gainDB) < 0.1f) {
+        f->b0 = 1.0f; f->b1 = 0.0f; f->b2 = 0.0f;
+        f->a1 = 0.0f; f->a2 = 0.0f;
+        return;
+    }
+    L_Shelf_Coefs(f, freq, gainDB, type);
+}
+
+// Level mode: starts a ramp from the current coefficients to the ones at
+// 'phon' (linear between the two nearest nodes)
+static inline void L_Start_Ramp(LoudnessEngine* eng, float phon) {
+    float x = (phon - LOUD_PHON_MIN) / LOUD_PHON_STEP;
+    if (x < 0.0f) x = 0.0f;
+    if (x > LOUD_PHON_NODES - 1) x = LOUD_PHON_NODES - 1;
+    int i = (int)x;
+    if (i > LOUD_PHON_NODES - 2) i = LOUD_PHON_NODES - 2;
+    float t = x - i;
+
+    const float k = 1.0f / LOUD_RAMP_SAMPLES;
+    L_Biquad* cur[2] = { &eng->bassFilter, &eng->trebleFilter };
+    L_Biquad* step[2] = { &eng->bassStep, &eng->trebleStep };
+    const L_Biquad* n0[2] = { &eng->bassNodes[i], &eng->trebleNodes[i] };
+    const L_Biquad* n1[2] = { &eng->bassNodes[i + 1], &eng->trebleNodes[i + 1] };
+    for (int f = 0; f < 2; f++) {
+        step[f]->b0 = (n0[f]->b0 + t * (n1[f]->b0 - n0[f]->b0) - cur[f]->b0) * k;
+        step[f]->b1 = (n0[f]->b1 + t * (n1[f]->b1 - n0[f]->b1) - cur[f]->b1) * k;
+        step[f]->b2 = (n0[f]->b2 + t * (n1[f]->b2 - n0[f]->b2) - cur[f]->b2) * k;
+        step[f]->a1 = (n0[f]->a1 + t * (n1[f]->a1 - n0[f]->a1) - cur[f]->a1) * k;
+        step[f]->a2 = (n0[f]->a2 + t * (n1[f]->a2 - n0[f]->a2) - cur[f]->a2) * k;
+    }
+    eng->activePhon = phon;
+    eng->rampLeft = LOUD_RAMP_SAMPLES;
+}
+
+static inline void L_Ramp_Step(L_Biquad* f, const L_Biquad* d) {
+    f->b0 += d->b0; f->b1 += d->b1; f->b2 += d->b2;
+    f->a1 += d->a1; f->a2 += d->a2;
+}
+
 // ==========================================
 // PUBLIC API
 // ==========================================
@@ -130,6 +203,21 @@ static inline void Loudness_Init(LoudnessEngine* eng) {
     // Init filters to flat
     L_Calc_Shelf(&eng->bassFilter, LOUD_BASS_FREQ, 0.0f, 0);
     L_Calc_Shelf(&eng->trebleFilter, LOUD_TREBLE_FREQ, 0.0f, 1);
+
+    // Level mode nodes: contour difference to the reference, boost only
+    int ref = (int)((LOUD_REF_PHON - LOUD_PHON_MIN) / LOUD_PHON_STEP);
+    for (int i = 0; i < LOUD_PHON_NODES; i++) {
+        float bass = LOUD_ISO_BASS[i] - LOUD_ISO_BASS[ref];
+        float treble = LOUD_ISO_TREBLE[i] - LOUD_ISO_TREBLE[ref];
+        bass = (bass < 0.0f) ? 0.0f : (bass > MAX_BASS_BOOST_DB) ? MAX_BASS_BOOST_DB : bass;
+        treble = (treble < 0.0f) ? 0.0f : (treble > MAX_TREBLE_BOOST_DB) ? MAX_TREBLE_BOOST_DB : treble;
+        L_Shelf_Coefs(&eng->bassNodes[i], LOUD_BASS_FREQ, bass, 0);
+        L_Shelf_Coefs(&eng->trebleNodes[i], LOUD_TREBLE_FREQ, treble, 1);
+    }
+    eng->levelMode = 0;
+    eng->targetPhon = LOUD_REF_PHON;
+    eng->activePhon = LOUD_REF_PHON;
+    eng->rampLeft = 0;
 }
 
 // 2. Set Volume and Recalculate Curves (The "Logarithmic Engine")
@@ -137,6 +225,7 @@ static inline void Loudness_SetVolumeStep(LoudnessEngine* eng, int step) {
     if (step < 0) step = 0;
     if (step > 30) step = 30;
     eng->currentVolumeStep = step;
+    if (eng->levelMode) return; // Driven by Loudness_SetLevel()
 
     float bassGain = 0.0f;
     float trebleGain = 0.0f;
@@ -177,8 +266,36 @@ static inline void Loudness_SetState(LoudnessEngine* eng, int enabled) {
     Loudness_SetVolumeStep(eng, eng->currentVolumeStep);
 }
 
+// 3b. Level mode ON/OFF (ramps from the current curve, no click)
+static inline void Loudness_SetLevelMode(LoudnessEngine* eng, int enabled) {
+    eng->levelMode = enabled;
+    eng->rampLeft = 0;
+    if (enabled) {
+        L_Start_Ramp(eng, eng->isEnabled ? eng->targetPhon : LOUD_REF_PHON);
+    } else {
+        Loudness_SetVolumeStep(eng, eng->currentVolumeStep);
+    }
+}
+
+// 3c. Listening level (phon), level mode only. A single float store: safe
+// from any task, the audio side picks it up after the current ramp.
+static inline void Loudness_SetLevel(LoudnessEngine* eng, float phon) {
+    eng->targetPhon = phon;
+}
+
 // 4. Process Audio (Call inside your sample loop)
 static inline float Loudness_ProcessSample(LoudnessEngine* eng, float input) {
+    if (eng->levelMode) {
+        if (eng->rampLeft == 0) {
+            float phon = eng->isEnabled ? eng->targetPhon : LOUD_REF_PHON; // Off = flat
+            if (phon != eng->activePhon) L_Start_Ramp(eng, phon);
+        }
+        if (eng->rampLeft > 0) {
+            L_Ramp_Step(&eng->bassFilter, &eng->bassStep);
+            L_Ramp_Step(&eng->trebleFilter, &eng->trebleStep);
+            eng->rampLeft--;
+        }
+    }
     float temp = L_Biquad_Process(&eng->bassFilter, input);
     return L_Biquad_Process(&eng->trebleFilter, temp);
 }
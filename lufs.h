@@ -0,0 +1,251 @@
+/*
+ * lufs.h - Loudness Meter (ITU-R BS.1770 / EBU R128) + Source Normalization
+ *
+ * Logic:
+ * 1. Audio side: feed() once per block on the source signal (before the
+ *    master chain). K-weighting = two biquads per channel:
+ *      - high shelf +4 dB above ~1.7 kHz (head)
+ *      - RLB high-pass 38 Hz
+ *    Squares are summed into 100 ms steps (z = L + R mean square).
+ * 2. Every step (block rate / 44):
+ *      momentary  = last 4 steps  (400 ms)
+ *      short-term = last 30 steps (3 s)
+ *      L = -0.691 + 10*log10(z)  [LUFS]
+ *    Each momentary block (75% overlap) above the -70 LUFS absolute gate
+ *    goes into a 0.1 LU histogram: the integrated value needs no block
+ *    list, whatever the programme length.
+ * 3. UI side: update() at display rate computes the integrated loudness
+ *    (relative gate -10 LU over the histogram) and slews the source trim
+ *    towards target - integrated, at LUFS_TRIM_RATE dB/s, within
+ *    +/-LUFS_MAX_TRIM dB. The meter runs before the trim, so the loop is
+ *    open: no hunting.
+ *
+ * Integration:
+ * 1. Audio task: lufs.feed(buffer, frames);
+ * 2. Source change: lufs.reset(); lufs.setTrim(savedTrimDb);
+ * 3. UI task: if (lufs.update()) dsp.setSourceTrim(lufs.getTrim());
+ */
+
+#ifndef LUFS_H
+#define LUFS_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <math.h>
+#include "dsp_engine.h"
+
+// ==========================================
+// CONFIGURATION
+// ==========================================
+#define LUFS_STEP           4410    // 100 ms at 44.1 kHz
+#define LUFS_MOMENTARY      4       // Steps (400 ms)
+#define LUFS_SHORT_TERM     30      // Steps (3 s)
+#define LUFS_ABS_GATE       -70.0f  // LUFS
+#define LUFS_REL_GATE       -10.0f  // LU below the ungated mean
+#define LUFS_HIST_MAX       10.0f   // Histogram -70 .. +10 LUFS
+#define LUFS_HIST_RES       0.1f    // LU per bin
+#define LUFS_HIST_BINS      800
+#define LUFS_FLOOR          -70.0f  // Reported for silence
+#define LUFS_TARGET         -18.0f  // Default target (leaves headroom for EQ/loudness)
+#define LUFS_MAX_TRIM       12.0f   // dB
+#define LUFS_TRIM_RATE      0.5f    // dB/s: slow enough to be inaudible
+#define LUFS_MIN_BLOCKS     25      // Gated blocks (~2.5 s) before trimming
+
+class LufsMeter {
+private:
+    // --- Audio side (single writer) ---
+    Biquad shelf, highpass;
+    float acc = 0.0f;
+    int accCount = 0;
+    float steps[LUFS_SHORT_TERM];      // Mean square per 100 ms step
+    int stepPos = 0, stepFill = 0;
+    uint32_t hist[LUFS_HIST_BINS];     // Gated momentary blocks per 0.1 LU
+    std::atomic<float> momentary, shortTerm;
+    std::atomic<uint32_t> blocks;      // Gated blocks in the histogram
+    std::atomic<bool> resetReq;
+
+    // --- UI side ---
+    float integrated = LUFS_FLOOR;
+    float trimDb = 0.0f;
+    float target = LUFS_TARGET;
+    bool enabled = false;
+    uint32_t lastUpdate = 0;
+
+public:
+    LufsMeter() : momentary(LUFS_FLOOR), shortTerm(LUFS_FLOOR), blocks(0), resetReq(false) {
+        kWeighting(44100.0f);
+        clear();
+    }
+
+    // ==========================================
+    // AUDIO SIDE (once per block)
+    // ==========================================
+    // buf: interleaved L/R int32 samples, frames: stereo frames
+    void feed(const int32_t* buf, int frames) {
+        if (resetReq.load(std::memory_order_acquire)) {
+            clear();
+            resetReq.store(false, std::memory_order_release);
+        }
+
+        const float scale = 1.0f / 2147483648.0f;
+        for (int i = 0; i < frames; i++) {
+            float l = buf[i * 2] * scale;
+            float r = buf[i * 2 + 1] * scale;
+            shelf.process(l, r);
+            highpass.process(l, r);
+            acc += l * l + r * r;
+            if (++accCount == LUFS_STEP) closeStep();
+        }
+    }
+
+    // Clears the readings at the next feed() (source change)
+    void reset() {
+        resetReq.store(true, std::memory_order_release);
+        integrated = LUFS_FLOOR;
+    }
+
+    // ==========================================
+    // UI SIDE (display rate)
+    // ==========================================
+    // Returns true when the trim changed
+    bool update() {
+        uint32_t now = millis();
+        float dt = (now - lastUpdate) * 0.001f;
+        lastUpdate = now;
+        if (dt > 1.0f) dt = 1.0f; // First call / long stall
+
+        uint32_t n = blocks.load(std::memory_order_acquire);
+        integrated = computeIntegrated();
+        if (!enabled || n < LUFS_MIN_BLOCKS || integrated <= LUFS_FLOOR) return false;
+
+        float want = constrain(target - integrated, -LUFS_MAX_TRIM, LUFS_MAX_TRIM);
+        float stepDb = LUFS_TRIM_RATE * dt;
+        float next = trimDb;
+        if (want > trimDb + stepDb) next += stepDb;
+        else if (want < trimDb - stepDb) next -= stepDb;
+        else next = want;
+        if (next == trimDb) return false;
+        trimDb = next;
+        return true;
+    }
+
+    // Readings (LUFS, LUFS_FLOOR when silent)
+    float getMomentary() { return momentary.load(std::memory_order_relaxed); }
+    float getShortTerm() { return shortTerm.load(std::memory_order_relaxed); }
+    float getIntegrated() { return integrated; }
+
+    // Normalization
+    void setEnabled(bool on) { enabled = on; }
+    bool isEnabled() { return enabled; }
+    void setTarget(float lufs) { target = constrain(lufs, -36.0f, -6.0f); }
+    float getTarget() { return target; }
+    void setTrim(float db) { trimDb = constrain(db, -LUFS_MAX_TRIM, LUFS_MAX_TRIM); }
+    float getTrim() { return trimDb; }
+
+    // Target reached (the trim is worth saving)
+    bool isSettled() {
+        return enabled && blocks.load(std::memory_order_relaxed) >= LUFS_MIN_BLOCKS &&
+               fabsf(target - integrated - trimDb) < 0.2f;
+    }
+
+private:
+    // BS.1770 filters re-derived for fs from their analog prototypes (as
+    // libebur128). Not the RBJ shelf/high-pass: the shelf's mid gain and the
+    // high-pass passband (+0.04 dB) differ, 0.25 dB at 1 kHz in total.
+    void kWeighting(float fs) {
+        float K = tanf(PI * 1681.974450955533f / fs);
+        float Q = 0.7071752369554196f;
+        float Vh = powf(10.0f, 3.999843853973347f / 20.0f);
+        float Vb = powf(Vh, 0.4996667741545416f);
+        float a0 = 1.0f + K / Q + K * K;
+        shelf.b0 = (Vh + Vb * K / Q + K * K) / a0;
+        shelf.b1 = 2.0f * (K * K - Vh) / a0;
+        shelf.b2 = (Vh - Vb * K / Q + K * K) / a0;
+        shelf.a1 = 2.0f * (K * K - 1.0f) / a0;
+        shelf.a2 = (1.0f - K / Q + K * K) / a0;
+
+        K = tanf(PI * 38.13547087602444f / fs);
+        Q = 0.5003270373238773f;
+        a0 = 1.0f + K / Q + K * K;
+        highpass.b0 = 1.0f;
+        highpass.b1 = -2.0f;
+        highpass.b2 = 1.0f;
+        highpass.a1 = 2.0f * (K * K - 1.0f) / a0;
+        highpass.a2 = (1.0f - K / Q + K * K) / a0;
+    }
+
+    static float toLufs(float z) {
+        if (z <= 1e-7f) return LUFS_FLOOR; // -70 LUFS
+        float lufs = -0.691f + 10.0f * log10f(z);
+        return (lufs < LUFS_FLOOR) ? LUFS_FLOOR : lufs;
+    }
+
+    void clear() {
+        acc = 0.0f;
+        accCount = 0;
+        stepPos = stepFill = 0;
+        memset(steps, 0, sizeof(steps));
+        memset(hist, 0, sizeof(hist));
+        shelf.resetState();
+        highpass.resetState();
+        momentary.store(LUFS_FLOOR, std::memory_order_relaxed);
+        shortTerm.store(LUFS_FLOOR, std::memory_order_relaxed);
+        blocks.store(0, std::memory_order_release);
+    }
+
+    // Every 100 ms: momentary and short-term, one gating block
+    void closeStep() {
+        steps[stepPos] = acc / LUFS_STEP;
+        stepPos = (stepPos + 1) % LUFS_SHORT_TERM;
+        if (stepFill < LUFS_SHORT_TERM) stepFill++;
+        acc = 0.0f;
+        accCount = 0;
+
+        float zm = 0.0f, zs = 0.0f;
+        for (int i = 0; i < stepFill; i++) {
+            int k = (stepPos - 1 - i + LUFS_SHORT_TERM) % LUFS_SHORT_TERM;
+            if (i < LUFS_MOMENTARY) zm += steps[k];
+            zs += steps[k];
+        }
+        if (stepFill < LUFS_MOMENTARY) return; // First full 400 ms block
+        float m = toLufs(zm / LUFS_MOMENTARY);
+        momentary.store(m, std::memory_order_relaxed);
+        shortTerm.store(toLufs(zs / stepFill), std::memory_order_relaxed);
+
+        if (m > LUFS_ABS_GATE) {
+            int bin = (int)((m - LUFS_ABS_GATE) / LUFS_HIST_RES);
+            if (bin >= LUFS_HIST_BINS) bin = LUFS_HIST_BINS - 1;
+            hist[bin]++;
+            blocks.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    // Gated mean over the histogram (bin centre energies, one multiply per bin)
+    float computeIntegrated() {
+        const float ratio = powf(10.0f, LUFS_HIST_RES / 10.0f);
+        const float e0 = powf(10.0f, (LUFS_ABS_GATE + 0.5f * LUFS_HIST_RES + 0.691f) / 10.0f);
+
+        // Ungated (absolute gate only) mean -> relative gate
+        float sum = 0.0f, e = e0;
+        uint32_t n = 0;
+        for (int i = 0; i < LUFS_HIST_BINS; i++, e *= ratio) {
+            sum += hist[i] * e;
+            n += hist[i];
+        }
+        if (n == 0) return LUFS_FLOOR;
+        float gate = toLufs(sum / n) + LUFS_REL_GATE;
+        int first = (int)ceilf((gate - LUFS_ABS_GATE) / LUFS_HIST_RES - 0.5f);
+        if (first < 0) first = 0;
+
+        sum = 0.0f;
+        n = 0;
+        e = e0 * powf(ratio, (float)first);
+        for (int i = first; i < LUFS_HIST_BINS; i++, e *= ratio) {
+            sum += hist[i] * e;
+            n += hist[i];
+        }
+        return n ? toLufs(sum / n) : LUFS_FLOOR;
+    }
+};
+
+#endif // LUFS_H
@@ -8,15 +8,25 @@
 // --- LOCAL INCLUDES ---
 #include "pindef.h"
 #include "secrets.h"
+#include "settingstore.h"
 #include "dsp_engine.h"
 #include "bluestream.h"
+#include "metadata.h"
+#include "meter.h"
+#include "spectrum.h"
+#include "dspbench.h"
 #include "fmradio.h"
 #include "displayinfo.h"
 #include "phbuttons.h"
 #include "pnoise.h" 
+#include "siggen.h"
+#include "measure.h"
+#include "autoeq.h"
+#include "lufs.h"
 
 // --- GLOBAL OBJECTS ---
 Preferences preferences;
+SettingsStore settings;
 WebServer server(80);
 AudioDSP dsp;
 BlueStream bt;
@@ -39,15 +49,25 @@ bool genActive = false;
 float genFreqStart = 440.0;
 float genFreqEnd = 440.0;
 float genPeriod = 10.0;
-unsigned long sweepStartTime = 0;
-double currentPhase = 0;
+SignalGenerator gen;    // NCO sine / sweeps / noise, configured from /api/gen
+Measurement measure;    // Swept-sine FR/THD/latency (AUX: ADC in, DAC out)
+AutoEQ autoEq;          // Fits the EQ bands to the last measurement
 
 // Display & Meters
 unsigned long lastDisplayUpdate = 0;
-String btTitle = "";
-String btArtist = "";
-int vuLeft = 0;
-int vuRight = 0;
+MetadataMailbox btMeta; // Written by the BT task, read by UI/web (seqlock)
+Meter meter;            // Fed per audio block, read at display rate
+Spectrum spectrum;      // Post-DSP analyzer (runs only while LCD/web look at it)
+DspBench bench;         // Boot-time cycle cost of the DSP stages
+LufsMeter lufs;         // Source loudness (pre-chain) + per-source trim
+
+#define AUDIO_BLOCK 128 // Frames per DSP/I2S block in the BT sink callback
+
+// Both I2S ports get the same DMA layout: with blocking writes the queue
+// depth is the output latency, so equal queues keep the sub (I2S1) and the
+// tops (I2S0) sample-aligned in every mode.
+#define I2S_DMA_COUNT 8
+#define I2S_DMA_LEN   64
 
 // Radio UI
 bool radioShowMemories = false;
@@ -60,6 +80,8 @@ int radioCursor = 1;
 void bt_volume_callback(int vol);
 void bt_data_callback(const uint8_t *data, uint32_t len);
 void bt_metadata_callback(uint8_t id, const uint8_t *text);
+void bt_playstatus_callback(esp_avrc_playback_stat_t status);
+void bt_playpos_callback(uint32_t pos);
 int32_t bt_source_data_callback(Frame *data, int32_t frame_count);
 
 // --- I2S CONFIGURATION ---
@@ -70,9 +92,10 @@ void setupI2S_DAC() {
         .bits_per_sample = I2S_BITS_PER_SAMPLE_32BIT,
         .channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT,
         .communication_format = I2S_COMM_FORMAT_STAND_I2S,
-        .dma_buf_count = 8,
-        .dma_buf_len = 128,
-        .use_apll = true
+        .dma_buf_count = I2S_DMA_COUNT,
+        .dma_buf_len = I2S_DMA_LEN,
+        .use_apll = true,
+        .tx_desc_auto_clear = true // Silence (not a looping buffer) on underrun, as I2S1
     };
     i2s_driver_install(I2S_NUM_0, &dac_config, 0, NULL);
     i2s_pin_config_t dac_pins = {
@@ -84,23 +107,26 @@ void setupI2S_DAC() {
     i2s_set_pin(I2S_NUM_0, &dac_pins);
 }
 
-void setupI2S_ADC() {
+// I2S1: ADC input (rx) and/or crossover low way output (sub), same BCK/WS.
+// The ESP32 has no TDM on the legacy driver: the low way gets its own port.
+void setupI2S_ADC(bool rx = true, bool sub = false) {
     i2s_config_t adc_config = {
-        .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX),
+        .mode = (i2s_mode_t)(I2S_MODE_MASTER | (rx ? I2S_MODE_RX : 0) | (sub ? I2S_MODE_TX : 0)),
         .sample_rate = 44100,
         .bits_per_sample = I2S_BITS_PER_SAMPLE_32BIT,
         .channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT,
         .communication_format = I2S_COMM_FORMAT_STAND_I2S,
-        .dma_buf_count = 8,
-        .dma_buf_len = 64,
-        .use_apll = true
+        .dma_buf_count = I2S_DMA_COUNT,
+        .dma_buf_len = I2S_DMA_LEN,
+        .use_apll = true,
+        .tx_desc_auto_clear = true // Sub goes silent (not looping) on underrun
     };
     i2s_driver_install(I2S_NUM_1, &adc_config, 0, NULL);
     i2s_pin_config_t adc_pins = {
         .bck_io_num = PIN_ADC_BCK,
         .ws_io_num = PIN_ADC_WS,
-        .data_out_num = I2S_PIN_NO_CHANGE,
-        .data_in_num = PIN_ADC_DATA
+        .data_out_num = sub ? PIN_SUB_DATA : I2S_PIN_NO_CHANGE,
+        .data_in_num = rx ? PIN_ADC_DATA : I2S_PIN_NO_CHANGE
     };
     i2s_set_pin(I2S_NUM_1, &adc_pins);
 }
@@ -117,70 +143,82 @@ int32_t bt_source_data_callback(Frame *data, int32_t frame_count) {
     // Read from ADC (I2S_NUM_1)
     i2s_read(I2S_NUM_1, tempBuffer, frame_count * 8, &bytes_read, portMAX_DELAY);
 
-    for (int i=0; i < frame_count; i++) {
-        StereoSample s;
-        s.l = tempBuffer[i*2];
-        s.r = tempBuffer[i*2+1];
-
-        // [LOGIC] Only apply RIAA/Dolby if we are actually in AUX mode.
-        // If we are in Radio mode, the signal is already Line Level.
-        if (currentMode == MODE_AUX) {
-            s = dsp.processAuxPreamp(s);
-        }
-        
-        // [BYPASS] No processMasterChain here. 
-        // Signal goes straight to Headphones without EQ/Loudness.
-
-        // Update VU
-        int lPeak = abs(s.l >> 23);
-        int rPeak = abs(s.r >> 23);
-        if(lPeak > vuLeft) vuLeft = lPeak; else vuLeft *= 0.9;
-        if(rPeak > vuRight) vuRight = rPeak; else vuRight *= 0.9;
+    // [LOGIC] Only apply RIAA/Dolby if we are actually in AUX mode.
+    // If we are in Radio mode, the signal is already Line Level.
+    if (currentMode == MODE_AUX) {
+        dsp.processAuxPreampBlock(tempBuffer, frame_count);
+    }
 
+    // [BYPASS] No processMasterChain here. 
+    // Signal goes straight to Headphones without EQ/Loudness.
+    for (int i=0; i < frame_count; i++) {
         // Write to Frame (16-bit)
-        data[i].channel1 = s.l >> 16;
-        data[i].channel2 = s.r >> 16;
+        data[i].channel1 = tempBuffer[i*2] >> 16;
+        data[i].channel2 = tempBuffer[i*2+1] >> 16;
     }
+    meter.feed(tempBuffer, frame_count);
+    spectrum.push(tempBuffer, frame_count);
+    lufs.feed(tempBuffer, frame_count); // Metering only (no master chain)
     return frame_count;
 }
 
 // [RX MODE] Metadata
 void bt_volume_callback(int vol) {
-    // Map BT volume (0-127) to your system volume (0-30)
-    int newVol = map(vol, 0, 127, 0, 30);
+    // Map BT volume (0-127) to your system volume (0-30), rounded so that
+    // the value we send back (volume * 127 / 30) maps to the same step
+    int newVol = (vol * 30 + 63) / 127;
     if (newVol != volume) {
         volume = newVol;
         dsp.setVolume(volume);
-        preferences.putInt("vol", volume); // Optional: Save to memory
+        settings.putInt("vol", volume); // Coalesced, committed after a quiet period
     }
 }
 void bt_metadata_callback(uint8_t id, const uint8_t *text) {
-    if (id == 0x1) btTitle = (const char*)text;
-    else if (id == 0x2) btArtist = (const char*)text;
-    if (btTitle == "") btTitle = "Connected";
+    btMeta.setText(id, text);
+}
+void bt_playstatus_callback(esp_avrc_playback_stat_t status) {
+    btMeta.setPlayState((uint8_t)status);
+}
+void bt_playpos_callback(uint32_t pos) {
+    btMeta.setPosition(pos);
 }
 
 // [RX MODE] Sink Callback
 void bt_data_callback(const uint8_t *data, uint32_t len) {
     size_t bytes_written;
-    int16_t* samples = (int16_t*)data;
-    uint32_t sample_count = len / 4; 
-
-    for(int i=0; i < sample_count; i++) {
-        StereoSample s;
-        s.l = ((int32_t)samples[i*2]) << 16;
-        s.r = ((int32_t)samples[i*2+1]) << 16;
-        
-        s = dsp.processMasterChain(s);
-
-        int lPeak = abs(s.l >> 23);
-        int rPeak = abs(s.r >> 23);
-        if(lPeak > vuLeft) vuLeft = lPeak; else vuLeft *= 0.9;
-        if(rPeak > vuRight) vuRight = rPeak; else vuRight *= 0.9;
-
-        // Output to DAC
-        int32_t outFrame[2] = {s.l, s.r};
-        i2s_write(I2S_NUM_0, outFrame, 8, &bytes_written, portMAX_DELAY);
+    const int16_t* samples = (const int16_t*)data;
+    uint32_t frames = len / 4;
+    static int32_t block[AUDIO_BLOCK * 2]; // Only the BT task calls this
+    static int32_t lowBlock[AUDIO_BLOCK * 2];
+    static int32_t srcBlock[AUDIO_BLOCK * 2]; // Source for the LUFS meter
+
+    // Process in blocks: one meter update and one i2s_write per block
+    while (frames > 0) {
+        uint32_t n = (frames > AUDIO_BLOCK) ? AUDIO_BLOCK : frames;
+        for (uint32_t i = 0; i < n; i++) {
+            StereoSample s, low;
+            s.l = ((int32_t)samples[i*2]) << 16;
+            s.r = ((int32_t)samples[i*2+1]) << 16;
+            srcBlock[i*2] = s.l;
+            srcBlock[i*2+1] = s.r;
+
+            s = dsp.processMasterChain(s, low);
+
+            block[i*2] = s.l;
+            block[i*2+1] = s.r;
+            lowBlock[i*2] = low.l;
+            lowBlock[i*2+1] = low.r;
+        }
+        dsp.processOutputBlock(block, lowBlock, n);
+        lufs.feed(srcBlock, n);
+        meter.feed(block, n);
+        spectrum.push(block, n);
+
+        // Output to DAC (+ sub DAC when the crossover is on)
+        i2s_write(I2S_NUM_0, block, n * 8, &bytes_written, portMAX_DELAY);
+        if (dsp.xover.enabled) i2s_write(I2S_NUM_1, lowBlock, n * 8, &bytes_written, portMAX_DELAY);
+        samples += n * 2;
+        frames -= n;
     }
 }
 
@@ -194,51 +232,91 @@ void handleAnalogLoop() {
 
     size_t bytes_read, bytes_written;
     int32_t i2s_buffer[64 * 2];
+    int32_t low_buffer[64 * 2];
 
     i2s_read(I2S_NUM_1, i2s_buffer, sizeof(i2s_buffer), &bytes_read, 0);
 
     if (bytes_read > 0) {
         int samples = bytes_read / 8;
+        if (measure.isPlaying()) {
+            // Sweep out, microphone in: the DSP chain is bypassed
+            measure.process(i2s_buffer, samples);
+            i2s_write(I2S_NUM_0, i2s_buffer, bytes_read, &bytes_written, portMAX_DELAY);
+            return;
+        }
+        dsp.processAuxPreampBlock(i2s_buffer, samples);
+        lufs.feed(i2s_buffer, samples); // Source level, before the trim
         for (int i=0; i<samples; i++) {
-            StereoSample s;
+            StereoSample s, low;
             s.l = i2s_buffer[i*2];
             s.r = i2s_buffer[i*2+1];
-            s = dsp.processAuxPreamp(s);
-            s = dsp.processMasterChain(s);
-
-            int lPeak = abs(s.l >> 23);
-            int rPeak = abs(s.r >> 23);
-            if(lPeak > vuLeft) vuLeft = lPeak; else vuLeft *= 0.9;
-            if(rPeak > vuRight) vuRight = rPeak; else vuRight *= 0.9;
+            s = dsp.processMasterChain(s, low);
 
             i2s_buffer[i*2] = s.l;
             i2s_buffer[i*2+1] = s.r;
+            low_buffer[i*2] = low.l;
+            low_buffer[i*2+1] = low.r;
         }
+        dsp.processOutputBlock(i2s_buffer, low_buffer, samples);
+        meter.feed(i2s_buffer, samples);
+        spectrum.push(i2s_buffer, samples);
         i2s_write(I2S_NUM_0, i2s_buffer, bytes_read, &bytes_written, portMAX_DELAY);
+        if (dsp.xover.enabled) i2s_write(I2S_NUM_1, low_buffer, bytes_read, &bytes_written, portMAX_DELAY);
     }
 }
 
 void handleGenLoop() {
     size_t bytes_written;
     int32_t samples[64 * 2];
+    int32_t lowSamples[64 * 2];
+    float genBuffer[64];
+    gen.generate(genBuffer, 64);
     for (int i = 0; i < 64; i++) {
-        float sampleVal = 0;
-        if (genSignalType == 0) { 
-             sampleVal = sin(currentPhase) * 0.5;
-             currentPhase += 2 * PI * genFreqStart / 44100.0;
-             if(currentPhase > 2*PI) currentPhase -= 2*PI;
-        }
-        else if (genSignalType == 1) sampleVal = ((float)random(-1000, 1000) / 1000.0) * 0.5;
-        else if (genSignalType == 2) sampleVal = generatePinkNoise() * 0.5;
-
-        StereoSample s;
-        s.l = (int32_t)(sampleVal * 2147483647.0);
+        StereoSample s, low;
+        s.l = (int32_t)(genBuffer[i] * 2147483647.0f);
         s.r = s.l;
-        s = dsp.processMasterChain(s);
+        s = dsp.processMasterChain(s, low);
         samples[i*2] = s.l;
         samples[i*2+1] = s.r;
+        lowSamples[i*2] = low.l;
+        lowSamples[i*2+1] = low.r;
     }
+    dsp.processOutputBlock(samples, lowSamples, 64);
+    meter.feed(samples, 64);
+    spectrum.push(samples, 64);
     i2s_write(I2S_NUM_0, samples, sizeof(samples), &bytes_written, portMAX_DELAY);
+    if (dsp.xover.enabled) i2s_write(I2S_NUM_1, lowSamples, sizeof(lowSamples), &bytes_written, portMAX_DELAY);
+}
+
+// ==========================================
+// LOUDNESS NORMALIZATION (per source)
+// ==========================================
+// NVS key of the trim saved for the current source (none for the generator)
+const char* sourceTrimKey() {
+    static const char* keys[] = { "lufs_t0", "lufs_t1", "lufs_t2" };
+    return (currentMode == MODE_GEN) ? nullptr : keys[currentMode];
+}
+
+// Source change: fresh measurement, start from the trim saved for this source
+void loadSourceTrim() {
+    const char* key = sourceTrimKey();
+    lufs.reset();
+    lufs.setTrim(key ? settings.getInt(key, 0) / 100.0f : 0.0f);
+    dsp.setSourceTrim((key && lufs.isEnabled()) ? lufs.getTrim() : 0.0f);
+}
+
+// Display rate: slew the trim, save it once it has settled
+void updateLoudnessNorm() {
+    bool changed = lufs.update();
+    const char* key = sourceTrimKey();
+    if (!key || isTxMode) return; // Metering only
+    if (changed) dsp.setSourceTrim(lufs.getTrim());
+
+    int trim = (int)lroundf(lufs.getTrim() * 100.0f);
+    if (lufs.isSettled() && abs(trim - settings.getInt(key, 0)) >= 50) settings.putInt(key, trim);
+
+    // Level-dependent loudness follows the short-term programme level
+    if (dsp.loudnessLevelMode) dsp.setProgramLevel(lufs.getShortTerm());
 }
 
 // ==========================================
@@ -247,12 +325,17 @@ void handleGenLoop() {
 void switchMode(OperationMode newMode) {
     if (currentMode == newMode && millis() > 5000) return;
 
+    // The sweep plays from the AUX loop only: drop a run not captured yet
+    measure.cancel();
+
     // --- TX MODE LOGIC (Transmitter) ---
     if (isTxMode) {
         if (newMode == MODE_BT) newMode = MODE_AUX; // Can't be BT RX in TX mode
 
         currentMode = newMode;
-        preferences.putInt("last_mode", (int)currentMode);
+        settings.putInt("last_mode", (int)currentMode);
+        settings.flush();
+        loadSourceTrim();
 
         if (newMode == MODE_RADIO) {
             digitalWrite(PIN_RELAY_SOURCE, HIGH);
@@ -294,18 +377,26 @@ void switchMode(OperationMode newMode) {
     i2s_driver_uninstall(I2S_NUM_1);
 
     currentMode = newMode;
-    preferences.putInt("last_mode", (int)currentMode);
+    settings.putInt("last_mode", (int)currentMode);
+    settings.flush();
+    loadSourceTrim();
 
     if (newMode == MODE_BT) {
         digitalWrite(PIN_RELAY_SOURCE, LOW);
         buttons.setContext(CTX_BT);
-        bt.startRX(bt_data_callback, bt_metadata_callback, bt_volume_callback);
+        btMeta.clear(); // BT stack is down: the only writer is idle
+        setupI2S_DAC(); // Ours, not A2DP's: same DMA layout as the sub port
+        if (dsp.xover.enabled) setupI2S_ADC(false, true); // Sub DAC only
+        i2s_start(I2S_NUM_0);
+        if (dsp.xover.enabled) i2s_start(I2S_NUM_1);
+        bt.startRX(bt_data_callback, bt_metadata_callback, bt_volume_callback,
+                   bt_playstatus_callback, bt_playpos_callback);
 
     } else if (newMode == MODE_RADIO) {
         digitalWrite(PIN_RELAY_SOURCE, HIGH);
         buttons.setContext(CTX_RADIO);
         setupI2S_DAC(); // Wired Sound ON
-        setupI2S_ADC();
+        setupI2S_ADC(true, dsp.xover.enabled);
         i2s_start(I2S_NUM_0);
         i2s_start(I2S_NUM_1);
         radio.begin(PIN_I2C_SDA, PIN_I2C_SCL);
@@ -314,7 +405,7 @@ void switchMode(OperationMode newMode) {
         digitalWrite(PIN_RELAY_SOURCE, LOW);
         buttons.setContext(CTX_AUX);
         setupI2S_DAC(); // Wired Sound ON
-        setupI2S_ADC();
+        setupI2S_ADC(true, dsp.xover.enabled);
         i2s_start(I2S_NUM_0);
         i2s_start(I2S_NUM_1);
         if (wifiActive) {
@@ -326,7 +417,11 @@ void switchMode(OperationMode newMode) {
         digitalWrite(PIN_RELAY_SOURCE, LOW);
         setupI2S_DAC(); // Wired Sound ON
         i2s_start(I2S_NUM_0);
-        sweepStartTime = millis();
+        if (dsp.xover.enabled) {
+            setupI2S_ADC(false, true);
+            i2s_start(I2S_NUM_1);
+        }
+        gen.restart();
     }
 }
 
@@ -336,15 +431,15 @@ void switchMode(OperationMode newMode) {
 
 void actionVolUp() {
     if (volume < 30) volume++;
-    dsp.setVolume(volume);
-    if(currentMode == MODE_BT && !isTxMode) bt.setVolume(volume * 4);
-    preferences.putInt("vol", volume);
+    dsp.setVolume(volume); // Ramped master volume in the DSP (all sources)
+    if(currentMode == MODE_BT && !isTxMode) bt.setVolume(volume * 127 / 30); // Phone slider sync only
+    settings.putInt("vol", volume);
 }
 void actionVolDown() {
     if (volume > 0) volume--;
     dsp.setVolume(volume);
-    if(currentMode == MODE_BT && !isTxMode) bt.setVolume(volume * 4);
-    preferences.putInt("vol", volume);
+    if(currentMode == MODE_BT && !isTxMode) bt.setVolume(volume * 127 / 30);
+    settings.putInt("vol", volume);
 }
 void actionVolRapidUp() { actionVolUp(); }
 void actionVolRapidDown() { actionVolDown(); }
@@ -378,13 +473,17 @@ void actionCycleSource() {
 void actionToggleTxMode() {
     // 1. Toggle State
     bool newState = !isTxMode;
-    preferences.putBool("tx_mode", newState);
+    settings.putBool("tx_mode", newState);
     
     // Safety: If forcing OFF from BT RX, next boot must be valid
     if (currentMode == MODE_BT) {
-        preferences.putInt("last_mode", (int)MODE_AUX);
+        settings.putInt("last_mode", (int)MODE_AUX);
     }
 
+    // Commit everything pending before the restart
+    settings.flush();
+    radio.flushSettings();
+
     // 2. Notify User
     ui.screenLoading(newState ? "Rebooting to TX..." : "Rebooting to RX...");
     
@@ -422,6 +521,7 @@ void actionAuxCycleFilters() {
     if (dsp.preampMode > 4) dsp.preampMode = 0;
 }
 void actionAuxMute() {
+    // Step 0 is a real mute in the DSP volume (ramped: no click)
     static int savedVol = 15;
     if (volume > 0) { savedVol = volume; volume = 0; }
     else { volume = savedVol; }
@@ -431,11 +531,11 @@ void actionAuxMute() {
 // --- COMMON DSP ---
 void actionToggleExpander() {
     dsp.stereoExpand = !dsp.stereoExpand;
-    preferences.putBool("expand", dsp.stereoExpand);
+    settings.putBool("expand", dsp.stereoExpand);
 }
 void actionToggleLoudness() {
     dsp.loudnessEnabled = !dsp.loudnessEnabled;
-    preferences.putBool("loud", dsp.loudnessEnabled);
+    settings.putBool("loud", dsp.loudnessEnabled);
 }
 void actionBtPairing() {
     if (currentMode == MODE_BT && !isTxMode) bt.disconnectRX();
@@ -449,22 +549,36 @@ void updateDisplay() {
     if (millis() - lastDisplayUpdate < 100) return;
     lastDisplayUpdate = millis();
     
-    int vuL = map(vuLeft, 0, 15000, 0, 100);
-    int vuR = map(vuRight, 0, 15000, 0, 100);
-    if(vuL>100) vuL=100; if(vuR>100) vuR=100;
-    vuLeft *= 0.8; vuRight *= 0.8;
+    // Ballistics run here, at display rate
+    meter.update();
+    updateLoudnessNorm();
+    int vuL = meter.getBar(0);
+    int vuR = meter.getBar(1);
+
+    // Optional spectrum on the VU row
+    if (ui.isSpectrumRow()) {
+        float bands[SPECTRUM_EQ_BANDS];
+        spectrum.touch();
+        spectrum.getBands(bands, SPECTRUM_EQ_BANDS);
+        ui.setSpectrum(bands);
+    }
 
     if (currentMode == MODE_BT) {
-        String track = btArtist + " - " + btTitle;
-        if (btTitle == "") track = "Connected";
+        // Composed in a static buffer: no String concatenation per frame
+        // Lock-free snapshot of the AVRCP data (keeps the last one if torn)
+        static TrackInfo meta;
+        static char track[UI_TEXT_MAX];
+        btMeta.read(meta);
+        if (meta.title[0] == '\0') snprintf(track, sizeof(track), "Connected");
+        else if (meta.artist[0] == '\0') snprintf(track, sizeof(track), "%s", meta.title);
+        else snprintf(track, sizeof(track), "%s - %s", meta.artist, meta.title);
         ui.screenBT(dsp.loudnessEnabled, dsp.stereoExpand, volume,
-                    "Pixel", track, vuL, vuR);
+                    "Pixel", track, meta.playState, meta.positionAt(millis()), vuL, vuR);
     }
     else if (currentMode == MODE_RADIO) {
         if (radioShowMemories) {
-            String mems[8];
-            for(int i=0; i<8; i++) mems[i] = radio.getMemoryLabel(i+1);
-            ui.screenMemories(mems, radioCursor);
+            // Cached in RAM by RadioManager: no NVS access per frame
+            ui.screenMemories(radio.getMemoryLabels(), radioCursor);
         } else {
             ui.screenRadio(dsp.loudnessEnabled, dsp.stereoExpand, volume,
                            radio.getFrequency(), 0, radio.getRDSName(), radio.getRDSText(),
@@ -488,9 +602,10 @@ void updateDisplay() {
 void setup() {
     Serial.begin(115200);
     preferences.begin("espdsp", false);
+    settings.begin(&preferences);
 
     // 1. READ TX MODE PREFERENCE
-    isTxMode = preferences.getBool("tx_mode", false);
+    isTxMode = settings.getBool("tx_mode", false);
 
     // Hardware Init
     pinMode(PIN_RELAY_SOURCE, OUTPUT);
@@ -501,18 +616,77 @@ void setup() {
     ui.screenLoading(isTxMode ? "TX Mode (Headphones)" : "RX Mode (Speaker)");
 
     buttons.begin();
+    spectrum.begin();
+    gen.init();
+    measure.begin();
+    autoEq.begin();
+    gen.configure(genSignalType, genFreqStart, genFreqEnd, genPeriod);
+    ui.setSpectrumRow(settings.getBool("spec_lcd", false));
+    lufs.setEnabled(settings.getBool("lufs_on", false));
+    lufs.setTarget(settings.getInt("lufs_tgt", (int)LUFS_TARGET));
     
     String btName = preferences.getString("bt_name", "ESPDSP-Receiver");
     bt.init(btName);
 
     // Load Settings
-    volume = preferences.getInt("vol", 15);
+    volume = settings.getInt("vol", 15);
     dsp.setVolume(volume);
-    dsp.loudnessEnabled = preferences.getBool("loud", false);
-    dsp.stereoExpand = preferences.getBool("expand", false);
+    dsp.loudnessEnabled = settings.getBool("loud", false);
+    dsp.loudnessLevelMode = settings.getBool("loud_lvl", false);
+    dsp.stereoExpand = settings.getBool("expand", false);
+    loadCrossoverConfig(); // Before switchMode: decides the I2S1 routing
+    loadMultibandConfig();
+    loadDelayConfig();
+
+    // Measure DSP stage cost (audio is not running yet)
+    {
+        Limiter* lim = new Limiter();
+        lim->init();
+        bench.run("limiter", LIMITER_CYCLE_BUDGET, [&](float& l, float& r) { lim->process(l, r); });
+        delete lim;
+
+        RIAA_Engine* ri = new RIAA_Engine();
+        ri->init(true);
+        bench.runBlock("riaa", RIAA_CYCLE_BUDGET, [&](float* l, float* r, int n) { ri->processBlock(l, r, n); });
+        delete ri;
+
+        DolbyB_Engine* db = new DolbyB_Engine(); // Same cost at any level (no branches on it)
+        db->init();
+        bench.runBlock("dolbyB", DOLBY_B_CYCLE_BUDGET, [&](float* l, float* r, int n) { db->processBlock(l, r, n); });
+        delete db;
+        DolbyC_Engine* dc = new DolbyC_Engine();
+        dc->init();
+        bench.runBlock("dolbyC", DOLBY_C_CYCLE_BUDGET, [&](float* l, float* r, int n) { dc->processBlock(l, r, n); });
+        delete dc;
+        DBX_Engine* dx = new DBX_Engine();
+        dx->init();
+        bench.runBlock("dbx", DBX_CYCLE_BUDGET, [&](float* l, float* r, int n) { dx->processBlock(l, r, n); });
+        delete dx;
+
+        Crossover* xo = new Crossover();
+        xo->apply();
+        bench.run("xover", XOVER_CYCLE_BUDGET, [&](float& l, float& r) { float a, b; xo->process(l, r, a, b); l += a; });
+        delete xo;
+
+        MultibandComp* mb = new MultibandComp(); // Gain computer runs every ENV_DECIM samples
+        bench.run("mbcomp", MBC_CYCLE_BUDGET, [&](float& l, float& r) { mb->process(l, r); });
+        delete mb;
+
+        // Convolver: cost = FFTs + MACs per partition -> fit 1 and N partitions
+        Convolver* cv = new Convolver();
+        uint32_t one = 0, many = 0;
+        if (cv->loadTest(1))
+            one = bench.run("conv x1", CONV_CYCLE_BUDGET, [&](float& l, float& r) { cv->process(l, r); });
+        if (cv->loadTest(CONV_BENCH_PARTITIONS))
+            many = bench.run("conv x16", CONV_CYCLE_BUDGET, [&](float& l, float& r) { cv->process(l, r); });
+        delete cv;
+        dsp.conv.setTapLimit(Convolver::maxTaps(one, many, CONV_BENCH_PARTITIONS, CONV_CYCLE_BUDGET));
+    }
+    bench.print();
+    Serial.printf("DSP bench: FIR max %d taps\n", dsp.conv.getTapLimit());
 
     // Start Initial Mode
-    int savedMode = preferences.getInt("last_mode", (int)MODE_BT);
+    int savedMode = settings.getInt("last_mode", (int)MODE_BT);
     delay(1000);
     switchMode((OperationMode)savedMode);
 }
@@ -539,5 +713,6 @@ void loop() {
     }
 
     updateDisplay();
+    settings.loop();
     if (wifiActive) server.handleClient();
 }
\ No newline at end of file
@@ -0,0 +1,200 @@
+/*
+ * mbcomp.h - Multiband Dynamics (3-Band Compressor / Expander)
+ *
+ * Logic:
+ * 1. Split: LR4 at freqHigh (mid+low | high), then LR4 at freqLow on the
+ *    lower part (low | mid). The high band goes through the allpass of the
+ *    low split (same phase as low + mid), so the bands sum flat.
+ *    LR4 = two Butterworth sections (Q 0.707), as crossover.h.
+ * 2. Detector: stereo-linked peak max(|l|,|r|) per band, accumulated per
+ *    sample (one compare). Every ENV_DECIM frames the peak goes through
+ *    envStep() (vintage.h), the same attack/release step as BlockEnvelope.
+ *    BlockEnvelope's block API needs the frames up front; the master chain
+ *    runs per sample.
+ * 3. Gain computer in log2 domain (FastLog2) at control rate:
+ *      - compression above threshold (soft knee, ratio)
+ *      - downward expansion below the expander threshold (1:MBC_EXP_RATIO)
+ *    Makeup gain is added in log2, so exp2() gives the whole band gain.
+ * 4. Recombination: l = gLow*low + gMid*mid + gHigh*high, each gain ramped
+ *    linearly across the sub-block. Makeup costs nothing per sample.
+ *
+ * Sits between the EQ and the loudness stage of the master chain.
+ * Requires Biquad and FastLog2: include after vintage.h.
+ */
+
+#ifndef MBCOMP_H
+#define MBCOMP_H
+
+#include <Arduino.h>
+#include <math.h>
+
+// ==========================================
+// CONFIGURATION
+// ==========================================
+#define MBC_BANDS           3
+#define MBC_DEFAULT_LOW     150.0f  // Hz: woofer excursion band
+#define MBC_DEFAULT_HIGH    2500.0f // Hz
+#define MBC_MIN_FREQ        40.0f
+#define MBC_MAX_FREQ        10000.0f
+#define MBC_MIN_RATIO_GAP   2.0f    // freqHigh >= 2 x freqLow (LR4 overlap)
+#define MBC_MAX_MAKEUP_DB   12.0f
+#define MBC_KNEE_DB         6.0f    // Soft knee width
+#define MBC_EXP_RATIO       2.0f    // Downward expander 1:2
+#define MBC_MAX_EXP_DB      30.0f   // Expander range
+#define MBC_EXP_OFF_DB      -90.0f  // Expander threshold at or below: off
+#define MBC_FS              44100.0f
+#define MBC_CYCLE_BUDGET    700     // CPU cycles per stereo sample (9 stereo biquads)
+
+struct MbcBand {
+    float threshDb = -20.0f;    // dBFS (peak)
+    float ratio = 3.0f;         // 1 = off
+    float attackMs = 5.0f;
+    float releaseMs = 150.0f;
+    float makeupDb = 0.0f;
+    float expThreshDb = MBC_EXP_OFF_DB; // Below: downward expansion
+};
+
+class MultibandComp {
+private:
+    FastLog2 fl;
+    Biquad lpHi1, lpHi2, hpHi1, hpHi2;  // Split at freqHigh
+    Biquad lpLo1, lpLo2, hpLo1, hpLo2;  // Split at freqLow
+    Biquad apLo;                        // High band phase match
+
+    // Per band, log2 units (dB / 6.02) unless noted
+    float att[MBC_BANDS], rel[MBC_BANDS];  // Control-rate coefficients
+    float thresh[MBC_BANDS], slope[MBC_BANDS], makeup[MBC_BANDS];
+    float expThresh[MBC_BANDS];
+    float knee = 1.0f, expMin = -5.0f;
+
+    float env[MBC_BANDS];       // Peak envelope (linear, int32 scale)
+    float peak[MBC_BANDS];      // Peak since the last control step
+    float gain[MBC_BANDS];      // Linear, current
+    float step[MBC_BANDS];      // Linear ramp per sample
+    int count = 0;
+
+    volatile float reduction[MBC_BANDS]; // dB, for display (no makeup)
+
+public:
+    bool enabled = false;
+    float freqLow = MBC_DEFAULT_LOW;
+    float freqHigh = MBC_DEFAULT_HIGH;
+    MbcBand band[MBC_BANDS];
+
+    MultibandComp() {
+        fl.init();
+        // Small speakers: hold the bass back harder and faster
+        band[0].threshDb = -24.0f; band[0].ratio = 4.0f;
+        band[0].attackMs = 10.0f;  band[0].releaseMs = 200.0f;
+        band[2].attackMs = 2.0f;   band[2].releaseMs = 80.0f;
+        apply();
+    }
+
+    // Recompute coefficients from the public config (call with the audio paused)
+    void apply() {
+        freqLow = constrain(freqLow, MBC_MIN_FREQ, MBC_MAX_FREQ / MBC_MIN_RATIO_GAP);
+        float minHigh = freqLow * MBC_MIN_RATIO_GAP;
+        freqHigh = constrain(freqHigh, minHigh, MBC_MAX_FREQ);
+
+        lpHi1.setLowPass(freqHigh, 0.7071f);  lpHi2.setLowPass(freqHigh, 0.7071f);
+        hpHi1.setHighPass(freqHigh, 0.7071f); hpHi2.setHighPass(freqHigh, 0.7071f);
+        lpLo1.setLowPass(freqLow, 0.7071f);   lpLo2.setLowPass(freqLow, 0.7071f);
+        hpLo1.setHighPass(freqLow, 0.7071f);  hpLo2.setHighPass(freqLow, 0.7071f);
+        apLo.setAllPass(freqLow, 0.7071f);    // LR4 sum = 2nd order allpass
+
+        const float toLog2 = 1.0f / 6.0206f;
+        const float ctlRate = MBC_FS / ENV_DECIM;
+        knee = MBC_KNEE_DB * toLog2;
+        expMin = -MBC_MAX_EXP_DB * toLog2;
+        for (int b = 0; b < MBC_BANDS; b++) {
+            MbcBand& p = band[b];
+            p.ratio = constrain(p.ratio, 1.0f, 20.0f);
+            p.makeupDb = constrain(p.makeupDb, 0.0f, MBC_MAX_MAKEUP_DB);
+            p.attackMs = constrain(p.attackMs, 0.5f, 200.0f);
+            p.releaseMs = constrain(p.releaseMs, p.attackMs, 2000.0f);
+
+            att[b] = envCoef(p.attackMs, ctlRate);
+            rel[b] = envCoef(p.releaseMs, ctlRate);
+            // Level in log2 of the int32-scale peak: 0 dBFS = 31
+            thresh[b] = p.threshDb * toLog2 + 31.0f;
+            expThresh[b] = (p.expThreshDb <= MBC_EXP_OFF_DB) ? -1000.0f : p.expThreshDb * toLog2 + 31.0f;
+            slope[b] = 1.0f / p.ratio - 1.0f;
+            makeup[b] = p.makeupDb * toLog2;
+        }
+        reset();
+    }
+
+    void reset() {
+        lpHi1.resetState(); lpHi2.resetState(); hpHi1.resetState(); hpHi2.resetState();
+        lpLo1.resetState(); lpLo2.resetState(); hpLo1.resetState(); hpLo2.resetState();
+        apLo.resetState();
+        for (int b = 0; b < MBC_BANDS; b++) {
+            env[b] = peak[b] = 0.0f;
+            gain[b] = fl.exp2(makeup[b]);
+            step[b] = 0.0f;
+            reduction[b] = 0.0f;
+        }
+        count = 0;
+    }
+
+    // Gain reduction per band (dB, <= 0), display rate
+    float getReduction(int b) { return (b >= 0 && b < MBC_BANDS) ? reduction[b] : 0.0f; }
+
+    // ==========================================
+    // PROCESS (per stereo sample, in place)
+    // ==========================================
+    inline void process(float &l, float &r) {
+        // 1. Split
+        float hl = l, hr = r;
+        hpHi1.process(hl, hr); hpHi2.process(hl, hr);
+        apLo.process(hl, hr);
+        float ll = l, lr = r;
+        lpHi1.process(ll, lr); lpHi2.process(ll, lr);
+        float ml = ll, mr = lr;
+        hpLo1.process(ml, mr); hpLo2.process(ml, mr);
+        lpLo1.process(ll, lr); lpLo2.process(ll, lr);
+
+        // 2. Peak detection (stereo-linked)
+        peak[0] = fmaxf(peak[0], fmaxf(fabsf(ll), fabsf(lr)));
+        peak[1] = fmaxf(peak[1], fmaxf(fabsf(ml), fabsf(mr)));
+        peak[2] = fmaxf(peak[2], fmaxf(fabsf(hl), fabsf(hr)));
+
+        // 4. Recombine with the ramped band gains (makeup included)
+        gain[0] += step[0]; gain[1] += step[1]; gain[2] += step[2];
+        l = gain[0] * ll + gain[1] * ml + gain[2] * hl;
+        r = gain[0] * lr + gain[1] * mr + gain[2] * hr;
+
+        if (++count == ENV_DECIM) control();
+    }
+
+private:
+    // 3. Control rate: envelope + gain computer, new ramp targets
+    void control() {
+        count = 0;
+        for (int b = 0; b < MBC_BANDS; b++) {
+            float e = envStep(env[b], peak[b], att[b], rel[b]);
+            env[b] = e;
+            peak[b] = 0.0f;
+
+            // Floor at -140 dBFS: log2 stays finite
+            float lv = fl.log2(e + 214.7f);
+            float over = lv - thresh[b];
+            float g = 0.0f;
+            if (over > 0.5f * knee) {
+                g = slope[b] * over;
+            } else if (over > -0.5f * knee) {
+                float k = over + 0.5f * knee;
+                g = slope[b] * k * k / (2.0f * knee);
+            }
+            float under = lv - expThresh[b];
+            if (under < 0.0f) g += (MBC_EXP_RATIO - 1.0f) * under;
+            if (g < expMin) g = expMin;
+            reduction[b] = g * 6.0206f;
+
+            float target = fl.exp2(g + makeup[b]);
+            step[b] = (target - gain[b]) * (1.0f / ENV_DECIM);
+        }
+    }
+};
+
+#endif // MBCOMP_H
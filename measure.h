@@ -0,0 +1,481 @@
+/*
+ * measure.h - Acoustic Measurement (Swept-Sine Impulse Response, FR, THD)
+ *
+ * Logic:
+ * 1. Prepare (task): synchronized exponential sweep MEAS_F1 -> MEAS_F2
+ *      x(t) = sin(2*pi*f1*L*(e^(t/L) - 1)),  f1*L integer
+ *    (faded in and out) and its inverse filter: the sweep reversed,
+ *    weighted +6 dB/octave (the sweep's energy falls with 1/f), so
+ *    sweep * inverse = band-limited impulse. The inverse is cut into
+ *    MEAS_BLOCK partitions and transformed (PSRAM).
+ * 2. Play (audio thread): process() writes the sweep to the DAC block and
+ *    stores the ADC block in the same call. Playback and capture share one
+ *    sample counter: the IR peak position is the round-trip latency.
+ * 3. Deconvolve (task, one FFT-sized chunk per step): capture spectra
+ *    (overlap-save), then only the output blocks around the IR are
+ *    accumulated and inverse transformed (uniformly partitioned, as
+ *    convolver.h).
+ * 4. Reference: the same deconvolution of the digital sweep. Every
+ *    response is divided by it: the band edges and fades cancel out.
+ * 5. Analyze:
+ *    - latency: peak of the linear IR
+ *    - frequency response: FFT of the windowed linear IR
+ *    - THD: the k-th harmonic IR arrives L*ln(k) before the linear one;
+ *      THD(f) = sqrt(sum |H_k(k*f)|^2) / |H_1(f)|, k = 2..MEAS_HARMONICS
+ *
+ * Cancel: leaving AUX stops the audio side. cancel() flags the run; the
+ * worker frees the buffers at its next step and ends in MEAS_ERROR.
+ *
+ * Results: 1/6 octave points (dB re digital loopback, THD %), latency,
+ * the linear IR (WAV download). Needs PSRAM (~1.7 MB while measuring).
+ *
+ * Without ARDUINO (host build) there is no worker task: the caller runs
+ * step() itself and feeds process() with the played blocks passed through
+ * a simulated system (test/test_measure.cpp).
+ */
+
+#ifndef MEASURE_H
+#define MEASURE_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <math.h>
+#include <esp_heap_caps.h>
+#include "rfft.h"
+
+// ==========================================
+// CONFIGURATION
+// ==========================================
+#define MEAS_FS             44100.0f
+#define MEAS_F1             20.0f
+#define MEAS_F2             20000.0f
+#define MEAS_SWEEP_MAX      65536   // Sweep length limit (1.49 s)
+#define MEAS_LEVEL          0.25f   // Sweep peak (-12 dBFS)
+#define MEAS_FADE_IN        3072    // Half-Hann fades (samples): start ~1/2 octave,
+#define MEAS_FADE_OUT       256     // end short (the sweep is at MEAS_F2 already)
+#define MEAS_BLOCK          4096    // Deconvolution partition (FFT 2x)
+#define MEAS_MAX_LATENCY    8192    // Peak search range (186 ms)
+#define MEAS_IR_LEN         4096    // Linear IR kept (93 ms)
+#define MEAS_PRE            1024    // Kept before the IR peak (LF band-edge ringing)
+#define MEAS_HARMONICS      5       // THD: 2nd .. 5th
+#define MEAS_HARM_LEN       1024    // Window per harmonic IR (< gap between 4th and 5th)
+#define MEAS_HARM_PRE       256
+#define MEAS_POINTS         61      // 1/6 octave from MEAS_F1
+#define MEAS_INPUT_CH       0       // ADC channel with the microphone (0 = L, 1 = R)
+#define MEAS_TASK_PRIORITY  1
+#define MEAS_TASK_CORE      0       // Audio runs in loop() on core 1
+
+#define MEAS_FFT            (MEAS_BLOCK * 2)
+
+enum MeasState { MEAS_IDLE, MEAS_PREPARE, MEAS_PLAY, MEAS_DECONV, MEAS_REFERENCE, MEAS_ANALYZE, MEAS_DONE, MEAS_ERROR };
+
+class Measurement {
+private:
+    RealFFT fft;
+    float* sweep = nullptr;     // Unit sweep
+    float* capture = nullptr;   // ADC return (normalized), then the reference IR
+    float* filtSpec = nullptr;  // [partition][MEAS_FFT] packed
+    float* capSpec = nullptr;   // [block][MEAS_FFT] packed
+    float* out = nullptr;       // Deconvolved window
+    float* work = nullptr;      // MEAS_FFT
+    float* ir = nullptr;        // Result: linear IR (kept)
+
+    int sweepLen = 0;           // Samples
+    float L = 0.0f;             // Sweep rate constant (samples)
+    int filtParts = 0;
+    int capBlocks = 0;          // = captureLen / MEAS_BLOCK
+    int outFirst = 0, outBlocks = 0; // Output blocks kept (index of the first)
+    int refFirst = 0, refBlocks = 0; // Same for the reference
+    float norm = 1.0f;
+
+    std::atomic<int> state;
+    std::atomic<bool> abort;    // cancel() -> worker: drop the run
+    volatile uint32_t pos = 0;  // Play/capture sample counter
+    int stepIdx = 0;
+#ifdef ARDUINO
+    TaskHandle_t task = nullptr;
+#endif
+
+    // Results
+    float resFreq[MEAS_POINTS];
+    float resDb[MEAS_POINTS];
+    float resThd[MEAS_POINTS];   // %
+    float refPow[MEAS_HARMONICS][MEAS_POINTS]; // Reference |H|^2 at k*f
+    int latency = -1;            // Samples
+    float peakDb = -200.0f;
+
+public:
+    Measurement() : state(MEAS_IDLE), abort(false) {
+        for (int i = 0; i < MEAS_POINTS; i++) {
+            resFreq[i] = MEAS_F1 * powf(2.0f, i / 6.0f);
+            resDb[i] = -200.0f;
+            resThd[i] = 0.0f;
+        }
+    }
+
+    ~Measurement() { release(); heap_caps_free(ir); }
+
+    // Starts the worker task (no buffers yet)
+    void begin() {
+#ifdef ARDUINO
+        if (!task) xTaskCreatePinnedToCore(workerTask, "measure", 4096, this,
+                                           MEAS_TASK_PRIORITY, &task, MEAS_TASK_CORE);
+#endif
+    }
+
+    // Allocates and starts preparing; the sweep plays as soon as it is ready.
+    // Returns false if busy or out of memory.
+    bool start() {
+        if (isBusy()) return false;
+        release();
+
+        // Synchronized sweep: f1*L integer, length from the ratio
+        float lnRatio = logf(MEAS_F2 / MEAS_F1);
+        int k = (int)(MEAS_F1 * MEAS_SWEEP_MAX / MEAS_FS / lnRatio);
+        if (k < 1) k = 1;
+        L = k * MEAS_FS / MEAS_F1;
+        sweepLen = (int)(L * lnRatio);
+        filtParts = (sweepLen + MEAS_BLOCK - 1) / MEAS_BLOCK;
+
+        // Output window: highest harmonic IR (latency 0) .. linear IR (max latency)
+        int base = sweepLen - 1; // Output index of a zero-latency peak
+        int first = base - harmOffset(MEAS_HARMONICS) - MEAS_PRE;
+        int last = base + MEAS_MAX_LATENCY + MEAS_IR_LEN;
+        outFirst = first / MEAS_BLOCK;
+        outBlocks = last / MEAS_BLOCK - outFirst + 1;
+        capBlocks = last / MEAS_BLOCK + 1;
+        refFirst = (base - MEAS_PRE) / MEAS_BLOCK;
+        refBlocks = (base - MEAS_PRE + MEAS_IR_LEN - 1) / MEAS_BLOCK - refFirst + 1;
+
+        sweep = psram(sweepLen);
+        capture = psram(capBlocks * MEAS_BLOCK);
+        filtSpec = psram(filtParts * MEAS_FFT);
+        capSpec = psram(capBlocks * MEAS_FFT);
+        out = psram(outBlocks * MEAS_BLOCK);
+        work = (float*)malloc(sizeof(float) * MEAS_FFT);
+        if (!work) work = psram(MEAS_FFT);
+        if (!ir) ir = psram(MEAS_IR_LEN);
+        if (!sweep || !capture || !filtSpec || !capSpec || !out || !work || !ir || !fft.begin(MEAS_FFT)) {
+            release();
+            state = MEAS_ERROR;
+            return false;
+        }
+
+        latency = -1;
+        pos = 0;
+        stepIdx = 0;
+        abort.store(false, std::memory_order_relaxed);
+        state.store(MEAS_PREPARE, std::memory_order_release);
+        wake();
+        return true;
+    }
+
+    bool isBusy() {
+        int s = state.load(std::memory_order_acquire);
+        return s == MEAS_PREPARE || s == MEAS_PLAY || s == MEAS_DECONV || s == MEAS_REFERENCE || s == MEAS_ANALYZE;
+    }
+
+    bool isPlaying() { return state.load(std::memory_order_acquire) == MEAS_PLAY && !abort.load(std::memory_order_acquire); }
+
+    // Audio thread, when the input goes away (mode switch). Only the sweep
+    // needs the audio side: a run past the capture finishes on its own.
+    void cancel() {
+        int s = state.load(std::memory_order_acquire);
+        if (s != MEAS_PREPARE && s != MEAS_PLAY) return;
+        abort.store(true, std::memory_order_release);
+        wake();
+    }
+
+    int getState() { return state.load(std::memory_order_acquire); }
+
+    // 0..100 over the whole run
+    int getProgress() {
+        switch (state.load(std::memory_order_acquire)) {
+            case MEAS_PREPARE: return 10 * stepIdx / (filtParts + 1);
+            case MEAS_PLAY:    return 10 + 50 * pos / (capBlocks * MEAS_BLOCK);
+            case MEAS_DECONV:  return 60 + 30 * stepIdx / (capBlocks + outBlocks);
+            case MEAS_REFERENCE: return 90 + 5 * stepIdx / (refFirst + 2 * refBlocks);
+            case MEAS_ANALYZE: return 95;
+            case MEAS_DONE:    return 100;
+            default:           return 0;
+        }
+    }
+
+    // ==========================================
+    // AUDIO SIDE (while isPlaying)
+    // ==========================================
+    // In place, interleaved int32: in = ADC block, out = DAC block (sweep on both)
+    void process(int32_t* buf, int frames) {
+        if (!isPlaying()) return;
+        uint32_t p = pos;
+        uint32_t len = capBlocks * MEAS_BLOCK;
+        for (int i = 0; i < frames; i++, p++) {
+            if (p < len) capture[p] = buf[i * 2 + MEAS_INPUT_CH] * (1.0f / 2147483648.0f);
+            float s = (p < (uint32_t)sweepLen) ? sweep[p] * (MEAS_LEVEL * 2147483647.0f) : 0.0f;
+            buf[i * 2] = buf[i * 2 + 1] = (int32_t)s;
+        }
+        pos = p;
+        if (p >= len) {
+            stepIdx = 0;
+            state.store(MEAS_DECONV, std::memory_order_release);
+            wake();
+        }
+    }
+
+    // ==========================================
+    // WORKER (one chunk per call, any task)
+    // ==========================================
+    // Returns true while there is more work for the task
+    bool step() {
+        int s = state.load(std::memory_order_acquire);
+        if (abort.load(std::memory_order_acquire) && (s == MEAS_PREPARE || s == MEAS_PLAY)) {
+            release(); // The audio side stopped at cancel()
+            state.store(MEAS_ERROR, std::memory_order_release);
+            return false;
+        }
+        switch (s) {
+            case MEAS_PREPARE:
+                if (stepIdx == 0) buildSweep();
+                else buildFilterPartition(stepIdx - 1);
+                if (++stepIdx > filtParts) {
+                    pos = 0;
+                    state.store(MEAS_PLAY, std::memory_order_release);
+                }
+                return true;
+
+            case MEAS_DECONV:
+                if (stepIdx < capBlocks) inputSpectrum(capture, capBlocks * MEAS_BLOCK, 1.0f, stepIdx);
+                else outputBlock(outFirst + stepIdx - capBlocks, capBlocks, out + (stepIdx - capBlocks) * MEAS_BLOCK);
+                if (++stepIdx >= capBlocks + outBlocks) {
+                    stepIdx = 0;
+                    state.store(MEAS_REFERENCE, std::memory_order_release);
+                }
+                return true;
+
+            case MEAS_REFERENCE: {
+                // Digital loopback at the played level. The capture buffer is free now.
+                int inBlocks = refFirst + refBlocks;
+                if (stepIdx < inBlocks) inputSpectrum(sweep, sweepLen, MEAS_LEVEL, stepIdx);
+                else outputBlock(refFirst + stepIdx - inBlocks, inBlocks, capture + (stepIdx - inBlocks) * MEAS_BLOCK);
+                if (++stepIdx >= inBlocks + refBlocks) state.store(MEAS_ANALYZE, std::memory_order_release);
+                return true;
+            }
+
+            case MEAS_ANALYZE:
+                analyze();
+                release();
+                state.store(latency >= 0 ? MEAS_DONE : MEAS_ERROR, std::memory_order_release);
+                return false;
+
+            default:
+                return false;
+        }
+    }
+
+    // ==========================================
+    // RESULTS (valid in MEAS_DONE)
+    // ==========================================
+    int getPointCount() { return MEAS_POINTS; }
+    float getFreq(int i) { return resFreq[i]; }
+    float getDb(int i) { return resDb[i]; }
+    float getThd(int i) { return resThd[i]; }
+    int getLatency() { return latency; }
+    float getLatencyMs() { return latency * 1000.0f / MEAS_FS; }
+    float getPeakDb() { return peakDb; }
+
+    // Linear IR from MEAS_PRE samples before the peak, loopback = 1.0 (not
+    // divided by the reference: band-limited MEAS_F1 .. MEAS_F2)
+    const float* getIR() { return (state.load() == MEAS_DONE) ? ir : nullptr; }
+    int getIRLength() { return MEAS_IR_LEN; }
+
+private:
+    static float* psram(int count) {
+        float* p = (float*)heap_caps_malloc(sizeof(float) * count, MALLOC_CAP_SPIRAM);
+        return p;
+    }
+
+    // Everything but the results
+    void release() {
+        heap_caps_free(sweep); sweep = nullptr;
+        heap_caps_free(capture); capture = nullptr;
+        heap_caps_free(filtSpec); filtSpec = nullptr;
+        heap_caps_free(capSpec); capSpec = nullptr;
+        heap_caps_free(out); out = nullptr;
+        free(work); work = nullptr; // malloc and heap_caps_malloc share the heap
+        fft.end();
+    }
+
+    // Hands the next chunk to the worker task
+    void wake() {
+#ifdef ARDUINO
+        if (task) xTaskNotifyGive(task);
+#endif
+    }
+
+    // Arrival of the k-th harmonic IR before the linear one (samples)
+    int harmOffset(int k) { return (int)lroundf(L * logf((float)k)); }
+
+    // 1. Sweep + normalization (inverse filter gain at 1 kHz)
+    void buildSweep() {
+        double f1L = MEAS_F1 / MEAS_FS * L; // Integer (synchronized)
+        for (int n = 0; n < sweepLen; n++) {
+            double c = f1L * (exp(n / (double)L) - 1.0); // Cycles: keep the fraction exact
+            float s = sinf(2.0f * PI * (float)(c - floor(c)));
+            int tail = sweepLen - 1 - n;
+            if (n < MEAS_FADE_IN) s *= 0.5f - 0.5f * cosf(PI * n / MEAS_FADE_IN);
+            if (tail < MEAS_FADE_OUT) s *= 0.5f - 0.5f * cosf(PI * tail / MEAS_FADE_OUT);
+            sweep[n] = s;
+        }
+
+        // |X(w) * F(w)| at 1 kHz (flat across the band), F(w) from the reversed sweep
+        float w = 2.0f * PI * 1000.0f / MEAS_FS;
+        float xr = 0, xi = 0, fr = 0, fi = 0;
+        for (int n = 0; n < sweepLen; n++) {
+            float c = cosf(w * n), s = sinf(w * n);
+            xr += sweep[n] * c; xi -= sweep[n] * s;
+            float f = inverseAt(n);
+            fr += f * c; fi -= f * s;
+        }
+        norm = 1.0f / (sqrtf((xr * xr + xi * xi) * (fr * fr + fi * fi)) * MEAS_LEVEL);
+    }
+
+    // Reversed sweep, amplitude proportional to the swept frequency (1 at f2)
+    inline float inverseAt(int n) {
+        int t = sweepLen - 1 - n; // Time in the original sweep
+        return sweep[t] * expf(-n / L);
+    }
+
+    void buildFilterPartition(int p) {
+        int start = p * MEAS_BLOCK;
+        for (int i = 0; i < MEAS_BLOCK; i++) {
+            int n = start + i;
+            work[i] = (n < sweepLen) ? inverseAt(n) : 0.0f;
+        }
+        memset(work + MEAS_BLOCK, 0, sizeof(float) * MEAS_BLOCK);
+        fft.forward(work);
+        memcpy(filtSpec + p * MEAS_FFT, work, sizeof(float) * MEAS_FFT);
+    }
+
+    // 3. Overlap-save input: [previous block | block j] of src (zero past len)
+    void inputSpectrum(const float* src, int len, float gain, int j) {
+        for (int i = 0; i < MEAS_FFT; i++) {
+            int n = (j - 1) * MEAS_BLOCK + i;
+            work[i] = (n >= 0 && n < len) ? src[n] * gain : 0.0f;
+        }
+        fft.forward(work);
+        memcpy(capSpec + j * MEAS_FFT, work, sizeof(float) * MEAS_FFT);
+    }
+
+    // Output block k = last half of IFFT(sum over p of X[k-p] * F[p]), X[j < inBlocks]
+    void outputBlock(int k, int inBlocks, float* dst) {
+        memset(work, 0, sizeof(float) * MEAS_FFT);
+        for (int p = 0; p < filtParts; p++) {
+            int j = k - p;
+            if (j < 0) break;
+            if (j >= inBlocks) continue;
+            const float* x = capSpec + j * MEAS_FFT;
+            const float* f = filtSpec + p * MEAS_FFT;
+            work[0] += x[0] * f[0]; // DC
+            work[1] += x[1] * f[1]; // Nyquist
+            for (int b = 2; b < MEAS_FFT; b += 2) {
+                work[b]     += x[b] * f[b] - x[b + 1] * f[b + 1];
+                work[b + 1] += x[b] * f[b + 1] + x[b + 1] * f[b];
+            }
+        }
+        fft.inverse(work);
+        float g = norm * 2.0f / MEAS_FFT; // Unscaled inverse: N/2
+        for (int i = 0; i < MEAS_BLOCK; i++) dst[i] = work[MEAS_BLOCK + i] * g;
+    }
+
+    // 5. Peak, IR, response, distortion
+    void analyze() {
+        int base = sweepLen - 1 - outFirst * MEAS_BLOCK; // Zero latency in 'out'
+        int peak = base;
+        float best = 0.0f;
+        for (int i = base; i < base + MEAS_MAX_LATENCY; i++) {
+            float a = fabsf(out[i]);
+            if (a > best) { best = a; peak = i; }
+        }
+        if (best < 1e-6f) { latency = -1; return; } // No return signal (-120 dB)
+        latency = peak - base;
+        peakDb = 20.0f * log10f(best);
+
+        // 1. Reference response at f .. MEAS_HARMONICS * f
+        const float* ref = capture + (sweepLen - 1 - MEAS_PRE) - refFirst * MEAS_BLOCK;
+        windowed(ref, MEAS_IR_LEN, MEAS_PRE, work);
+        windowSpectrum(work, MEAS_IR_LEN);
+        for (int k = 1; k <= MEAS_HARMONICS; k++) {
+            for (int i = 0; i < MEAS_POINTS; i++) {
+                refPow[k - 1][i] = (resFreq[i] * k < MEAS_FS * 0.5f) ? bandPower(resFreq[i] * k) + 1e-20f : 0.0f;
+            }
+        }
+
+        // 2. Linear IR (kept), response relative to the reference
+        windowed(out + peak - MEAS_PRE, MEAS_IR_LEN, MEAS_PRE, ir);
+        windowSpectrum(ir, MEAS_IR_LEN);
+        float h1[MEAS_POINTS];
+        for (int i = 0; i < MEAS_POINTS; i++) {
+            h1[i] = bandPower(resFreq[i]) / refPow[0][i] + 1e-20f;
+            resDb[i] = 10.0f * log10f(h1[i]);
+            resThd[i] = 0.0f;
+        }
+
+        // 3. Harmonic IRs
+        for (int k = 2; k <= MEAS_HARMONICS; k++) {
+            windowed(out + peak - harmOffset(k) - MEAS_HARM_PRE, MEAS_HARM_LEN, MEAS_HARM_PRE, work);
+            windowSpectrum(work, MEAS_HARM_LEN);
+            for (int i = 0; i < MEAS_POINTS; i++) {
+                if (refPow[k - 1][i] > 0.0f) resThd[i] += bandPower(resFreq[i] * k) / refPow[k - 1][i];
+            }
+        }
+        for (int i = 0; i < MEAS_POINTS; i++) resThd[i] = 100.0f * sqrtf(resThd[i] / h1[i]);
+    }
+
+    // dst = src[0..len): half-Hann in over pre, out over the last quarter
+    void windowed(const float* src, int len, int pre, float* dst) {
+        int fade = len / 4;
+        for (int i = 0; i < len; i++) {
+            float w = 1.0f;
+            int tail = len - 1 - i;
+            if (i < pre) w = 0.5f - 0.5f * cosf(PI * i / pre);
+            else if (tail < fade) w = 0.5f - 0.5f * cosf(PI * tail / fade);
+            dst[i] = src[i] * w;
+        }
+    }
+
+    // work = spectrum of src[0..len) zero-padded to MEAS_FFT
+    void windowSpectrum(const float* src, int len) {
+        if (src != work) memcpy(work, src, sizeof(float) * len);
+        memset(work + len, 0, sizeof(float) * (MEAS_FFT - len));
+        fft.forward(work);
+    }
+
+    // Mean |H|^2 over +/- 1/12 octave (at least one bin)
+    float bandPower(float f) {
+        const float df = MEAS_FS / MEAS_FFT;
+        int lo = (int)ceilf(f * 0.9439f / df);
+        int hi = (int)floorf(f * 1.0595f / df);
+        if (hi < lo) lo = hi = (int)lroundf(f / df);
+        if (lo < 1) lo = 1;
+        if (hi > MEAS_FFT / 2 - 1) hi = MEAS_FFT / 2 - 1;
+        if (hi < lo) return 0.0f;
+        float sum = 0.0f;
+        for (int b = lo; b <= hi; b++) sum += work[2 * b] * work[2 * b] + work[2 * b + 1] * work[2 * b + 1];
+        return sum / (hi - lo + 1);
+    }
+
+#ifdef ARDUINO
+    static void workerTask(void* arg) {
+        Measurement* m = (Measurement*)arg;
+        for (;;) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            while (m->step()) {
+                if (m->isPlaying()) ulTaskNotifyTake(pdTRUE, portMAX_DELAY); // Until captured
+                else vTaskDelay(1); // Chunked: leave the core to others
+            }
+        }
+    }
+#endif
+};
+
+#endif // MEASURE_H
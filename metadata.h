@@ -0,0 +1,174 @@
+/*
+ * metadata.h - Lock-free AVRCP Track Info Mailbox (Seqlock, no heap)
+ *
+ * Logic:
+ * 1. The BT stack task is the only writer. It edits a private working copy
+ *    and publishes it into the inactive slot of a double buffer.
+ * 2. Publishing bumps a sequence counter by 2 (even = stable).
+ * 3. Readers (UI, web) copy the active slot and re-check the counter.
+ *    If it moved during the copy the snapshot is retried (or dropped).
+ *
+ * The writer never waits for readers and nothing is allocated: the
+ * callbacks only copy into fixed char arrays.
+ *
+ * Integration:
+ * 1. BT callbacks: meta.setText(id, text), meta.setPlayState(s), meta.setPosition(ms)
+ * 2. UI: TrackInfo t; if (meta.read(t)) { ... }
+ */
+
+#ifndef METADATA_H
+#define METADATA_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// ==========================================
+// CONFIGURATION
+// ==========================================
+#define META_TEXT_LEN      64    // Per field, including the terminator
+#define META_READ_RETRIES  4     // Snapshot attempts before giving up
+
+// AVRCP attribute ids (esp_avrc_md_attr_mask_t)
+#define META_ATTR_TITLE         0x01
+#define META_ATTR_ARTIST        0x02
+#define META_ATTR_ALBUM         0x04
+#define META_ATTR_PLAYING_TIME  0x40  // Track length in ms, as text
+
+// AVRCP play status (esp_avrc_playback_stat_t)
+enum PlayState {
+    PLAY_STOPPED = 0,
+    PLAY_PLAYING = 1,
+    PLAY_PAUSED  = 2,
+    PLAY_FWD_SEEK = 3,
+    PLAY_REV_SEEK = 4
+};
+
+#define META_POS_UNKNOWN  0xFFFFFFFF
+
+struct TrackInfo {
+    char title[META_TEXT_LEN];
+    char artist[META_TEXT_LEN];
+    char album[META_TEXT_LEN];
+    uint8_t playState;
+    uint32_t positionMs;   // Last reported position (META_POS_UNKNOWN if none)
+    uint32_t durationMs;   // 0 if unknown
+    uint32_t stampMs;      // millis() when positionMs was reported
+
+    // Position extrapolated to 'now' while playing
+    uint32_t positionAt(uint32_t now) const {
+        if (positionMs == META_POS_UNKNOWN) return META_POS_UNKNOWN;
+        uint32_t pos = positionMs;
+        if (playState == PLAY_PLAYING) pos += now - stampMs;
+        if (durationMs && pos > durationMs) pos = durationMs;
+        return pos;
+    }
+};
+
+class MetadataMailbox {
+private:
+    TrackInfo slot[2];
+    std::atomic<uint32_t> seq;  // Even; slot[(seq >> 1) & 1] is the published one
+    TrackInfo work;             // Writer-only working copy
+
+public:
+    // Statistics
+    volatile uint32_t readRetries = 0;
+
+    MetadataMailbox() : seq(0) {
+        reset(work);
+        slot[0] = work;
+        slot[1] = work;
+    }
+
+    // ==========================================
+    // WRITER (BT task only)
+    // ==========================================
+    void clear() {
+        reset(work);
+        publish();
+    }
+
+    void setText(uint8_t id, const uint8_t* text) {
+        const char* s = (const char*)text;
+        if (!s) s = "";
+        switch (id) {
+            case META_ATTR_TITLE:
+                // New track: the old position is meaningless
+                if (strncmp(work.title, s, META_TEXT_LEN - 1) != 0) {
+                    work.positionMs = META_POS_UNKNOWN;
+                }
+                copyText(work.title, s);
+                break;
+            case META_ATTR_ARTIST: copyText(work.artist, s); break;
+            case META_ATTR_ALBUM:  copyText(work.album, s); break;
+            case META_ATTR_PLAYING_TIME: work.durationMs = strtoul(s, nullptr, 10); break;
+            default: return;
+        }
+        publish();
+    }
+
+    void setPlayState(uint8_t state) {
+        // Freeze the extrapolated position when leaving PLAYING
+        uint32_t now = millis();
+        if (work.positionMs != META_POS_UNKNOWN) {
+            work.positionMs = work.positionAt(now);
+            work.stampMs = now;
+        }
+        work.playState = state;
+        publish();
+    }
+
+    void setPosition(uint32_t ms) {
+        work.positionMs = ms;
+        work.stampMs = millis();
+        publish();
+    }
+
+    // ==========================================
+    // READER (any task)
+    // ==========================================
+    // Returns false if no consistent snapshot was obtained ('out' is then untouched)
+    bool read(TrackInfo& out) {
+        for (int attempt = 0; attempt < META_READ_RETRIES; attempt++) {
+            uint32_t s1 = seq.load(std::memory_order_acquire);
+            TrackInfo tmp;
+            memcpy(&tmp, &slot[(s1 >> 1) & 1], sizeof(TrackInfo));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint32_t s2 = seq.load(std::memory_order_relaxed);
+
+            // Unchanged: the slot was not reused by the writer during the copy
+            if (s1 == s2) {
+                out = tmp;
+                return true;
+            }
+            readRetries++;
+        }
+        return false;
+    }
+
+    // Changes every time the writer publishes
+    uint32_t version() const { return seq.load(std::memory_order_acquire) >> 1; }
+
+private:
+    static void reset(TrackInfo& t) {
+        memset(&t, 0, sizeof(TrackInfo));
+        t.playState = PLAY_STOPPED;
+        t.positionMs = META_POS_UNKNOWN;
+    }
+
+    static void copyText(char* dst, const char* src) {
+        strncpy(dst, src, META_TEXT_LEN - 1);
+        dst[META_TEXT_LEN - 1] = '\0';
+    }
+
+    // Copy the working record into the inactive slot, then flip
+    void publish() {
+        uint32_t s = seq.load(std::memory_order_relaxed);
+        // The previous flip must be visible before this slot is reused
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&slot[((s >> 1) + 1) & 1], &work, sizeof(TrackInfo));
+        seq.store(s + 2, std::memory_order_release);
+    }
+};
+
+#endif // METADATA_H
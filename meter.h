@@ -0,0 +1,188 @@
+/*
+ * meter.h - Level Meter (Block Peak/RMS + VU/PPM Ballistics)
+ *
+ * Logic:
+ * 1. Audio side: feed() runs once per block on the interleaved int32 buffer.
+ *    Per sample it only does abs/max and a multiply-accumulate, no shared writes.
+ * 2. Per block it publishes:
+ *    - running sums of squares (seqlock, 64-bit)
+ *    - the peak since the last read (atomic max, consumed with exchange)
+ * 3. UI side: update() at display rate turns the deltas into RMS/peak and
+ *    applies the ballistics:
+ *    - VU:  RMS through a one-pole integrator (99% in 300 ms)
+ *    - PPM: instant attack, linear release in dB/s, with peak hold
+ *
+ * Integration:
+ * 1. Audio task: meter.feed(buffer, frames);
+ * 2. UI task (every frame): meter.update(); ui.drawVUMeter(meter.getBar(0), meter.getBar(1), ..)
+ */
+
+#ifndef METER_H
+#define METER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <math.h>
+
+// ==========================================
+// CONFIGURATION
+// ==========================================
+#define METER_FLOOR_DB          -40.0f  // Bottom of the LCD bar
+#define METER_VU_TAU_MS         65.0f   // 99% of the step in 300 ms
+#define METER_PPM_RELEASE_DB_S  11.8f   // 20 dB in 1.7 s (IEC 60268-10 Type I)
+#define METER_PEAK_HOLD_MS      1000
+
+enum MeterMode {
+    METER_VU,
+    METER_PPM
+};
+
+class Meter {
+private:
+    // --- Audio side (single writer) ---
+    struct Totals {
+        uint64_t sumSq[2];   // Sum of (sample >> 16)^2, wraps (deltas stay valid)
+        uint32_t frames;
+    };
+    Totals acc = {{0, 0}, 0};
+    Totals pub = {{0, 0}, 0};
+    std::atomic<uint32_t> seq;
+    std::atomic<int32_t> peak[2];  // Max |sample >> 16| since the last update()
+
+    // --- UI side ---
+    Totals last = {{0, 0}, 0};
+    uint32_t lastUpdate = 0;
+    float vuLin[2] = {0, 0};
+    float ppmDb[2] = {METER_FLOOR_DB, METER_FLOOR_DB};
+    float holdDb[2] = {METER_FLOOR_DB, METER_FLOOR_DB};
+    uint32_t holdTime[2] = {0, 0};
+    float rmsDb[2] = {METER_FLOOR_DB, METER_FLOOR_DB};
+    MeterMode mode = METER_VU;
+
+public:
+    Meter() : seq(0) {
+        peak[0].store(0);
+        peak[1].store(0);
+    }
+
+    void setMode(MeterMode m) { mode = m; }
+
+    // ==========================================
+    // AUDIO SIDE (once per block)
+    // ==========================================
+    // buf: interleaved L/R int32 samples, frames: stereo frames
+    void feed(const int32_t* buf, int frames) {
+        int32_t pl = 0, pr = 0;
+        uint64_t sl = 0, sr = 0;
+
+        for (int i = 0; i < frames; i++) {
+            int32_t l = buf[i * 2] >> 16;
+            int32_t r = buf[i * 2 + 1] >> 16;
+            int32_t al = abs(l);
+            int32_t ar = abs(r);
+            pl = (al > pl) ? al : pl;
+            pr = (ar > pr) ? ar : pr;
+            sl += (uint32_t)(l * l);
+            sr += (uint32_t)(r * r);
+        }
+
+        acc.sumSq[0] += sl;
+        acc.sumSq[1] += sr;
+        acc.frames += frames;
+
+        // Publish the totals (seqlock: odd while writing)
+        uint32_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        pub = acc;
+        seq.store(s + 2, std::memory_order_release);
+
+        raisePeak(peak[0], pl);
+        raisePeak(peak[1], pr);
+    }
+
+    // ==========================================
+    // UI SIDE (display rate)
+    // ==========================================
+    void update() {
+        uint32_t now = millis();
+        float dt = (float)(now - lastUpdate);
+        lastUpdate = now;
+        if (dt > 1000.0f) dt = 1000.0f; // First call / long stall
+
+        Totals t;
+        if (!readTotals(t)) return; // Writer busy: keep the last reading
+
+        uint32_t frames = t.frames - last.frames;
+        float vuCoef = 1.0f - expf(-dt / METER_VU_TAU_MS);
+        float release = METER_PPM_RELEASE_DB_S * dt * 0.001f;
+
+        for (int ch = 0; ch < 2; ch++) {
+            // RMS over the interval (0 dBFS sine = -3 dB RMS)
+            float rms = 0.0f;
+            if (frames > 0) {
+                uint64_t d = t.sumSq[ch] - last.sumSq[ch];
+                rms = sqrtf((float)d / (float)frames) * (1.0f / 32768.0f);
+            }
+            rmsDb[ch] = toDb(rms);
+
+            // VU: integrate the RMS
+            vuLin[ch] += (rms - vuLin[ch]) * vuCoef;
+
+            // PPM: instant attack, slow release
+            float pk = toDb((float)peak[ch].exchange(0) * (1.0f / 32768.0f));
+            ppmDb[ch] -= release;
+            if (pk > ppmDb[ch]) ppmDb[ch] = pk;
+            if (ppmDb[ch] < METER_FLOOR_DB) ppmDb[ch] = METER_FLOOR_DB;
+
+            if (ppmDb[ch] >= holdDb[ch] || now - holdTime[ch] > METER_PEAK_HOLD_MS) {
+                holdDb[ch] = ppmDb[ch];
+                holdTime[ch] = now;
+            }
+        }
+        last = t;
+    }
+
+    // Readings in dBFS
+    float getVU(int ch)   { return toDb(vuLin[ch]); }
+    float getPPM(int ch)  { return ppmDb[ch]; }
+    float getHold(int ch) { return holdDb[ch]; }
+    float getRMS(int ch)  { return rmsDb[ch]; }
+
+    // 0-100 for the LCD bar (METER_FLOOR_DB .. 0 dBFS)
+    int getBar(int ch) {
+        float db = (mode == METER_PPM) ? ppmDb[ch] : getVU(ch);
+        int v = (int)((db - METER_FLOOR_DB) * (100.0f / -METER_FLOOR_DB));
+        return constrain(v, 0, 100);
+    }
+
+private:
+    static float toDb(float lin) {
+        if (lin <= 1e-5f) return METER_FLOOR_DB;
+        float db = 20.0f * log10f(lin);
+        return (db < METER_FLOOR_DB) ? METER_FLOOR_DB : db;
+    }
+
+    // Writer only raises; the reader resets with exchange(0).
+    // A failed CAS means the reader just took it: retry from the new value.
+    static void raisePeak(std::atomic<int32_t>& p, int32_t v) {
+        int32_t cur = p.load(std::memory_order_relaxed);
+        while (v > cur && !p.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+    }
+
+    bool readTotals(Totals& out) {
+        for (int attempt = 0; attempt < 4; attempt++) {
+            uint32_t s1 = seq.load(std::memory_order_acquire);
+            if (s1 & 1) continue;
+            Totals tmp = pub;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq.load(std::memory_order_relaxed) == s1) {
+                out = tmp;
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+#endif // METER_H
@@ -2,6 +2,8 @@
 #define PHBUTTONS_H
 
 #include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
 #include "pindef.h"
 
 // --- CONSTANTS FOR TIMING ---
@@ -46,97 +48,93 @@ extern void actionToggleLoudness();
 extern void actionBtPairing();
 
 // ==========================================
-// CLASS: SINGLE BUTTON HANDLER
+// INPUT PIPELINE
 // ==========================================
-class SmartButton {
-private:
-    uint8_t pin;
-    bool state = HIGH;
-    bool lastState = HIGH;
-    unsigned long pressStartTime = 0;
-    bool isLongPressed = false;
-    bool waitingForDoubleClick = false;
-    unsigned long lastClickTime = 0;
-
-public:
-    // Events flags
-    bool justPressed = false;
-    bool justReleased = false;
-    bool justLongPressed = false;
-    bool justDoubleClicked = false;
-    bool isHeld = false; // For rapid volume
-    unsigned long lastChangeTime = 0;
-
-    SmartButton(uint8_t p) : pin(p) {}
-
-    void begin() {
-        pinMode(pin, INPUT_PULLUP);
-    }
-
-    void update() {
-        // Reset single-shot events
-        justPressed = false;
-        justReleased = false;
-        justLongPressed = false;
-        justDoubleClicked = false;
-
-        bool reading = digitalRead(pin);
+// GPIO ISR -> edge ring (lock-free) -> gesture task -> gesture queue -> update()
+// The gesture task sleeps until an edge arrives or a timer (debounce,
+// long press, double click window, repeat) is due: zero CPU while idle.
+#define BTN_COUNT           5
+#define BTN_EDGE_RING       32    // Power of two
+#define BTN_GESTURE_QUEUE   16
+#define BTN_TASK_PRIORITY   1     // Below the audio/BT tasks
+#define BTN_TASK_CORE       0
+
+enum ButtonId {
+    BTN_ID_VOL_UP,
+    BTN_ID_VOL_DOWN,
+    BTN_ID_SOURCE,
+    BTN_ID_PRESET,
+    BTN_ID_PAIR
+};
 
-        // Debounce
-        if (reading != lastState) {
-            lastChangeTime = millis();
-        }
+enum ButtonGesture {
+    GESTURE_CLICK,      // Single click (after the double click window if enabled)
+    GESTURE_DOUBLE,     // Double click
+    GESTURE_LONG,       // Held > LONG_PRESS_MS
+    GESTURE_REPEAT,     // Still held after the long press, every RAPID_VOL_MS
+    GESTURE_COMBO       // VOL+ and VOL- held together > LONG_PRESS_MS
+};
 
-        if ((millis() - lastChangeTime) > DEBOUNCE_MS) {
-            if (reading != state) {
-                state = reading;
+// The level is not captured here: it bounces. The task samples it
+// once the line has been quiet for DEBOUNCE_MS.
+struct ButtonEdge {
+    uint8_t id;
+    uint32_t timeMs;
+};
 
-                // LOW = PRESSED (Input Pullup)
-                if (state == LOW) {
-                    pressStartTime = millis();
-                    isLongPressed = false;
-                    isHeld = true;
-                } else {
-                    // RELEASED
-                    isHeld = false;
-                    unsigned long duration = millis() - pressStartTime;
-
-                    if (!isLongPressed) {
-                        // It was a short press
-                        if (waitingForDoubleClick && (millis() - lastClickTime < DOUBLE_CLICK_MS)) {
-                            justDoubleClicked = true;
-                            waitingForDoubleClick = false; // Reset
-                        } else {
-                            justReleased = true; // Potentially a single click
-                            waitingForDoubleClick = true;
-                            lastClickTime = millis();
-                        }
-                    }
-                }
-            }
-        }
+struct ButtonEvent {
+    uint8_t id;
+    uint8_t gesture;
+};
 
-        // Long Press Logic
-        if (state == LOW && !isLongPressed && (millis() - pressStartTime > LONG_PRESS_MS)) {
-            justLongPressed = true;
-            isLongPressed = true;
-            waitingForDoubleClick = false; // Cancel double click if held long
-        }
+// ==========================================
+// LOCK-FREE EDGE RING (ISR -> gesture task)
+// ==========================================
+// Single producer (GPIO ISRs, serialized) / single consumer (gesture task)
+class EdgeRing {
+private:
+    ButtonEdge buf[BTN_EDGE_RING];
+    volatile uint32_t head = 0; // Written by ISR only
+    volatile uint32_t tail = 0; // Written by task only
 
-        lastState = reading;
+public:
+    volatile uint32_t overflows = 0;
+
+    inline bool IRAM_ATTR push(const ButtonEdge& e) {
+        uint32_t h = head;
+        if (h - tail >= BTN_EDGE_RING) { overflows++; return false; }
+        buf[h & (BTN_EDGE_RING - 1)] = e;
+        __sync_synchronize(); // Publish data before the index
+        head = h + 1;
+        return true;
     }
 
-    // Check if we have a pending single click that timed out (so it's definitely single)
-    bool hasSingleClickPending() {
-        if (waitingForDoubleClick && (millis() - lastClickTime > DOUBLE_CLICK_MS)) {
-            waitingForDoubleClick = false;
-            return true;
-        }
-        return false;
+    inline bool pop(ButtonEdge& e) {
+        uint32_t t = tail;
+        if (t == head) return false;
+        __sync_synchronize();
+        e = buf[t & (BTN_EDGE_RING - 1)];
+        tail = t + 1;
+        return true;
     }
+};
 
-    // Force clear double click state (useful if handled)
-    void clearPending() { waitingForDoubleClick = false; }
+// ==========================================
+// CLASS: GESTURE RECOGNIZER (per button)
+// ==========================================
+struct ButtonState {
+    uint8_t pin;
+    bool doubleClick;      // Wait for a 2nd click before reporting a single one
+    bool repeat;           // Emits GESTURE_REPEAT while held
+
+    bool pressed = false;  // Debounced state
+    bool edgePending = false;
+    uint32_t lastEdge = 0;
+    uint32_t pressTime = 0;
+    bool longFired = false;
+    uint32_t nextRepeat = 0;
+    uint8_t clicks = 0;
+    uint32_t clickDeadline = 0;
 };
 
 // ==========================================
@@ -144,11 +142,14 @@ public:
 // ==========================================
 class ButtonManager {
 private:
-    SmartButton btnVolUp;
-    SmartButton btnVolDown;
-    SmartButton btnSource;
-    SmartButton btnPreset;
-    SmartButton btnPair;
+    ButtonState btn[BTN_COUNT];
+    EdgeRing edges;
+    QueueHandle_t gestures = nullptr;
+    TaskHandle_t task = nullptr;
+
+    // ISR context: one per pin
+    struct IsrArg { ButtonManager* mgr; uint8_t id; };
+    IsrArg isrArgs[BTN_COUNT];
 
     ButtonContext currentContext = CTX_BT;
 
@@ -156,23 +157,27 @@ private:
     unsigned long lastRadioMemActivity = 0;
     bool radioMemWaitActive = false;
 
-    // Timer for Rapid Volume
-    unsigned long lastRapidVolTime = 0;
-
 public:
-    ButtonManager() :
-        btnVolUp(BTN_VOL_UP),
-        btnVolDown(BTN_VOL_DOWN),
-        btnSource(BTN_SOURCE),
-        btnPreset(BTN_PRESET),
-        btnPair(BTN_PAIR) {}
+    ButtonManager() {
+        // Pin, double click, repeat
+        initButton(BTN_ID_VOL_UP,   BTN_VOL_UP,   false, true);
+        initButton(BTN_ID_VOL_DOWN, BTN_VOL_DOWN, false, true);
+        initButton(BTN_ID_SOURCE,   BTN_SOURCE,   false, false);
+        initButton(BTN_ID_PRESET,   BTN_PRESET,   true,  false);
+        initButton(BTN_ID_PAIR,     BTN_PAIR,     false, false);
+    }
 
     void begin() {
-        btnVolUp.begin();
-        btnVolDown.begin();
-        btnSource.begin();
-        btnPreset.begin();
-        btnPair.begin();
+        gestures = xQueueCreate(BTN_GESTURE_QUEUE, sizeof(ButtonEvent));
+        xTaskCreatePinnedToCore(gestureTask, "buttons", 2048, this,
+                                BTN_TASK_PRIORITY, &task, BTN_TASK_CORE);
+
+        for (int i = 0; i < BTN_COUNT; i++) {
+            pinMode(btn[i].pin, INPUT_PULLUP);
+            isrArgs[i].mgr = this;
+            isrArgs[i].id = i;
+            attachInterruptArg(btn[i].pin, onEdge, &isrArgs[i], CHANGE);
+        }
     }
 
     void setContext(ButtonContext ctx) {
@@ -184,107 +189,251 @@ public:
         currentContext = ctx;
     }
 
+    // Called from loop(): dispatches recognized gestures (non-blocking)
     void update() {
-        // 1. Read Raw States
-        btnVolUp.update();
-        btnVolDown.update();
-        btnSource.update();
-        btnPreset.update();
-        btnPair.update();
-
-        // 2. Handle COMBO (WiFi) - Priority High
-        // Logic: If both held > 2 sec
-        if (btnVolUp.isHeld && btnVolDown.isHeld) {
-            if (btnVolUp.justLongPressed || btnVolDown.justLongPressed) {
-                actionToggleWiFi();
-                // Consume events so individual buttons don't fire
-                btnVolUp.clearPending(); btnVolDown.clearPending();
-                return;
+        ButtonEvent ev;
+        while (gestures && xQueueReceive(gestures, &ev, 0) == pdTRUE) {
+            dispatch(ev);
+        }
+
+        // WAIT LOGIC (2 sec timeout on the memory screen)
+        if (currentContext == CTX_RADIO_MEM && radioMemWaitActive &&
+            (millis() - lastRadioMemActivity > MEMORY_WAIT_MS)) {
+            actionRadioActivateMem();
+            radioMemWaitActive = false;
+        }
+    }
+
+    uint32_t getEdgeOverflows() { return edges.overflows; }
+
+private:
+    void initButton(uint8_t id, uint8_t pin, bool dbl, bool rep) {
+        btn[id].pin = pin;
+        btn[id].doubleClick = dbl;
+        btn[id].repeat = rep;
+    }
+
+    // ==========================================
+    // ISR: timestamp the edge, wake the task
+    // ==========================================
+    static void IRAM_ATTR onEdge(void* arg) {
+        IsrArg* a = (IsrArg*)arg;
+        ButtonManager* m = a->mgr;
+
+        ButtonEdge e;
+        e.id = a->id;
+        e.timeMs = millis();
+        m->edges.push(e);
+
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(m->task, &woken);
+        if (woken) portYIELD_FROM_ISR();
+    }
+
+    // ==========================================
+    // GESTURE TASK
+    // ==========================================
+    static void gestureTask(void* arg) {
+        ButtonManager* m = (ButtonManager*)arg;
+        TickType_t wait = portMAX_DELAY;
+        for (;;) {
+            ulTaskNotifyTake(pdTRUE, wait);
+            wait = m->recognize();
+        }
+    }
+
+    void emit(uint8_t id, uint8_t gesture) {
+        ButtonEvent ev = { id, gesture };
+        xQueueSend(gestures, &ev, 0);
+    }
+
+    // Consumes pending edges, runs the timers.
+    // Returns how long the task may sleep (portMAX_DELAY if idle).
+    TickType_t recognize() {
+        ButtonEdge e;
+        while (edges.pop(e)) {
+            btn[e.id].edgePending = true;
+            btn[e.id].lastEdge = e.timeMs;
+        }
+        // After the drain: no edge is stamped later than 'now', or the
+        // debounce below would underflow and accept a bouncing level
+        uint32_t now = millis();
+
+        uint32_t nextDue = UINT32_MAX;
+        auto due = [&](uint32_t t) {
+            int32_t d = (int32_t)(t - now); // Wrap-safe (millis() wraps at 49 days)
+            if (d < 0) d = 0;
+            if ((uint32_t)d < nextDue) nextDue = d;
+        };
+
+        for (int i = 0; i < BTN_COUNT; i++) {
+            ButtonState& b = btn[i];
+
+            // 1. Debounce: accept the level once it has been stable
+            if (b.edgePending) {
+                if (now - b.lastEdge >= DEBOUNCE_MS) {
+                    b.edgePending = false;
+                    bool isDown = digitalRead(b.pin) == LOW; // Input pullup
+                    if (isDown != b.pressed) {
+                        b.pressed = isDown;
+                        if (isDown) onPress(i, b.lastEdge);
+                        else        onRelease(i, b.lastEdge);
+                    }
+                } else {
+                    due(b.lastEdge + DEBOUNCE_MS);
+                }
+            }
+
+            // 2. Long press / combo
+            if (b.pressed && !b.longFired) {
+                if (now - b.pressTime >= LONG_PRESS_MS) onLong(i, now);
+                else due(b.pressTime + LONG_PRESS_MS);
+            }
+
+            // 3. Rapid repeat
+            if (b.pressed && b.longFired && b.repeat && b.nextRepeat) {
+                if ((int32_t)(now - b.nextRepeat) >= 0) {
+                    emit(i, GESTURE_REPEAT);
+                    b.nextRepeat = now + RAPID_VOL_MS;
+                }
+                due(b.nextRepeat);
+            }
+
+            // 4. Double click window expired: it was a single click
+            if (b.clicks == 1) {
+                if ((int32_t)(now - b.clickDeadline) >= 0) {
+                    b.clicks = 0;
+                    emit(i, GESTURE_CLICK);
+                } else {
+                    due(b.clickDeadline);
+                }
             }
         }
 
-        // 3. Handle VOLUME (Always Active)
-        // Single Clicks
-        if (btnVolUp.hasSingleClickPending()) actionVolUp();
-        if (btnVolDown.hasSingleClickPending()) actionVolDown();
-
-        // Rapid Volume (Held > LongPress threshold)
-        if (btnVolUp.isHeld && millis() - lastRapidVolTime > RAPID_VOL_MS && btnVolUp.justLongPressed == false) {
-             // Only start rapid AFTER the initial long press trigger or delay
-             // Simplified: If held long enough, pulse events
-             // Note: User table says "Long Press > 2s = Volume Rapido".
-             // We'll treat "isLongPressed" state as enabling rapid fire.
-             if(millis() - btnVolUp.lastChangeTime > LONG_PRESS_MS) {
-                 actionVolRapidUp();
-                 lastRapidVolTime = millis();
-             }
+        return (nextDue == UINT32_MAX) ? portMAX_DELAY : pdMS_TO_TICKS(nextDue) + 1;
+    }
+
+    void onPress(int i, uint32_t t) {
+        btn[i].pressTime = t;
+        btn[i].longFired = false;
+        btn[i].nextRepeat = 0;
+    }
+
+    void onRelease(int i, uint32_t t) {
+        ButtonState& b = btn[i];
+        if (b.longFired) return; // Long press already reported
+
+        if (!b.doubleClick) {
+            emit(i, GESTURE_CLICK);
+        } else if (b.clicks == 1) {
+            b.clicks = 0;
+            emit(i, GESTURE_DOUBLE);
+        } else {
+            b.clicks = 1;
+            b.clickDeadline = t + DOUBLE_CLICK_MS;
         }
-        if (btnVolDown.isHeld && millis() - lastRapidVolTime > RAPID_VOL_MS && btnVolDown.justLongPressed == false) {
-             if(millis() - btnVolDown.lastChangeTime > LONG_PRESS_MS) {
-                 actionVolRapidDown();
-                 lastRapidVolTime = millis();
-             }
+    }
+
+    void onLong(int i, uint32_t now) {
+        ButtonState& b = btn[i];
+        b.longFired = true;
+        b.clicks = 0; // Cancel double click if held long
+
+        // COMBO: both volume buttons held (WiFi). Consumes both buttons.
+        ButtonState& up = btn[BTN_ID_VOL_UP];
+        ButtonState& dn = btn[BTN_ID_VOL_DOWN];
+        if ((i == BTN_ID_VOL_UP || i == BTN_ID_VOL_DOWN) && up.pressed && dn.pressed) {
+            up.longFired = true; up.nextRepeat = 0;
+            dn.longFired = true; dn.nextRepeat = 0;
+            emit(BTN_ID_VOL_UP, GESTURE_COMBO);
+            return;
         }
 
-        // 4. Handle SOURCE (Always Active)
-        if (btnSource.hasSingleClickPending()) actionCycleSource();
-        if (btnSource.justLongPressed) actionToggleTxMode();
+        emit(i, GESTURE_LONG);
+        if (b.repeat) b.nextRepeat = now + RAPID_VOL_MS;
+    }
+
+    // ==========================================
+    // ACTION MAPPING (runs in loop() context)
+    // ==========================================
+    void dispatch(const ButtonEvent& ev) {
+        uint8_t id = ev.id;
+        uint8_t g = ev.gesture;
+
+        // 1. COMBO (WiFi) - Priority High
+        if (g == GESTURE_COMBO) { actionToggleWiFi(); return; }
+
+        // 2. VOLUME (Always Active)
+        if (id == BTN_ID_VOL_UP) {
+            if (g == GESTURE_CLICK) actionVolUp();
+            else if (g == GESTURE_REPEAT) actionVolRapidUp();
+            return;
+        }
+        if (id == BTN_ID_VOL_DOWN) {
+            if (g == GESTURE_CLICK) actionVolDown();
+            else if (g == GESTURE_REPEAT) actionVolRapidDown();
+            return;
+        }
+
+        // 3. SOURCE (Always Active)
+        if (id == BTN_ID_SOURCE) {
+            if (g == GESTURE_CLICK) actionCycleSource();
+            else if (g == GESTURE_LONG) actionToggleTxMode();
+            return;
+        }
+
+        // 4. CONTEXT SPECIFIC LOGIC
+        bool preset = (id == BTN_ID_PRESET);
+        bool pair = (id == BTN_ID_PAIR);
 
-        // 5. Handle CONTEXT SPECIFIC LOGIC
         switch (currentContext) {
 
             // --- CONTEXT: RADIO ---
             case CTX_RADIO:
                 // PRESET
-                if (btnPreset.hasSingleClickPending()) actionRadioShowMemories(); // Enter Mem Screen
-                if (btnPreset.justLongPressed) actionToggleExpander();
-                if (btnPreset.justDoubleClicked) actionToggleLoudness();
+                if (preset && g == GESTURE_CLICK) actionRadioShowMemories(); // Enter Mem Screen
+                if (preset && g == GESTURE_LONG) actionToggleExpander();
+                if (preset && g == GESTURE_DOUBLE) actionToggleLoudness();
 
                 // PAIR
-                if (btnPair.hasSingleClickPending()) actionRadioSeekUp();
-                if (btnPair.justLongPressed) actionRadioSeekDown();
+                if (pair && g == GESTURE_CLICK) actionRadioSeekUp();
+                if (pair && g == GESTURE_LONG) actionRadioSeekDown();
                 break;
 
             // --- CONTEXT: RADIO MEMORY SCREEN ---
             case CTX_RADIO_MEM:
                 // PRESET
-                if (btnPreset.hasSingleClickPending()) {
+                if (preset && g == GESTURE_CLICK) {
                     actionRadioCursorMove();
                     lastRadioMemActivity = millis(); // Reset Wait Timer
                     radioMemWaitActive = true;
                 }
-                if (btnPreset.justLongPressed) {
+                if (preset && g == GESTURE_LONG) {
                     actionRadioOverwriteMem();
                     radioMemWaitActive = false; // Action taken, stop waiting
                 }
-
-                // WAIT LOGIC (2 sec timeout)
-                if (radioMemWaitActive && (millis() - lastRadioMemActivity > MEMORY_WAIT_MS)) {
-                    actionRadioActivateMem();
-                    radioMemWaitActive = false;
-                }
                 break;
 
             // --- CONTEXT: AUX ---
             case CTX_AUX:
                 // PRESET
-                if (btnPreset.hasSingleClickPending()) actionAuxCycleFilters();
-                if (btnPreset.justLongPressed) actionToggleExpander();
-                if (btnPreset.justDoubleClicked) actionToggleLoudness();
+                if (preset && g == GESTURE_CLICK) actionAuxCycleFilters();
+                if (preset && g == GESTURE_LONG) actionToggleExpander();
+                if (preset && g == GESTURE_DOUBLE) actionToggleLoudness();
 
                 // PAIR
-                if (btnPair.hasSingleClickPending()) actionAuxMute();
+                if (pair && g == GESTURE_CLICK) actionAuxMute();
                 break;
 
             // --- CONTEXT: BLUETOOTH ---
             case CTX_BT:
                 // PRESET
                 // Table: Short=[Empty], Long=Expander, Double=Loudness
-                if (btnPreset.justLongPressed) actionToggleExpander();
-                if (btnPreset.justDoubleClicked) actionToggleLoudness();
+                if (preset && g == GESTURE_LONG) actionToggleExpander();
+                if (preset && g == GESTURE_DOUBLE) actionToggleLoudness();
 
                 // PAIR
-                if (btnPair.hasSingleClickPending()) actionBtPairing();
+                if (pair && g == GESTURE_CLICK) actionBtPairing();
                 break;
 
              // --- CONTEXT: TX MODE ---
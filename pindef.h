@@ -9,6 +9,8 @@
 #define PIN_ADC_WS   18
 #define PIN_ADC_DATA 13
 
+#define PIN_SUB_DATA 15  // Crossover low way (I2S1 TX, shares ADC BCK/WS)
+
 #define PIN_I2C_SDA  21  // Era LED_RIAA
 #define PIN_I2C_SCL  23  // Era LED_DOLBY
 
@@ -0,0 +1,369 @@
+/*
+ * rdsdecoder.h - RDS Group Decoder (PS, RadioText, PTY, CT, AF)
+ *
+ * Logic:
+ * 1. The tuner hands over raw groups (blocks A-D) plus the block error
+ *    level reported by its syndrome checker (BLER).
+ * 2. Uncorrectable blocks are dropped. Text characters are only accepted
+ *    after RDS_VOTES_NEEDED identical receptions (majority voting), so a
+ *    block with an undetected error can't reach the display.
+ * 3. CT is range-checked and must be confirmed by a second group unless
+ *    all its blocks arrived error-free.
+ * 4. RdsRepeatFilter: the tuner is polled faster than groups arrive and
+ *    its ready flag can still be set on the next poll. The same read is
+ *    fed once, or it would count as a second vote.
+ *
+ * No Arduino dependencies: can be fed recorded group dumps on a PC.
+ *
+ * Integration:
+ * 1. RdsDecoder rds; rds.reset();
+ * 2. For every new group: if (!repeat.isRepeat(blocks, millis())) rds.feedGroup(blocks, bler);
+ * 3. Read: rds.getPS(), rds.getRadioText(), rds.getPTY() ...
+ */
+
+#ifndef RDSDECODER_H
+#define RDSDECODER_H
+
+#include <stdint.h>
+#include <string.h>
+
+// ==========================================
+// CONFIGURATION
+// ==========================================
+// Block error levels (RDA5807 BLERA/BLERB encoding)
+#define RDS_BLER_NONE      0     // No errors
+#define RDS_BLER_1_2       1     // 1-2 errors corrected
+#define RDS_BLER_3_5       2     // 3-5 errors corrected
+#define RDS_BLER_BAD       3     // Uncorrectable
+#define RDS_BLER_UNKNOWN   0xFF  // Chip doesn't report this block
+
+#define RDS_MAX_BLER_TEXT  RDS_BLER_3_5 // Worst level still voted on
+#define RDS_VOTES_NEEDED   2     // Identical receptions to accept a char
+#define RDS_VOTES_UNKNOWN  3     // ...when the block's BLER isn't reported
+#define RDS_PS_LEN         8
+#define RDS_RT_LEN         64
+#define RDS_AF_MAX         25
+#define RDS_AF_HISTORY     8     // Recent unverified AF pairs (need a repeat)
+#define RDS_REPEAT_MS      100   // > one group period (87.6 ms): a group still
+                                 // in the tuner's registers is fed once
+
+// Group types (bits 15:11 of block B: type + version)
+#define RDS_GROUP_0A       0x00
+#define RDS_GROUP_0B       0x01
+#define RDS_GROUP_2A       0x04
+#define RDS_GROUP_2B       0x05
+#define RDS_GROUP_4A       0x08
+
+struct RdsClock {
+    uint32_t mjd;       // Modified Julian Day
+    uint8_t hour;       // UTC
+    uint8_t minute;
+    int8_t offset;      // Local offset in half-hours
+    bool valid;
+};
+
+struct RdsStats {
+    uint32_t groups;    // Groups fed
+    uint32_t dropped;   // Groups rejected (bad block A/B)
+    uint32_t acceptedChars; // PS + RT characters accepted by voting
+};
+
+// ==========================================
+// VOTED TEXT BUFFER
+// ==========================================
+// Each position keeps a candidate and its vote count. A character is
+// accepted once the same value has been received 'needed' times.
+template<int N>
+class RdsVotedText {
+private:
+    char cand[N];
+    uint8_t votes[N];
+    char text[N + 1];
+    uint8_t validMask[(N + 7) / 8];
+
+public:
+    void reset() {
+        memset(cand, 0, sizeof(cand));
+        memset(votes, 0, sizeof(votes));
+        memset(text, ' ', N);
+        text[N] = '\0';
+        memset(validMask, 0, sizeof(validMask));
+    }
+
+    // Returns true if the accepted text changed
+    bool put(int pos, char c, uint8_t needed) {
+        if (pos < 0 || pos >= N) return false;
+        if (c != '\r' && (c < 0x20 || c > 0x7E)) c = ' '; // Keep LCD-safe ASCII
+        if (cand[pos] == c) {
+            if (votes[pos] < 255) votes[pos]++;
+        } else {
+            cand[pos] = c;
+            votes[pos] = 1;
+        }
+        if (votes[pos] >= needed && (!isValid(pos) || text[pos] != c)) {
+            text[pos] = c;
+            validMask[pos >> 3] |= (1 << (pos & 7));
+            return true;
+        }
+        return false;
+    }
+
+    bool isValid(int pos) const { return validMask[pos >> 3] & (1 << (pos & 7)); }
+
+    // True if positions [0, len) are all accepted
+    bool complete(int len) const {
+        for (int i = 0; i < len; i++) if (!isValid(i)) return false;
+        return true;
+    }
+
+    const char* str() const { return text; }
+};
+
+// ==========================================
+// REPEAT FILTER (same group read on several polls)
+// ==========================================
+// The window runs from the first read of a group: every later read of it
+// comes before the next group replaces it (< RDS_REPEAT_MS). A real repeat
+// of an identical group read early is dropped too: one vote less, never
+// one too many.
+class RdsRepeatFilter {
+private:
+    uint16_t last[4];
+    unsigned long lastTime = 0;
+
+public:
+    RdsRepeatFilter() { reset(); }
+
+    void reset() { memset(last, 0, sizeof(last)); lastTime = 0; }
+
+    // now: ms, wrap-safe
+    bool isRepeat(const uint16_t blocks[4], unsigned long now) {
+        if (memcmp(blocks, last, sizeof(last)) == 0 && now - lastTime < RDS_REPEAT_MS) return true;
+        memcpy(last, blocks, sizeof(last));
+        lastTime = now;
+        return false;
+    }
+};
+
+// ==========================================
+// DECODER
+// ==========================================
+class RdsDecoder {
+private:
+    uint16_t pi = 0;
+    uint16_t piCand = 0;
+    uint8_t pty = 0;
+    bool tp = false;
+    bool ta = false;
+
+    RdsVotedText<RDS_PS_LEN> ps;
+    RdsVotedText<RDS_RT_LEN> rt;
+    int8_t rtAB = -1;       // Text A/B flag, toggles on a new message
+    uint8_t rtLen = RDS_RT_LEN;
+    char rtOut[RDS_RT_LEN + 1];
+
+    RdsClock clock;
+    RdsClock clockCand;
+
+    uint16_t afList[RDS_AF_MAX]; // 10 kHz units
+    uint8_t afCount = 0;
+    uint16_t afHistory[RDS_AF_HISTORY];
+    uint8_t afHistIdx = 0;
+
+    RdsStats stats;
+
+public:
+    RdsDecoder() { reset(); memset(&stats, 0, sizeof(stats)); }
+
+    // Call on retune: forget everything station-specific
+    void reset() {
+        pi = 0; piCand = 0; pty = 0; tp = false; ta = false;
+        ps.reset();
+        rt.reset();
+        rtAB = -1;
+        rtLen = RDS_RT_LEN;
+        rtOut[0] = '\0';
+        memset(&clock, 0, sizeof(clock));
+        memset(&clockCand, 0, sizeof(clockCand));
+        afCount = 0;
+        memset(afHistory, 0, sizeof(afHistory));
+        afHistIdx = 0;
+    }
+
+    // ==========================================
+    // INPUT
+    // ==========================================
+    // blocks[0..3] = A, B, C, D. bler[0..3] = RDS_BLER_* per block.
+    void feedGroup(const uint16_t blocks[4], const uint8_t bler[4]) {
+        stats.groups++;
+
+        // Block B carries the group type: without it nothing can be decoded
+        if (bler[1] == RDS_BLER_BAD || bler[1] == RDS_BLER_UNKNOWN) { stats.dropped++; return; }
+
+        // PI: a new code must be seen twice before we treat it as a new station
+        if (bler[0] <= RDS_BLER_1_2) {
+            if (blocks[0] != pi) {
+                if (blocks[0] == piCand) {
+                    if (pi != 0) reset();
+                    pi = blocks[0];
+                } else {
+                    piCand = blocks[0];
+                }
+            }
+        }
+
+        uint16_t b = blocks[1];
+        uint8_t group = b >> 11;
+        tp = (b >> 10) & 1;
+        pty = (b >> 5) & 0x1F;
+
+        switch (group) {
+            case RDS_GROUP_0A:
+            case RDS_GROUP_0B: decodePS(blocks, bler, group == RDS_GROUP_0A); break;
+            case RDS_GROUP_2A: decodeRT(blocks, bler, true); break;
+            case RDS_GROUP_2B: decodeRT(blocks, bler, false); break;
+            case RDS_GROUP_4A: decodeCT(blocks, bler); break;
+            default: break;
+        }
+    }
+
+    // ==========================================
+    // OUTPUT
+    // ==========================================
+    uint16_t getPI() const { return pi; }
+    uint8_t getPTY() const { return pty; }
+    bool getTP() const { return tp; }
+    bool getTA() const { return ta; }
+
+    // Accepted positions only (unconfirmed chars stay blank)
+    const char* getPS() const { return ps.str(); }
+    bool psComplete() const { return ps.complete(RDS_PS_LEN); }
+
+    // Trimmed at the end-of-message marker (0x0D)
+    const char* getRadioText() {
+        int n = 0;
+        const char* src = rt.str();
+        while (n < rtLen && src[n] != '\r') { rtOut[n] = src[n]; n++; }
+        while (n > 0 && rtOut[n - 1] == ' ') n--;
+        rtOut[n] = '\0';
+        return rtOut;
+    }
+
+    const RdsClock& getClock() const { return clock; }
+
+    uint8_t getAFCount() const { return afCount; }
+    uint16_t getAF(int idx) const { return afList[idx]; }
+
+    const RdsStats& getStats() const { return stats; }
+
+private:
+    static uint8_t votesFor(uint8_t bler) {
+        return (bler == RDS_BLER_UNKNOWN) ? RDS_VOTES_UNKNOWN : RDS_VOTES_NEEDED;
+    }
+
+    static bool usable(uint8_t bler) {
+        return bler == RDS_BLER_UNKNOWN || bler <= RDS_MAX_BLER_TEXT;
+    }
+
+    template<int N>
+    void putChar(RdsVotedText<N>& t, int pos, char c, uint8_t needed) {
+        if (t.put(pos, c, needed)) stats.acceptedChars++;
+    }
+
+    // Group 0A/0B: PS name (2 chars in D), TA, AF pairs in C (0A only)
+    void decodePS(const uint16_t* blk, const uint8_t* bler, bool versionA) {
+        ta = (blk[1] >> 4) & 1;
+
+        if (usable(bler[3])) {
+            int seg = blk[1] & 0x03;
+            uint8_t need = votesFor(bler[3]);
+            putChar(ps, seg * 2,     (char)(blk[3] >> 8), need);
+            putChar(ps, seg * 2 + 1, (char)(blk[3] & 0xFF), need);
+        }
+
+        if (!versionA || (bler[2] > RDS_BLER_1_2 && bler[2] != RDS_BLER_UNKNOWN)) return;
+
+        // Unverified block: the same AF pair must come around again
+        bool trusted = bler[2] != RDS_BLER_UNKNOWN;
+        if (!trusted) {
+            for (int i = 0; i < RDS_AF_HISTORY; i++) if (afHistory[i] == blk[2]) trusted = true;
+            afHistory[afHistIdx] = blk[2];
+            afHistIdx = (afHistIdx + 1) % RDS_AF_HISTORY;
+        }
+        if (trusted) {
+            addAF(blk[2] >> 8);
+            addAF(blk[2] & 0xFF);
+        }
+    }
+
+    // AF code 1..204 = 87.6..107.9 MHz. Other codes are headers/fillers.
+    void addAF(uint8_t code) {
+        if (code < 1 || code > 204) return;
+        uint16_t f = 8750 + code * 10;
+        for (int i = 0; i < afCount; i++) if (afList[i] == f) return;
+        if (afCount < RDS_AF_MAX) afList[afCount++] = f;
+    }
+
+    // Group 2A: 4 chars (C+D) x 16 segments. 2B: 2 chars (D) x 16 segments.
+    void decodeRT(const uint16_t* blk, const uint8_t* bler, bool versionA) {
+        int8_t ab = (blk[1] >> 4) & 1;
+        if (rtAB >= 0 && ab != rtAB) {
+            rt.reset(); // A/B toggled: new message
+            rtLen = RDS_RT_LEN;
+        }
+        rtAB = ab;
+
+        int seg = blk[1] & 0x0F;
+        if (versionA) {
+            if (usable(bler[2])) {
+                uint8_t need = votesFor(bler[2]);
+                putRT(seg * 4,     (char)(blk[2] >> 8), need);
+                putRT(seg * 4 + 1, (char)(blk[2] & 0xFF), need);
+            }
+            if (usable(bler[3])) {
+                uint8_t need = votesFor(bler[3]);
+                putRT(seg * 4 + 2, (char)(blk[3] >> 8), need);
+                putRT(seg * 4 + 3, (char)(blk[3] & 0xFF), need);
+            }
+        } else if (usable(bler[3])) {
+            uint8_t need = votesFor(bler[3]);
+            putRT(seg * 2,     (char)(blk[3] >> 8), need);
+            putRT(seg * 2 + 1, (char)(blk[3] & 0xFF), need);
+        }
+    }
+
+    void putRT(int pos, char c, uint8_t need) {
+        putChar(rt, pos, c, need);
+        if (c == '\r' && rt.isValid(pos) && pos < rtLen) rtLen = pos;
+    }
+
+    // Group 4A: Clock Time (MJD + UTC + local offset)
+    void decodeCT(const uint16_t* blk, const uint8_t* bler) {
+        for (int i = 1; i < 4; i++) if (bler[i] == RDS_BLER_BAD) return;
+
+        RdsClock c;
+        c.mjd    = ((uint32_t)(blk[1] & 0x03) << 15) | (blk[2] >> 1);
+        c.hour   = ((blk[2] & 0x01) << 4) | (blk[3] >> 12);
+        c.minute = (blk[3] >> 6) & 0x3F;
+        int8_t off = blk[3] & 0x1F;
+        c.offset = (blk[3] & 0x20) ? -off : off;
+        c.valid  = true;
+
+        // Range check (MJD 50000 = 1995)
+        if (c.hour > 23 || c.minute > 59 || off > 24 || c.mjd < 50000) return;
+
+        // Error-free blocks are trusted right away. Otherwise the next CT
+        // (sent once a minute) must follow on from this one.
+        bool clean = bler[1] == RDS_BLER_NONE && bler[2] == RDS_BLER_NONE && bler[3] == RDS_BLER_NONE;
+        bool follows = false;
+        if (clockCand.valid) {
+            uint32_t prev = clockCand.mjd * 1440 + clockCand.hour * 60 + clockCand.minute;
+            uint32_t now  = c.mjd * 1440 + c.hour * 60 + c.minute;
+            follows = (now >= prev) && (now - prev <= 2) && c.offset == clockCand.offset;
+        }
+        clockCand = c;
+        if (clean || follows) clock = c;
+    }
+};
+
+#endif // RDSDECODER_H
@@ -0,0 +1,218 @@
+/*
+ * rfft.h - Real FFT (N real samples -> N/2+1 bins), shared by the analyzers and the convolver
+ *
+ * Logic:
+ * 1. The N reals are packed as N/2 complex values (even = re, odd = im).
+ * 2. One N/2-point complex FFT:
+ *    - ESP-DSP dsps_fft2r_fc32 when the library is installed (SIMD-optimized)
+ *    - otherwise the built-in iterative radix-2
+ * 3. A split pass untangles the two interleaved halves into the real spectrum.
+ *
+ * Output is packed in place (same layout as most embedded real FFTs):
+ *   data[0] = DC, data[1] = Nyquist (both real)
+ *   data[2k], data[2k+1] = Re, Im of bin k (1 .. N/2-1)
+ *
+ * inverse() takes the same packed layout and is unscaled: the result is
+ * the original signal times N/2 (fold 2/N into your filter spectra).
+ *
+ * All tables are allocated once in begin(); forward()/inverse() never allocate.
+ */
+
+#ifndef RFFT_H
+#define RFFT_H
+
+#include <Arduino.h>
+#include <math.h>
+
+#if defined(__has_include)
+  #if __has_include(<esp_dsp.h>)
+    #include <esp_dsp.h>
+    #define RFFT_USE_ESP_DSP 1
+  #endif
+#endif
+#ifndef RFFT_USE_ESP_DSP
+  #define RFFT_USE_ESP_DSP 0
+#endif
+
+class RealFFT {
+private:
+    int n = 0;              // Real length
+    float* splitTw = nullptr; // cos/sin of 2*pi*k/N, k < N/4 (split pass)
+#if !RFFT_USE_ESP_DSP
+    float* cplxTw = nullptr;  // cos/sin of 2*pi*k/(N/2), k < N/4
+    uint16_t* bitrev = nullptr;
+#endif
+
+public:
+    ~RealFFT() { end(); }
+
+    // n: power of two >= 8. Returns false if out of memory.
+    bool begin(int size) {
+        end();
+        if (size < 8 || (size & (size - 1))) return false;
+        n = size;
+        int h = n / 2;
+
+        splitTw = (float*)malloc(sizeof(float) * (n / 2));
+        if (!splitTw) { end(); return false; }
+        for (int k = 0; k < n / 4; k++) {
+            splitTw[2 * k]     = cosf(2.0f * PI * k / n);
+            splitTw[2 * k + 1] = sinf(2.0f * PI * k / n);
+        }
+
+#if RFFT_USE_ESP_DSP
+        if (dsps_fft2r_init_fc32(NULL, h) != ESP_OK) { end(); return false; }
+#else
+        cplxTw = (float*)malloc(sizeof(float) * h);
+        bitrev = (uint16_t*)malloc(sizeof(uint16_t) * h);
+        if (!cplxTw || !bitrev) { end(); return false; }
+        for (int k = 0; k < h / 2; k++) {
+            cplxTw[2 * k]     = cosf(2.0f * PI * k / h);
+            cplxTw[2 * k + 1] = sinf(2.0f * PI * k / h);
+        }
+        int bits = 0;
+        while ((1 << bits) < h) bits++;
+        for (int i = 0; i < h; i++) {
+            int r = 0;
+            for (int b = 0; b < bits; b++) if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+            bitrev[i] = r;
+        }
+#endif
+        return true;
+    }
+
+    void end() {
+        free(splitTw); splitTw = nullptr;
+#if !RFFT_USE_ESP_DSP
+        free(cplxTw); cplxTw = nullptr;
+        free(bitrev); bitrev = nullptr;
+#endif
+        n = 0;
+    }
+
+    int size() { return n; }
+
+    // In place, see the packed layout above
+    void forward(float* data) {
+        if (!n) return;
+        int h = n / 2;
+
+        // 1. N/2-point complex FFT of the packed reals
+        complexForward(data, h);
+
+        // 2. Split: X[k] = (Z[k] + Z*[h-k])/2 - j/2 * W^k * (Z[k] - Z*[h-k])
+        float z0r = data[0], z0i = data[1];
+        data[0] = z0r + z0i; // DC
+        data[1] = z0r - z0i; // Nyquist
+
+        for (int k = 1; k <= h / 2; k++) {
+            int m = h - k;
+            float ar = data[2 * k], ai = data[2 * k + 1];
+            float br = data[2 * m], bi = data[2 * m + 1];
+
+            float er = 0.5f * (ar + br), ei = 0.5f * (ai - bi); // Even part
+            float or_ = 0.5f * (ai + bi), oi = 0.5f * (br - ar); // Odd part (times -j)
+
+            // W^k = cos - j sin; for k > N/4 use symmetry
+            float c, s;
+            twiddle(k, c, s);
+            float tr = or_ * c + oi * s;
+            float ti = oi * c - or_ * s;
+
+            data[2 * k]     = er + tr;
+            data[2 * k + 1] = ei + ti;
+            if (m != k) {
+                data[2 * m]     = er - tr;
+                data[2 * m + 1] = -(ei - ti);
+            }
+        }
+    }
+
+    // In place, packed spectrum -> N reals (times N/2)
+    void inverse(float* data) {
+        if (!n) return;
+        int h = n / 2;
+
+        // 1. Undo the split: Z[k] = E[k] + j*O[k]
+        //    E = (X[k] + X*[h-k])/2, O = (X[k] - X*[h-k]) * conj(W^k)/2
+        float x0 = data[0], xh = data[1];
+        data[0] = 0.5f * (x0 + xh);
+        data[1] = 0.5f * (x0 - xh);
+
+        for (int k = 1; k <= h / 2; k++) {
+            int m = h - k;
+            float ar = data[2 * k], ai = data[2 * k + 1];
+            float br = data[2 * m], bi = data[2 * m + 1];
+
+            float er = 0.5f * (ar + br), ei = 0.5f * (ai - bi);
+            float dr = 0.5f * (ar - br), di = 0.5f * (ai + bi);
+
+            float c, s;
+            twiddle(k, c, s);
+            // O = D * (c + j s)
+            float or_ = dr * c - di * s;
+            float oi = dr * s + di * c;
+
+            // Z[k] = E + jO, Z[h-k] = conj(E) + j conj(O)
+            data[2 * k]     = er - oi;
+            data[2 * k + 1] = ei + or_;
+            if (m != k) {
+                data[2 * m]     = er + oi;
+                data[2 * m + 1] = -ei + or_;
+            }
+        }
+
+        // 2. Inverse complex FFT via conj(FFT(conj(Z))), unscaled
+        for (int i = 0; i < h; i++) data[2 * i + 1] = -data[2 * i + 1];
+        complexForward(data, h);
+        for (int i = 0; i < h; i++) data[2 * i + 1] = -data[2 * i + 1];
+    }
+
+private:
+    inline void complexForward(float* data, int h) {
+#if RFFT_USE_ESP_DSP
+        dsps_fft2r_fc32(data, h);
+        dsps_bit_rev_fc32(data, h);
+#else
+        complexFFT(data, h);
+#endif
+    }
+
+    // cos/sin(2*pi*k/N) for 0 < k <= N/4
+    inline void twiddle(int k, float& c, float& s) {
+        if (k < n / 4) { c = splitTw[2 * k]; s = splitTw[2 * k + 1]; }
+        else           { c = 0.0f; s = 1.0f; }
+    }
+
+#if !RFFT_USE_ESP_DSP
+    // Iterative radix-2 DIT, interleaved re/im
+    void complexFFT(float* d, int len) {
+        for (int i = 0; i < len; i++) {
+            int j = bitrev[i];
+            if (j > i) {
+                float tr = d[2 * i], ti = d[2 * i + 1];
+                d[2 * i] = d[2 * j]; d[2 * i + 1] = d[2 * j + 1];
+                d[2 * j] = tr; d[2 * j + 1] = ti;
+            }
+        }
+        for (int span = 1; span < len; span <<= 1) {
+            int step = len / (span * 2); // Twiddle stride
+            for (int start = 0; start < len; start += span * 2) {
+                for (int k = 0; k < span; k++) {
+                    float c = cplxTw[2 * k * step];
+                    float s = cplxTw[2 * k * step + 1];
+                    int a = start + k, b = a + span;
+                    float br = d[2 * b] * c + d[2 * b + 1] * s;
+                    float bi = d[2 * b + 1] * c - d[2 * b] * s;
+                    d[2 * b]     = d[2 * a] - br;
+                    d[2 * b + 1] = d[2 * a + 1] - bi;
+                    d[2 * a]     += br;
+                    d[2 * a + 1] += bi;
+                }
+            }
+        }
+    }
+#endif
+};
+
+#endif // RFFT_H
@@ -0,0 +1,190 @@
+/*
+ * settingstore.h - Write-Behind Settings Cache for NVS (Preferences)
+ *
+ * Logic:
+ * 1. Values are read from NVS once and kept in a small RAM table.
+ * 2. put*() only updates RAM and marks the entry dirty (no flash access).
+ * 3. loop() commits dirty entries once the value has been quiet for
+ *    SETTINGS_FLUSH_MS. flush() forces the commit (mode switch, reboot).
+ *
+ * Integration:
+ * 1. Open the namespace: prefs.begin("espdsp", false);
+ * 2. Bind: store.begin(&prefs);
+ * 3. Use store.getInt()/putInt() instead of prefs.getInt()/putInt()
+ * 4. In loop(): store.loop();
+ *
+ * Safe to call get*()/put*() from the Bluetooth task: lookup and insert
+ * happen in one critical section, so a key is never cached twice.
+ */
+
+#ifndef SETTINGSTORE_H
+#define SETTINGSTORE_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+// ==========================================
+// CONFIGURATION
+// ==========================================
+#define SETTINGS_FLUSH_MS   3000  // Quiet period before committing to flash
+#define SETTINGS_MAX_KEYS   16    // Cached keys per namespace
+#define SETTINGS_KEY_LEN    16    // NVS keys are limited to 15 chars + null
+
+class SettingsStore {
+private:
+    struct Entry {
+        char key[SETTINGS_KEY_LEN];
+        int32_t value;
+        bool isBool;
+        bool dirty;
+    };
+
+    Preferences* prefs = nullptr;
+    Entry entries[SETTINGS_MAX_KEYS];
+    int count = 0;
+
+    volatile bool anyDirty = false;
+    volatile unsigned long lastChange = 0;
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+public:
+    // Statistics (put*() calls vs. real flash writes)
+    volatile uint32_t writesRequested = 0;
+    volatile uint32_t writesCommitted = 0;
+
+    void begin(Preferences* p) {
+        prefs = p;
+    }
+
+    // ==========================================
+    // READ
+    // ==========================================
+    int32_t getInt(const char* key, int32_t defaultValue = 0) {
+        int32_t v;
+        if (cached(key, v)) return v;
+
+        // First access: load from NVS (flash, outside the lock) and cache it
+        return cache(key, prefs->getInt(key, defaultValue), false);
+    }
+
+    bool getBool(const char* key, bool defaultValue = false) {
+        int32_t v;
+        if (cached(key, v)) return v != 0;
+
+        return cache(key, prefs->getBool(key, defaultValue) ? 1 : 0, true) != 0;
+    }
+
+    // ==========================================
+    // WRITE (RAM only, committed later)
+    // ==========================================
+    void putInt(const char* key, int32_t value) { stage(key, value, false); }
+    void putBool(const char* key, bool value)   { stage(key, value ? 1 : 0, true); }
+
+    // ==========================================
+    // COMMIT
+    // ==========================================
+    // Call from loop(): commits once the values have settled
+    void loop() {
+        if (anyDirty && (millis() - lastChange >= SETTINGS_FLUSH_MS)) {
+            flush();
+        }
+    }
+
+    // Commit all dirty entries now (mode switch, reboot)
+    void flush() {
+        if (!prefs) return;
+        anyDirty = false;
+
+        for (int i = 0; i < count; i++) {
+            portENTER_CRITICAL(&lock);
+            bool dirty = entries[i].dirty;
+            int32_t v = entries[i].value;
+            bool isBool = entries[i].isBool;
+            entries[i].dirty = false;
+            portEXIT_CRITICAL(&lock);
+
+            if (!dirty) continue;
+            if (isBool) prefs->putBool(entries[i].key, v != 0);
+            else        prefs->putInt(entries[i].key, v);
+            writesCommitted++;
+        }
+    }
+
+    // Writes that never reached the flash (coalesced or unchanged)
+    uint32_t writesAvoided() {
+        uint32_t pending = 0;
+        for (int i = 0; i < count; i++) if (entries[i].dirty) pending++;
+        uint32_t done = writesCommitted + pending;
+        return (writesRequested > done) ? (writesRequested - done) : 0;
+    }
+
+private:
+    // Caller holds the lock
+    int find(const char* key) {
+        for (int i = 0; i < count; i++) {
+            if (strncmp(entries[i].key, key, SETTINGS_KEY_LEN) == 0) return i;
+        }
+        return -1;
+    }
+
+    // Caller holds the lock. Returns the index of the key, adding it (clean,
+    // with 'value') if missing; -1 if the table is full.
+    int findOrInsert(const char* key, int32_t value, bool isBool, bool& inserted) {
+        inserted = false;
+        int idx = find(key);
+        if (idx >= 0 || count >= SETTINGS_MAX_KEYS) return idx;
+
+        idx = count;
+        strncpy(entries[idx].key, key, SETTINGS_KEY_LEN - 1);
+        entries[idx].key[SETTINGS_KEY_LEN - 1] = '\0';
+        entries[idx].value = value;
+        entries[idx].isBool = isBool;
+        entries[idx].dirty = false;
+        count++;
+        inserted = true;
+        return idx;
+    }
+
+    bool cached(const char* key, int32_t& value) {
+        portENTER_CRITICAL(&lock);
+        int idx = find(key);
+        if (idx >= 0) value = entries[idx].value;
+        portEXIT_CRITICAL(&lock);
+        return idx >= 0;
+    }
+
+    // Caches a value loaded from NVS. If another task cached the key while
+    // we read the flash, its (possibly newer, staged) value wins.
+    int32_t cache(const char* key, int32_t value, bool isBool) {
+        bool inserted;
+        portENTER_CRITICAL(&lock);
+        int idx = findOrInsert(key, value, isBool, inserted);
+        if (idx >= 0) value = entries[idx].value;
+        portEXIT_CRITICAL(&lock);
+        return value;
+    }
+
+    void stage(const char* key, int32_t value, bool isBool) {
+        writesRequested++;
+
+        bool inserted;
+        portENTER_CRITICAL(&lock);
+        int idx = findOrInsert(key, value, isBool, inserted);
+        if (idx >= 0 && (inserted || entries[idx].value != value || entries[idx].dirty)) {
+            entries[idx].value = value;
+            entries[idx].dirty = true;
+            anyDirty = true;
+            lastChange = millis();
+        }
+        portEXIT_CRITICAL(&lock);
+
+        // Table full: fall back to a direct write
+        if (idx < 0) {
+            if (isBool) prefs->putBool(key, value != 0);
+            else        prefs->putInt(key, value);
+            writesCommitted++;
+        }
+    }
+};
+
+#endif // SETTINGSTORE_H
@@ -0,0 +1,164 @@
+/*
+ * siggen.h - Signal Generator (NCO Sine, Sweeps, White/Pink Noise)
+ *
+ * Logic:
+ * 1. Sine: 32-bit phase accumulator (wraps by itself, no fmod). The top
+ *    GEN_TABLE_BITS select a wavetable entry, the next bits interpolate
+ *    linearly to the following one: residual ~ -88 dB, no libm per sample.
+ * 2. Sweeps (genFreqStart -> genFreqEnd over genPeriod, then restart):
+ *    - exponential: increment multiplied by a constant ratio per sample
+ *    - linear: constant added per sample
+ *    The increment is recomputed exactly at every block start, so float
+ *    drift never accumulates over a long sweep.
+ * 3. Noise: white from fastWhiteNoise() (xorshift), pink from
+ *    generatePinkNoise() (pnoise.h).
+ *
+ * Output is a mono float block (+/-1.0 scale, GEN_LEVEL peak).
+ */
+
+#ifndef SIGGEN_H
+#define SIGGEN_H
+
+#include <Arduino.h>
+#include <math.h>
+#include "pnoise.h"
+
+// ==========================================
+// CONFIGURATION
+// ==========================================
+#define GEN_TABLE_BITS   9                       // 512 entries
+#define GEN_TABLE_SIZE   (1 << GEN_TABLE_BITS)
+#define GEN_FRAC_BITS    (32 - GEN_TABLE_BITS)
+#define GEN_LEVEL        0.5f                    // -6 dBFS
+#define GEN_FS           44100.0f
+#define GEN_MIN_FREQ     1.0f
+#define GEN_MAX_PERIOD   600.0f                  // Seconds
+
+// Matches the web UI selector
+enum GenType { GEN_SINE = 0, GEN_WHITE, GEN_PINK, GEN_SWEEP_LOG, GEN_SWEEP_LIN };
+
+class SignalGenerator {
+private:
+    float table[GEN_TABLE_SIZE + 1];   // One extra entry: no wrap on interpolation
+    uint32_t phase = 0;
+    uint32_t inc = 0;                  // Fixed tone
+
+    // Sweep state
+    float incStart = 0, incEnd = 0;    // Phase increments (float, 2^32 = fs)
+    float logRatio = 0;                // ln(end / start)
+    uint32_t sweepLen = 1, sweepPos = 0;
+
+    int type = GEN_SINE;
+
+public:
+    void init() {
+        for (int i = 0; i <= GEN_TABLE_SIZE; i++) {
+            table[i] = GEN_LEVEL * sinf(2.0f * PI * i / GEN_TABLE_SIZE);
+        }
+        phase = 0;
+        sweepPos = 0;
+    }
+
+    // Call from the audio thread (or with the generator stopped)
+    void configure(int sigType, float fStart, float fEnd, float periodS, float sampleRate = GEN_FS) {
+        type = sigType;
+        float nyq = 0.5f * sampleRate;
+        fStart = constrain(fStart, GEN_MIN_FREQ, nyq);
+        fEnd = constrain(fEnd, GEN_MIN_FREQ, nyq);
+        periodS = constrain(periodS, 0.1f, GEN_MAX_PERIOD);
+
+        float scale = 4294967296.0f / sampleRate;
+        inc = (uint32_t)(fStart * scale);
+        incStart = fStart * scale;
+        incEnd = fEnd * scale;
+        logRatio = logf(fEnd / fStart);
+        sweepLen = (uint32_t)(periodS * sampleRate);
+        sweepPos = 0;
+    }
+
+    // Restart the sweep from fStart (phase continues: no click)
+    void restart() { sweepPos = 0; }
+
+    // Current instantaneous frequency (Hz), for display
+    float getFrequency(float sampleRate = GEN_FS) {
+        if (type == GEN_SINE) return inc * sampleRate / 4294967296.0f;
+        if (type == GEN_SWEEP_LOG || type == GEN_SWEEP_LIN) return sweepIncrement(sweepPos) * sampleRate / 4294967296.0f;
+        return 0.0f;
+    }
+
+    // ==========================================
+    // BLOCK GENERATION (mono, +/-GEN_LEVEL)
+    // ==========================================
+    void generate(float* out, int n) {
+        switch (type) {
+            case GEN_SINE:
+                for (int i = 0; i < n; i++) {
+                    out[i] = lookup(phase);
+                    phase += inc;
+                }
+                break;
+
+            case GEN_WHITE:
+                for (int i = 0; i < n; i++) out[i] = fastWhiteNoise() * GEN_LEVEL;
+                break;
+
+            case GEN_PINK:
+                for (int i = 0; i < n; i++) out[i] = generatePinkNoise() * GEN_LEVEL;
+                break;
+
+            case GEN_SWEEP_LOG:
+            case GEN_SWEEP_LIN: {
+                int done = 0;
+                while (done < n) {
+                    // Run up to the end of the sweep, then wrap
+                    int chunk = n - done;
+                    if ((uint32_t)chunk > sweepLen - sweepPos) chunk = sweepLen - sweepPos;
+                    sweepChunk(out + done, chunk);
+                    done += chunk;
+                    sweepPos += chunk;
+                    if (sweepPos >= sweepLen) sweepPos = 0;
+                }
+                break;
+            }
+
+            default:
+                memset(out, 0, sizeof(float) * n);
+                break;
+        }
+    }
+
+private:
+    inline float lookup(uint32_t p) {
+        uint32_t i = p >> GEN_FRAC_BITS;
+        float f = (p & ((1u << GEN_FRAC_BITS) - 1)) * (1.0f / (1u << GEN_FRAC_BITS));
+        return table[i] + f * (table[i + 1] - table[i]);
+    }
+
+    // Exact increment at sample position pos of the sweep
+    inline float sweepIncrement(uint32_t pos) {
+        float t = (float)pos / sweepLen;
+        if (type == GEN_SWEEP_LOG) return incStart * expf(logRatio * t);
+        return incStart + (incEnd - incStart) * t;
+    }
+
+    void sweepChunk(float* out, int n) {
+        float f = sweepIncrement(sweepPos);
+        if (type == GEN_SWEEP_LOG) {
+            float k = expf(logRatio / sweepLen);
+            for (int i = 0; i < n; i++) {
+                out[i] = lookup(phase);
+                phase += (uint32_t)f;
+                f *= k;
+            }
+        } else {
+            float d = (incEnd - incStart) / sweepLen;
+            for (int i = 0; i < n; i++) {
+                out[i] = lookup(phase);
+                phase += (uint32_t)f;
+                f += d;
+            }
+        }
+    }
+};
+
+#endif // SIGGEN_H
@@ -0,0 +1,268 @@
+/*
+ * spectrum.h - Real-time Spectrum Analyzer (post-DSP, for LCD and Web UI)
+ *
+ * Logic:
+ * 1. Audio side: push() folds the block to mono, optionally decimates it and
+ *    appends it to a ring buffer. No locks, no waiting: the analyzer only
+ *    reads samples the writer has already published.
+ * 2. A low-priority task wakes SPECTRUM_RATE_HZ times per second, copies the
+ *    last SPECTRUM_FFT_SIZE samples, applies a Hann window and runs the real FFT.
+ * 3. The bins are folded into two log band sets:
+ *    - 10 octave bands on the EQ frequencies (EQ_FREQS, what the user is correcting)
+ *    - 31 ISO third-octave bands
+ * 4. The analysis period stretches if it would exceed SPECTRUM_CPU_BUDGET.
+ *
+ * The analyzer stops (and push() returns immediately) when nobody has asked
+ * for data for SPECTRUM_IDLE_MS: call touch() from every consumer.
+ *
+ * Levels are dBFS: a full-scale sine reads 0 dB in its band.
+ */
+
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <math.h>
+#include "rfft.h"
+#include "dsp_engine.h"   // EQ_BANDS, EQ_FREQS
+
+// ==========================================
+// CONFIGURATION
+// ==========================================
+#define SPECTRUM_SAMPLE_RATE   44100
+#define SPECTRUM_FFT_SIZE      2048   // 21.5 Hz bins: resolves the 32 Hz EQ band
+#define SPECTRUM_DECIM         1      // 1, 2 or 4 (boxcar). >1 drops the top bands
+#define SPECTRUM_RATE_HZ       15     // Analysis frames per second
+#define SPECTRUM_CPU_BUDGET    5      // Max % of one core
+#define SPECTRUM_IDLE_MS       2000   // No consumer for this long: stop
+#define SPECTRUM_FLOOR_DB      -80.0f
+#define SPECTRUM_DECAY_DB_S    30.0f  // Display fall-back speed
+#define SPECTRUM_TASK_PRIORITY 1
+#define SPECTRUM_TASK_CORE     0
+
+#define SPECTRUM_RING          (SPECTRUM_FFT_SIZE * 2) // Power of two
+#define SPECTRUM_EQ_BANDS      EQ_BANDS
+#define SPECTRUM_ISO_BANDS     31
+
+// ISO 266 third-octave centers
+const float SPECTRUM_ISO_FREQS[SPECTRUM_ISO_BANDS] = {
+    20, 25, 31.5, 40, 50, 63, 80, 100, 125, 160, 200, 250, 315, 400, 500, 630,
+    800, 1000, 1250, 1600, 2000, 2500, 3150, 4000, 5000, 6300, 8000, 10000,
+    12500, 16000, 20000
+};
+
+class Spectrum {
+private:
+    struct BandSet {
+        const float* freqs;
+        int count;
+        uint16_t lo[SPECTRUM_ISO_BANDS]; // First bin (0 = band above Nyquist)
+        uint16_t hi[SPECTRUM_ISO_BANDS]; // Last bin (inclusive)
+        float level[SPECTRUM_ISO_BANDS]; // Smoothed, task side
+        float out[SPECTRUM_ISO_BANDS];   // Published copy
+    };
+
+    RealFFT fft;
+    int16_t* ring = nullptr;
+    float* work = nullptr;
+    float* window = nullptr;     // First half (symmetric)
+    float norm = 1.0f;           // Band power -> full-scale sine = 1
+
+    std::atomic<uint32_t> writeIdx;
+    int32_t decimAcc = 0;
+    int decimCount = 0;
+
+    BandSet eq;
+    BandSet iso;
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+    TaskHandle_t task = nullptr;
+    volatile bool active = false;
+    volatile uint32_t lastTouch = 0;
+    uint32_t lastFrame = 0;
+
+public:
+    // Statistics
+    volatile uint32_t frames = 0;
+    volatile uint32_t lastCostUs = 0;
+    volatile uint32_t periodMs = 1000 / SPECTRUM_RATE_HZ;
+
+    Spectrum() : writeIdx(0) {}
+
+    bool begin() {
+        ring = (int16_t*)calloc(SPECTRUM_RING, sizeof(int16_t));
+        work = (float*)malloc(sizeof(float) * SPECTRUM_FFT_SIZE);
+        window = (float*)malloc(sizeof(float) * (SPECTRUM_FFT_SIZE / 2));
+        if (!ring || !work || !window || !fft.begin(SPECTRUM_FFT_SIZE)) {
+            Serial.println("Spectrum: out of memory");
+            return false;
+        }
+
+        // Hann window. Sum of w^2 sets the power normalization.
+        float sumSq = 0.0f;
+        for (int i = 0; i < SPECTRUM_FFT_SIZE / 2; i++) {
+            window[i] = 0.5f - 0.5f * cosf(2.0f * PI * i / SPECTRUM_FFT_SIZE);
+            sumSq += 2.0f * window[i] * window[i];
+        }
+        sumSq += 1.0f; // Center sample (w = 1), not in the half table
+        // One-sided power of a unit sine is N * sum(w^2) / 4
+        norm = 4.0f / ((float)SPECTRUM_FFT_SIZE * sumSq);
+
+        setupBands(eq, EQ_FREQS, SPECTRUM_EQ_BANDS, 1.0f);
+        setupBands(iso, SPECTRUM_ISO_FREQS, SPECTRUM_ISO_BANDS, 3.0f);
+
+        xTaskCreatePinnedToCore(analysisTask, "spectrum", 3072, this,
+                                SPECTRUM_TASK_PRIORITY, &task, SPECTRUM_TASK_CORE);
+        return true;
+    }
+
+    // Consumers call this (web poll, LCD frame) to keep the analyzer running
+    void touch() {
+        lastTouch = millis();
+        if (!active && task) xTaskNotifyGive(task);
+    }
+
+    bool isActive() { return active; }
+
+    // ==========================================
+    // AUDIO SIDE (once per block, never blocks)
+    // ==========================================
+    // buf: interleaved L/R int32, frames: stereo frames
+    void push(const int32_t* buf, int frames) {
+        if (!active) return;
+        uint32_t w = writeIdx.load(std::memory_order_relaxed);
+        for (int i = 0; i < frames; i++) {
+            // Mono, 16-bit scale
+            decimAcc += (buf[i * 2] >> 17) + (buf[i * 2 + 1] >> 17);
+            if (++decimCount < SPECTRUM_DECIM) continue;
+            ring[w & (SPECTRUM_RING - 1)] = (int16_t)(decimAcc / SPECTRUM_DECIM);
+            w++;
+            decimAcc = 0;
+            decimCount = 0;
+        }
+        writeIdx.store(w, std::memory_order_release);
+    }
+
+    // ==========================================
+    // READ (any task)
+    // ==========================================
+    // count: SPECTRUM_EQ_BANDS or SPECTRUM_ISO_BANDS. Returns the band count.
+    int getBands(float* db, int count) {
+        BandSet& b = (count == SPECTRUM_ISO_BANDS) ? iso : eq;
+        portENTER_CRITICAL(&lock);
+        memcpy(db, b.out, sizeof(float) * b.count);
+        portEXIT_CRITICAL(&lock);
+        return b.count;
+    }
+
+    const float* getBandFreqs(int count) {
+        return (count == SPECTRUM_ISO_BANDS) ? SPECTRUM_ISO_FREQS : EQ_FREQS; // Same centers as the EQ
+    }
+
+    // Analysis share of one core, in %
+    float getLoad() { return active ? (lastCostUs * 0.1f) / periodMs : 0.0f; }
+
+private:
+    // bandsPerOctave: 1 = octave, 3 = third-octave
+    void setupBands(BandSet& b, const float* freqs, int count, float bandsPerOctave) {
+        const float fs = (float)SPECTRUM_SAMPLE_RATE / SPECTRUM_DECIM;
+        const float df = fs / SPECTRUM_FFT_SIZE;
+        const int maxBin = SPECTRUM_FFT_SIZE / 2 - 1;
+        float edge = powf(2.0f, 0.5f / bandsPerOctave);
+
+        b.freqs = freqs;
+        b.count = count;
+        for (int i = 0; i < count; i++) {
+            b.level[i] = SPECTRUM_FLOOR_DB;
+            b.out[i] = SPECTRUM_FLOOR_DB;
+
+            float fLo = freqs[i] / edge;
+            float fHi = freqs[i] * edge;
+            if (fLo >= fs * 0.5f) { b.lo[i] = 0; b.hi[i] = 0; continue; }
+
+            int lo = (int)ceilf(fLo / df);
+            int hi = (int)floorf(fHi / df);
+            if (hi < lo) lo = hi = (int)lroundf(freqs[i] / df); // Narrower than a bin
+            b.lo[i] = constrain(lo, 1, maxBin);
+            b.hi[i] = constrain(hi, 1, maxBin);
+        }
+    }
+
+    static void analysisTask(void* arg) {
+        Spectrum* s = (Spectrum*)arg;
+        for (;;) {
+            if (millis() - s->lastTouch > SPECTRUM_IDLE_MS) {
+                // Nobody is looking: stop feeding and sleep until touch()
+                s->active = false;
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+                s->decimCount = 0;
+                s->decimAcc = 0;
+                s->lastFrame = millis();
+                s->active = true;
+                continue;
+            }
+            vTaskDelay(pdMS_TO_TICKS(s->periodMs));
+            s->analyze();
+        }
+    }
+
+    void analyze() {
+        uint32_t t0 = micros();
+
+        // 1. Snapshot + window (the writer is at least a block ahead)
+        uint32_t w = writeIdx.load(std::memory_order_acquire);
+        uint32_t start = w - SPECTRUM_FFT_SIZE;
+        const int half = SPECTRUM_FFT_SIZE / 2;
+        for (int i = 0; i < SPECTRUM_FFT_SIZE; i++) {
+            float win = (i < half) ? window[i] : (i == half) ? 1.0f : window[SPECTRUM_FFT_SIZE - i];
+            work[i] = ring[(start + i) & (SPECTRUM_RING - 1)] * (1.0f / 32768.0f) * win;
+        }
+
+        // 2. FFT, then power per bin (reuses the first half of the buffer)
+        fft.forward(work);
+        work[0] = 0.0f; // DC (packed with Nyquist) is never displayed
+        for (int k = 1; k < half; k++) {
+            float re = work[2 * k], im = work[2 * k + 1];
+            work[k] = re * re + im * im;
+        }
+
+        // 3. Fold into bands, smooth
+        uint32_t now = millis();
+        float fall = SPECTRUM_DECAY_DB_S * (now - lastFrame) * 0.001f;
+        lastFrame = now;
+        fold(eq, fall);
+        fold(iso, fall);
+
+        portENTER_CRITICAL(&lock);
+        memcpy(eq.out, eq.level, sizeof(float) * eq.count);
+        memcpy(iso.out, iso.level, sizeof(float) * iso.count);
+        portEXIT_CRITICAL(&lock);
+
+        // 4. CPU budget: stretch the period if a frame costs too much
+        lastCostUs = micros() - t0;
+        uint32_t minPeriod = (lastCostUs * 100) / (SPECTRUM_CPU_BUDGET * 1000) + 1;
+        uint32_t target = 1000 / SPECTRUM_RATE_HZ;
+        periodMs = (minPeriod > target) ? minPeriod : target;
+        frames++;
+    }
+
+    // work[k] holds |X[k]|^2 for 1 <= k < N/2
+    void fold(BandSet& b, float fall) {
+        for (int i = 0; i < b.count; i++) {
+            float db = SPECTRUM_FLOOR_DB;
+            if (b.lo[i]) {
+                float p = 0.0f;
+                for (int k = b.lo[i]; k <= b.hi[i]; k++) p += work[k];
+                p *= norm;
+                if (p > 1e-12f) db = 10.0f * log10f(p);
+                if (db < SPECTRUM_FLOOR_DB) db = SPECTRUM_FLOOR_DB;
+            }
+            // Instant rise, limited fall
+            float l = b.level[i] - fall;
+            b.level[i] = (db > l) ? db : l;
+        }
+    }
+};
+
+#endif // SPECTRUM_H
@@ -0,0 +1,29 @@
+/*
+ * host_test.h - Minimal check macros for the host tests
+ *
+ * CHECK(cond, fmt, ...) reports the failure and counts it; TEST_DONE()
+ * prints the summary and is the exit code of main().
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+
+static int testChecks = 0;
+static int testFailures = 0;
+
+#define CHECK(cond, ...) do { \
+        testChecks++; \
+        if (!(cond)) { \
+            testFailures++; \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } while (0)
+
+#define TEST_DONE() \
+    (printf("%s: %d checks, %d failed\n", __FILE__, testChecks, testFailures), testFailures ? 1 : 0)
+
+#endif // HOST_TEST_H
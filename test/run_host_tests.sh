@@ -0,0 +1,20 @@
+#!/bin/sh
+# Host unit tests: each test_*.cpp is one program, built with g++ against
+# the shims in test/stubs (no Arduino core, no FreeRTOS). Usage:
+#   test/run_host_tests.sh            all tests
+#   test/run_host_tests.sh rds        test_rds.cpp only
+cd "$(dirname "$0")" || exit 1
+out=$(mktemp -d) || exit 1
+trap 'rm -rf "$out"' EXIT
+
+fail=0
+for src in test_${1:-*}.cpp; do
+    bin="$out/${src%.cpp}"
+    if ! g++ -std=gnu++11 -O2 -Wall -Wno-unused-function -Wno-sign-compare -Wno-format-truncation -Wno-stringop-truncation -Istubs -I.. "$src" -o "$bin"; then
+        echo "BUILD FAILED: $src"
+        fail=1
+        continue
+    fi
+    "$bin" || fail=1
+done
+exit $fail
@@ -0,0 +1,37 @@
+/*
+ * Arduino.h - Host build shim (test/ only)
+ *
+ * Just enough of the Arduino core for the headers under test. Time is a
+ * counter the test advances: hostMillis() = 100; simulates 100 ms.
+ * ARDUINO is not defined: the sketch's FreeRTOS tasks are left out.
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef uint8_t byte;
+
+#define PI 3.1415926535897932384626433832795
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+inline unsigned long& hostMillis() { static unsigned long t = 0; return t; }
+inline unsigned long millis() { return hostMillis(); }
+inline unsigned long micros() { return hostMillis() * 1000UL; }
+inline void delay(unsigned long ms) { hostMillis() += ms; }
+
+inline long random(long hi) { return hi > 0 ? rand() % hi : 0; }
+inline long random(long lo, long hi) { return hi > lo ? lo + rand() % (hi - lo) : lo; }
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,46 @@
+/*
+ * LiquidCrystal_I2C.h - Host build shim: a recording HD44780
+ *
+ * Keeps what is on the glass (DDRAM, auto-increment after each write) and
+ * counts the bytes sent, so tests can check both the picture and the cost.
+ */
+
+#ifndef HOST_LIQUIDCRYSTAL_I2C_H
+#define HOST_LIQUIDCRYSTAL_I2C_H
+
+#include <stdint.h>
+#include <string.h>
+
+class LiquidCrystal_I2C {
+public:
+    static const int COLS = 20, ROWS = 4;
+    char glass[ROWS][COLS + 1];
+    uint8_t col = 0, row = 0;
+    uint32_t bytes = 0;          // Commands + data
+
+    LiquidCrystal_I2C(uint8_t, uint8_t, uint8_t) { clear(); bytes = 0; }
+
+    void init() {}
+    void backlight() {}
+    void createChar(uint8_t, uint8_t*) { bytes += 9; }
+
+    void clear() {
+        for (int r = 0; r < ROWS; r++) {
+            memset(glass[r], ' ', COLS);
+            glass[r][COLS] = '\0';
+        }
+        col = row = 0;
+        bytes++;
+    }
+
+    void setCursor(uint8_t c, uint8_t r) { col = c; row = r; bytes++; }
+
+    size_t write(uint8_t c) {
+        if (row < ROWS && col < COLS) glass[row][col] = (char)c;
+        col++;
+        bytes++;
+        return 1;
+    }
+};
+
+#endif // HOST_LIQUIDCRYSTAL_I2C_H
@@ -0,0 +1,8 @@
+/*
+ * Wire.h - Host build shim (no I2C bus)
+ */
+
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#endif // HOST_WIRE_H
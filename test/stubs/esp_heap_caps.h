@@ -0,0 +1,22 @@
+/*
+ * esp_heap_caps.h - Host build shim: one plain heap, capabilities ignored
+ */
+
+#ifndef HOST_ESP_HEAP_CAPS_H
+#define HOST_ESP_HEAP_CAPS_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_SPIRAM    (1 << 10)
+#define MALLOC_CAP_INTERNAL  (1 << 11)
+#define MALLOC_CAP_8BIT      (1 << 2)
+
+// Live heap_caps blocks (tests: buffers released)
+inline int& hostCapsBlocks() { static int n = 0; return n; }
+
+inline void* heap_caps_malloc(size_t size, uint32_t) { void* p = malloc(size); if (p) hostCapsBlocks()++; return p; }
+inline void* heap_caps_calloc(size_t n, size_t size, uint32_t) { void* p = calloc(n, size); if (p) hostCapsBlocks()++; return p; }
+inline void heap_caps_free(void* p) { if (p) hostCapsBlocks()--; free(p); }
+
+#endif // HOST_ESP_HEAP_CAPS_H
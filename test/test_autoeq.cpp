@@ -0,0 +1,90 @@
+/*
+ * test_autoeq.cpp - Auto-EQ fit against a known room
+ *
+ * The "measured" response is a room built from the EQ's own peaking
+ * filters (Biquad::setPeaking, evaluated from the coefficients in double)
+ * plus a level offset, on the 1/6 octave grid of measure.h. The fit must
+ * find the inverse gains, flatten the corrected response, stop within
+ * AUTOEQ_MAX_ITER iterations and give the same result on every run.
+ */
+
+#include "host_test.h"
+#include "autoeq.h"
+#include "measure.h"   // MEAS_POINTS, MEAS_F1 (grid of the input)
+
+static const float roomDb[EQ_BANDS] = { 0, 6, 0, -3, 0, 0, -4, 3, 0, 0 };
+#define ROOM_LEVEL_DB  2.0f
+
+// |H| in dB of a biquad at f (coefficients as stored, evaluated in double)
+static double biquadDb(const Biquad& q, double f) {
+    double w = 2.0 * M_PI * f / 44100.0;
+    double cr = cos(w), ci = -sin(w), c2r = cos(2 * w), c2i = -sin(2 * w);
+    double nr = q.b0 + q.b1 * cr + q.b2 * c2r, ni = q.b1 * ci + q.b2 * c2i;
+    double dr = 1.0 + q.a1 * cr + q.a2 * c2r, di = q.a1 * ci + q.a2 * c2i;
+    return 10.0 * log10((nr * nr + ni * ni) / (dr * dr + di * di));
+}
+
+static double eqDb(const float* gains, double f) {
+    double db = 0.0;
+    for (int j = 0; j < EQ_BANDS; j++) {
+        Biquad q;
+        q.setPeaking(EQ_FREQS[j], gains[j], EQ_Q);
+        db += biquadDb(q, f);
+    }
+    return db;
+}
+
+static int runFit(AutoEQ& aeq, const float* f, const float* db, float boost, float* gains) {
+    if (!aeq.start(f, db, MEAS_POINTS, AUTOEQ_F_LO, AUTOEQ_F_HI, 0.0f, boost)) return -1;
+    int steps = 0;
+    while (aeq.step()) steps++;
+    for (int j = 0; j < EQ_BANDS; j++) gains[j] = aeq.getGain(j);
+    return steps;
+}
+
+int main() {
+    float f[MEAS_POINTS], db[MEAS_POINTS];
+    for (int i = 0; i < MEAS_POINTS; i++) {
+        f[i] = MEAS_F1 * powf(2.0f, i / 6.0f);
+        db[i] = (float)eqDb(roomDb, f[i]) + ROOM_LEVEL_DB;
+    }
+
+    // --- 1. Fit: inverse gains, flat result, bounded run ---
+    static AutoEQ aeq;
+    float gains[EQ_BANDS];
+    int steps = runFit(aeq, f, db, AUTOEQ_MAX_BOOST, gains);
+    CHECK(steps >= 0 && aeq.getState() == AEQ_DONE, "state %d", aeq.getState());
+    CHECK(aeq.getIterations() <= AUTOEQ_MAX_ITER, "%d iterations", aeq.getIterations());
+    for (int j = 0; j < EQ_BANDS; j++) {
+        CHECK(fabsf(gains[j] + roomDb[j]) <= 1.0f, "band %d (%.0f Hz): %+.1f dB, room %+.1f dB",
+              j, EQ_FREQS[j], gains[j], roomDb[j]);
+        CHECK(fmodf(fabsf(gains[j]), AUTOEQ_STEP_DB) == 0.0f, "band %d: %.3f dB off the slider step", j, gains[j]);
+    }
+    CHECK(fabsf(aeq.getLevel() + ROOM_LEVEL_DB) < 0.5f, "level %+.2f dB", aeq.getLevel());
+    CHECK(aeq.getErrorAfter() < 0.25f * aeq.getErrorBefore(), "RMS error %.2f -> %.2f dB",
+          aeq.getErrorBefore(), aeq.getErrorAfter());
+
+    // Room + fitted EQ through the real filters: flat within 1 dB
+    for (int i = 0; i < MEAS_POINTS; i++) {
+        if (f[i] < AUTOEQ_F_LO || f[i] > AUTOEQ_F_HI) continue;
+        double corrected = db[i] + eqDb(gains, f[i]) + aeq.getLevel();
+        CHECK(fabs(corrected) < 1.0, "%.0f Hz: %+.2f dB after correction", f[i], corrected);
+    }
+
+    // --- 2. Same input, same gains (no state carried between runs) ---
+    float again[EQ_BANDS];
+    int iters = aeq.getIterations();
+    runFit(aeq, f, db, AUTOEQ_MAX_BOOST, again);
+    CHECK(memcmp(gains, again, sizeof(gains)) == 0 && aeq.getIterations() == iters, "second run differs");
+
+    // --- 3. A deep null is not filled beyond the boost limit ---
+    for (int i = 0; i < MEAS_POINTS; i++) {
+        float oct = log2f(f[i] / 250.0f);
+        db[i] = -15.0f * expf(-oct * oct * 8.0f); // ~1/2 octave wide, -15 dB
+    }
+    runFit(aeq, f, db, 3.0f, gains);
+    for (int j = 0; j < EQ_BANDS; j++) CHECK(gains[j] <= 3.0f, "band %d: %+.1f dB over the limit", j, gains[j]);
+    CHECK(gains[3] == 3.0f, "250 Hz: %+.1f dB (limit +3)", gains[3]);
+
+    return TEST_DONE();
+}
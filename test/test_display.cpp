@@ -0,0 +1,105 @@
+/*
+ * test_display.cpp - UI render path: zero heap allocations per frame
+ *
+ * Renders every screen for a simulated week of display frames (100 ms)
+ * with changing track, RDS and memory texts, composed as updateDisplay()
+ * does (MetadataMailbox snapshot + snprintf into a static buffer).
+ * Global operator new/malloc are not used by the UI: a counting operator
+ * new must read zero after the first frame, so the heap cannot fragment.
+ * Also checks the picture on the glass and that a still frame costs no I2C.
+ */
+
+#include <new>
+#include "host_test.h"
+#include "displayinfo.h"
+#include "metadata.h"
+
+// ==========================================
+// ALLOCATION COUNTER
+// ==========================================
+static unsigned long allocations = 0;
+
+void* operator new(size_t size) {
+    allocations++;
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+#define FRAMES_PER_WEEK  (7UL * 24 * 3600 * 10) // 100 ms frames
+
+static bool rowIs(LiquidCrystal_I2C& lcd, int row, const char* text) {
+    return strncmp(lcd.glass[row], text, LiquidCrystal_I2C::COLS) == 0;
+}
+
+int main() {
+    LiquidCrystal_I2C lcd(0x27, 20, 4);
+    DisplayUI ui(&lcd);
+    MetadataMailbox btMeta;
+    ui.begin();
+
+    // --- 1. Picture: BT screen, then a still frame costs nothing ---
+    btMeta.setText(META_ATTR_ARTIST, (const uint8_t*)"Queen");
+    btMeta.setText(META_ATTR_TITLE, (const uint8_t*)"Innuendo");
+    TrackInfo meta;
+    btMeta.read(meta);
+    static char track[UI_TEXT_MAX];
+    snprintf(track, sizeof(track), "%s - %s", meta.artist, meta.title);
+    ui.screenBT(true, false, 7, "Pixel", track, PLAY_PLAYING, META_POS_UNKNOWN, 0, 0);
+    CHECK(rowIs(lcd, 0, "BLUE    LOUD      07"), "status row '%s'", lcd.glass[0]);
+    CHECK(rowIs(lcd, 1, "Pixel              >"), "device row '%s'", lcd.glass[1]);
+    CHECK(rowIs(lcd, 2, "Queen - Innuendo    "), "track row '%s'", lcd.glass[2]);
+    ui.screenBT(true, false, 7, "Pixel", track, PLAY_PLAYING, META_POS_UNKNOWN, 0, 0);
+    CHECK(ui.getLastFrameBytes() == 0, "still frame sent %u bytes", ui.getLastFrameBytes());
+
+    // --- 2. A week of frames across all screens ---
+    static char rdsName[9], rdsText[65], labels[8][9];
+    const char* memNames[8];
+    for (int i = 0; i < 8; i++) memNames[i] = labels[i];
+
+    unsigned long before = allocations;
+    for (unsigned long f = 0; f < FRAMES_PER_WEEK; f++) {
+        hostMillis() += 100;
+        int vu = (int)(f % 101);
+
+        switch ((f / 600) % 4) { // New screen every minute
+            case 0:
+                if (f % 300 == 0) { // New track every 30 s
+                    char t[META_TEXT_LEN];
+                    snprintf(t, sizeof(t), "A rather long song title number %lu", f / 300);
+                    btMeta.setText(META_ATTR_TITLE, (const uint8_t*)t);
+                    btMeta.setPosition((uint32_t)(f % 7) * 1000);
+                }
+                btMeta.read(meta);
+                if (meta.title[0] == '\0') snprintf(track, sizeof(track), "Connected");
+                else if (meta.artist[0] == '\0') snprintf(track, sizeof(track), "%s", meta.title);
+                else snprintf(track, sizeof(track), "%s - %s", meta.artist, meta.title);
+                ui.screenBT(f & 1, f & 2, 15, "Pixel", track, meta.playState,
+                            meta.positionAt(millis()), vu, 100 - vu);
+                break;
+            case 1:
+                snprintf(rdsName, sizeof(rdsName), "ST%06lu", f % 1000);
+                snprintf(rdsText, sizeof(rdsText), "Now playing item %lu of the evening programme", f / 50);
+                ui.screenRadio(false, true, 20, 87.5f + (f % 205) * 0.1f, (int)(f % 9), rdsName,
+                               rdsText, f & 4, vu, vu);
+                break;
+            case 2:
+                for (int i = 0; i < 8; i++) snprintf(labels[i], sizeof(labels[i]), "%c%lu", 'A' + i, f % 97);
+                ui.screenMemories(memNames, (int)(f % 8) + 1);
+                break;
+            default:
+                ui.setSpectrumRow(f & 8);
+                ui.screenAux(true, true, 30, true, (int)(f % 4), f & 16, 100.0f, vu, vu, f & 32);
+                break;
+        }
+    }
+    unsigned long perWeek = allocations - before;
+    CHECK(perWeek == 0, "%lu heap allocations over %lu frames", perWeek, FRAMES_PER_WEEK);
+
+    return TEST_DONE();
+}
@@ -0,0 +1,135 @@
+/*
+ * test_measure.cpp - Swept-sine measurement through a simulated loopback
+ *
+ * The played block goes through a known system before it comes back as
+ * the ADC block of a later call:
+ *   y = gain * (x + a2 * x^2), delayed by MEAS_TEST_DELAY samples
+ * x^2 puts a 2nd harmonic of a2 * A / 2 on a sine of amplitude A, so
+ * THD = a2 * MEAS_LEVEL / 2 (the sweep plays at MEAS_LEVEL).
+ * The run is driven as the worker task would: step() until it waits for
+ * the capture, process() per audio block, step() until done.
+ * A mode switch mid-sweep is cancel() from the audio side: the buffers go
+ * and the next start() works.
+ */
+
+#include "host_test.h"
+#include "measure.h"
+
+#define MEAS_TEST_DELAY   300     // Samples (> one audio block)
+#define MEAS_TEST_GAIN    0.5f    // -6.02 dB
+#define MEAS_TEST_A2      0.4f    // THD = 0.4 * 0.25 / 2 = 5 %
+#define MEAS_TEST_FRAMES  128     // Audio block
+
+struct Loopback {
+    float gain, a2;
+    float* played;                // Every DAC sample, normalized
+    uint32_t len;
+};
+
+// Runs one measurement; returns false if it did not complete
+static bool runMeasurement(Measurement& m, Loopback& sys) {
+    if (!m.start()) return false;
+    while (m.getState() == MEAS_PREPARE) m.step();
+    if (!m.isPlaying()) return false;
+
+    int32_t buf[MEAS_TEST_FRAMES * 2];
+    uint32_t p = 0;
+    while (m.isPlaying() && p + MEAS_TEST_FRAMES <= sys.len) {
+        for (int i = 0; i < MEAS_TEST_FRAMES; i++) {
+            long n = (long)(p + i) - MEAS_TEST_DELAY;
+            float x = (n >= 0) ? sys.played[n] : 0.0f;
+            float y = sys.gain * (x + sys.a2 * x * x);
+            buf[i * 2] = (int32_t)(y * 2147483647.0f);
+            buf[i * 2 + 1] = 0;
+        }
+        m.process(buf, MEAS_TEST_FRAMES);
+        for (int i = 0; i < MEAS_TEST_FRAMES; i++) sys.played[p + i] = buf[i * 2] * (1.0f / 2147483648.0f);
+        p += MEAS_TEST_FRAMES;
+    }
+    while (m.step()) {}
+    return m.getState() == MEAS_DONE;
+}
+
+int main() {
+    static Measurement m;
+    Loopback sys;
+    sys.len = 1 << 18; // > sweep + latency window
+    sys.played = (float*)calloc(sys.len, sizeof(float));
+
+    // --- 1. Ideal loopback: flat 0 dB, no distortion ---
+    sys.gain = 1.0f; sys.a2 = 0.0f;
+    CHECK(runMeasurement(m, sys), "ideal loopback: state %d", m.getState());
+    CHECK(m.getLatency() == MEAS_TEST_DELAY, "ideal loopback: latency %d", m.getLatency());
+    for (int i = 0; i < m.getPointCount(); i++) {
+        float f = m.getFreq(i);
+        if (f > 16000.0f) continue;
+        CHECK(fabsf(m.getDb(i)) < 0.1f, "ideal loopback: %.0f Hz %.2f dB", f, m.getDb(i));
+        if (f >= 100.0f && f <= 8000.0f) CHECK(m.getThd(i) < 0.1f, "ideal loopback: %.0f Hz THD %.3f %%", f, m.getThd(i));
+    }
+    float idealPeakDb = m.getPeakDb(); // Band-limited impulse: below 0 dB
+
+    // --- 2. Gain, delay and a 2nd harmonic ---
+    sys.gain = MEAS_TEST_GAIN; sys.a2 = MEAS_TEST_A2;
+    memset(sys.played, 0, sizeof(float) * sys.len);
+    CHECK(runMeasurement(m, sys), "loopback: state %d", m.getState());
+    CHECK(m.getLatency() == MEAS_TEST_DELAY, "loopback: latency %d", m.getLatency());
+    CHECK(fabsf(m.getLatencyMs() - MEAS_TEST_DELAY * 1000.0f / MEAS_FS) < 0.01f, "loopback: %.2f ms", m.getLatencyMs());
+
+    const float wantDb = 20.0f * log10f(MEAS_TEST_GAIN);
+    const float wantThd = 100.0f * MEAS_TEST_A2 * MEAS_LEVEL / 2.0f;
+    for (int i = 0; i < m.getPointCount(); i++) {
+        float f = m.getFreq(i);
+        if (f > 16000.0f) continue;
+        CHECK(fabsf(m.getDb(i) - wantDb) < 0.1f, "loopback: %.0f Hz %.2f dB (want %.2f)", f, m.getDb(i), wantDb);
+        // 2nd harmonic inside the sweep band. Below 100 Hz the harmonic
+        // window (MEAS_HARM_LEN, ~43 Hz resolution) reads low.
+        if (f >= 100.0f && f <= 8000.0f) {
+            CHECK(fabsf(m.getThd(i) - wantThd) < 0.1f * wantThd, "loopback: %.0f Hz THD %.2f %% (want %.2f)",
+                  f, m.getThd(i), wantThd);
+        }
+    }
+
+    // --- 3. IR: peak at MEAS_PRE, MEAS_TEST_GAIN below the ideal loopback ---
+    const float* ir = m.getIR();
+    CHECK(ir != nullptr, "no IR");
+    if (ir) {
+        int peak = 0;
+        for (int i = 1; i < m.getIRLength(); i++) if (fabsf(ir[i]) > fabsf(ir[peak])) peak = i;
+        CHECK(peak == MEAS_PRE, "IR peak at %d", peak);
+        CHECK(fabsf(m.getPeakDb() - idealPeakDb - wantDb) < 0.1f, "IR peak %.2f dB (ideal %.2f)",
+              m.getPeakDb(), idealPeakDb);
+    }
+
+    // --- 4. Cancel during the sweep (mode switch) and during prepare ---
+    int32_t buf[MEAS_TEST_FRAMES * 2] = {};
+    int kept = hostCapsBlocks(); // The IR outlives a run
+    CHECK(m.start(), "cancel: start");
+    while (m.getState() == MEAS_PREPARE) m.step();
+    m.process(buf, MEAS_TEST_FRAMES);
+    int progress = m.getProgress();
+    m.cancel();
+    CHECK(!m.isPlaying(), "cancel: still playing");
+    m.process(buf, MEAS_TEST_FRAMES);
+    CHECK(m.getProgress() == progress, "cancel: capture went on (%d%%)", m.getProgress());
+    CHECK(!m.step(), "cancel: worker has more work");
+    CHECK(m.getState() == MEAS_ERROR, "cancel: state %d", m.getState());
+    CHECK(!m.isBusy(), "cancel: busy");
+    CHECK(hostCapsBlocks() == kept, "cancel: %d buffers left", hostCapsBlocks() - kept);
+
+    CHECK(m.start(), "cancel in prepare: start");
+    m.step();
+    m.cancel();
+    while (m.step()) {}
+    CHECK(m.getState() == MEAS_ERROR && hostCapsBlocks() == kept, "cancel in prepare: state %d, %d buffers left",
+          m.getState(), hostCapsBlocks() - kept);
+
+    sys.gain = 1.0f; sys.a2 = 0.0f;
+    memset(sys.played, 0, sizeof(float) * sys.len);
+    CHECK(runMeasurement(m, sys), "after cancel: state %d", m.getState());
+    CHECK(m.getLatency() == MEAS_TEST_DELAY, "after cancel: latency %d", m.getLatency());
+    m.cancel(); // Done: nothing to cancel
+    CHECK(m.getState() == MEAS_DONE && m.getIR() != nullptr, "cancel after done: state %d", m.getState());
+
+    free(sys.played);
+    return TEST_DONE();
+}
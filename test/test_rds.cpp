@@ -0,0 +1,124 @@
+/*
+ * test_rds.cpp - RdsDecoder against group dumps (test/data/rds_*.txt)
+ *
+ * Each dump is the same programme: PS, RadioText A then B (A/B toggle),
+ * CT twice, AF in the 0A groups. Received clean, with block error flags
+ * (weak signal), and with undetected errors. The decoded PS, RT, CT and AF
+ * must be the same in all three, and a corrupted value must never be
+ * shown on the way.
+ *
+ * The dumps use the tuner's register layout (blocks + BLER per block) and
+ * are built from a known programme, so the expected output is exact.
+ * The polled dump is the clean one as pollRDS() reads it, each group on
+ * 2-3 polls: through RdsRepeatFilter it must feed the same groups.
+ */
+
+#include "host_test.h"
+#include "rdsdecoder.h"
+
+#define RDS_TEST_PS     "RADIO 1 "
+#define RDS_TEST_RT_A   "Now playing: Queen - Innuendo"
+#define RDS_TEST_RT_B   "Traffic update at six"
+#define RDS_TEST_MJD    61331   // 2026-10-18
+
+// Feeds a dump; checks the invariants after every group.
+// Lines "@ms ..." are poll reads: fed through the repeat filter.
+// Returns the number of groups fed, -1 if the file is missing.
+static int feedDump(const char* path, RdsDecoder& rds, bool& sawRtA) {
+    FILE* f = fopen(path, "r");
+    if (!f) return -1;
+
+    RdsRepeatFilter repeat;
+    char line[128];
+    int groups = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+        unsigned long t = 0;
+        int skip = 0;
+        if (line[0] == '@' && sscanf(line, "@%lu %n", &t, &skip) != 1) continue;
+        const char* g = line + skip;
+        unsigned a, b, c, d;
+        char err[8];
+        if (sscanf(g, "%x %x %x %x %4s", &a, &b, &c, &d, err) != 5) continue;
+        uint16_t blocks[4] = { (uint16_t)a, (uint16_t)b, (uint16_t)c, (uint16_t)d };
+        if (line[0] == '@' && repeat.isRepeat(blocks, t)) continue;
+        uint8_t bler[4];
+        for (int i = 0; i < 4; i++) {
+            bler[i] = (err[i] == 'F') ? RDS_BLER_UNKNOWN : (uint8_t)(err[i] - '0');
+        }
+        rds.feedGroup(blocks, bler);
+        groups++;
+
+        // Every accepted PS character is the right one
+        const char* ps = rds.getPS();
+        for (int i = 0; i < RDS_PS_LEN; i++) {
+            CHECK(ps[i] == ' ' || ps[i] == RDS_TEST_PS[i], "%s group %d: PS '%s'", path, groups, ps);
+        }
+
+        // RT is part of A or B (blanks where unconfirmed)
+        const char* rt = rds.getRadioText();
+        bool matchA = true, matchB = true;
+        for (int i = 0; rt[i]; i++) {
+            if (rt[i] == ' ') continue;
+            if (i >= (int)strlen(RDS_TEST_RT_A) || rt[i] != RDS_TEST_RT_A[i]) matchA = false;
+            if (i >= (int)strlen(RDS_TEST_RT_B) || rt[i] != RDS_TEST_RT_B[i]) matchB = false;
+        }
+        CHECK(matchA || matchB, "%s group %d: RT '%s'", path, groups, rt);
+        if (strcmp(rt, RDS_TEST_RT_A) == 0) sawRtA = true;
+
+        // A clock is only ever shown with the broadcast values
+        const RdsClock& ct = rds.getClock();
+        if (ct.valid) {
+            CHECK(ct.mjd == RDS_TEST_MJD && ct.hour == 14 && (ct.minute == 30 || ct.minute == 31),
+                  "%s group %d: CT %u %02u:%02u", path, groups, (unsigned)ct.mjd, ct.hour, ct.minute);
+        }
+    }
+    fclose(f);
+    return groups;
+}
+
+// Returns the number of groups fed
+static int checkDump(const char* path, int expectDropped) {
+    RdsDecoder rds;
+    bool sawRtA = false;
+    int groups = feedDump(path, rds, sawRtA);
+    CHECK(groups > 0, "%s: no groups (missing file?)", path);
+    if (groups <= 0) return groups;
+
+    CHECK(rds.getPI() == 0xD3C2, "%s: PI %04X", path, rds.getPI());
+    CHECK(rds.getPTY() == 10, "%s: PTY %u", path, rds.getPTY());
+    CHECK(rds.getTP(), "%s: TP", path);
+    CHECK(rds.psComplete() && strcmp(rds.getPS(), RDS_TEST_PS) == 0, "%s: PS '%s'", path, rds.getPS());
+
+    // RT A was complete before the toggle, B replaced it (no A leftovers)
+    CHECK(sawRtA, "%s: RT A never complete", path);
+    CHECK(strcmp(rds.getRadioText(), RDS_TEST_RT_B) == 0, "%s: RT '%s'", path, rds.getRadioText());
+
+    const RdsClock& ct = rds.getClock();
+    CHECK(ct.valid && ct.mjd == RDS_TEST_MJD && ct.hour == 14 && ct.minute == 31 && ct.offset == 4,
+          "%s: CT valid %d, %u %02u:%02u %+d", path, ct.valid, (unsigned)ct.mjd, ct.hour, ct.minute, ct.offset);
+
+    // AF list in order of arrival (a lost block C reorders it)
+    const uint16_t af[3] = { 8810, 9530, 10170 };
+    CHECK(rds.getAFCount() == 3, "%s: %u AFs", path, rds.getAFCount());
+    for (int i = 0; i < 3; i++) {
+        bool found = false;
+        for (int j = 0; j < rds.getAFCount(); j++) found |= rds.getAF(j) == af[i];
+        CHECK(found, "%s: AF %u missing", path, af[i]);
+    }
+
+    const RdsStats& st = rds.getStats();
+    CHECK((int)st.groups == groups, "%s: %u groups counted", path, (unsigned)st.groups);
+    CHECK((int)st.dropped == expectDropped, "%s: %u groups dropped, expected %d", path,
+          (unsigned)st.dropped, expectDropped);
+    return groups;
+}
+
+int main() {
+    int clean = checkDump("data/rds_clean.txt", 0);
+    checkDump("data/rds_bler.txt", 4);   // Uncorrectable block B
+    checkDump("data/rds_corrupt.txt", 0);
+    int polled = checkDump("data/rds_polled.txt", 0);
+    CHECK(polled == clean, "polled: %d groups fed, %d transmitted", polled, clean);
+    return TEST_DONE();
+}
@@ -5,86 +5,323 @@
 #include <Arduino.h>
 
 // ==========================================================
-// SHARED HELPER: ENVELOPE FOLLOWER
+// SHARED HELPER: BLOCK ENVELOPE DETECTOR
 // ==========================================================
-class EnvelopeFollower {
+// Runs the sidechain over a whole buffer and returns one control value
+// per ENV_DECIM frames (the gain computers only need that rate).
+// - Detector input: peak max(|l|,|r|), mean-abs (|l|+|r|)/2 or mean square
+//   (l^2+r^2)/2; unlinked: one envelope per channel. r == nullptr: mono.
+// - Attack/release without branches: for d = x - env,
+//     max(env + att*d, env + rel*d)
+//   picks the attack when rising and the release when falling (att > rel).
+// - ENV_RMS returns the mean square: sqrt/log only at control rate.
+#define ENV_DECIM       16    // Frames per control value (0.36 ms)
+#define ENV_MAX_BLOCK   128   // Frames per call (callers chunk)
+#define ENV_MAX_CTL     (ENV_MAX_BLOCK / ENV_DECIM)
+
+enum EnvMode { ENV_PEAK, ENV_MEAN_ABS, ENV_RMS };
+
+// One-pole coefficient for a time constant at 'rate' updates per second
+inline float envCoef(float ms, float rate) {
+    return 1.0f - expf(-1.0f / (ms * 0.001f * rate));
+}
+
+// One attack/release update (att > rel). Shared with callers that detect
+// per sample but run the envelope at control rate (mbcomp.h).
+inline float envStep(float env, float x, float att, float rel) {
+    float d = x - env;
+    return fmaxf(env + att * d, env + rel * d);
+}
+
+class BlockEnvelope {
 private:
-    float envelope = 0.0f;
-    float attackCoef = 0.1f;
-    float releaseCoef = 0.005f;
+    float env[2] = {0.0f, 0.0f};
+    float att = 0.1f, rel = 0.005f;
+    EnvMode mode = ENV_MEAN_ABS;
+    bool linked = true;
+
 public:
-    // Configures response speed.
-    // fastAttack (ms): How quickly it reacts to loud peaks.
-    // slowRelease (ms): How slowly it fades out (prevents "pumping").
-    void init(float attackMs, float releaseMs, float sampleRate = 44100.0f) {
-        // Calculate coefficients for 1-pole LPF
-        attackCoef = 1.0f - expf(-1.0f / (attackMs * 0.001f * sampleRate));
-        releaseCoef = 1.0f - expf(-1.0f / (releaseMs * 0.001f * sampleRate));
-        envelope = 0.0f;
-    }
-
-    inline float process(float in) {
-        float absIn = fabsf(in);
-        if (absIn > envelope) envelope += attackCoef * (absIn - envelope);
-        else envelope += releaseCoef * (absIn - envelope);
-        return envelope;
+    // attackMs <= releaseMs
+    void init(float attackMs, float releaseMs, EnvMode m = ENV_MEAN_ABS,
+              bool stereoLink = true, float sampleRate = 44100.0f) {
+        att = envCoef(attackMs, sampleRate);
+        rel = envCoef(releaseMs, sampleRate);
+        mode = m;
+        linked = stereoLink;
+        env[0] = env[1] = 0.0f;
+    }
+
+    // frames <= ENV_MAX_BLOCK. Writes ceil(frames / ENV_DECIM) values to ctl
+    // (and ctlR when unlinked). Returns the count.
+    int process(const float* l, const float* r, int frames, float* ctl, float* ctlR = nullptr) {
+        int count = 0;
+        bool stereo = (r != nullptr);
+        bool split = stereo && !linked && ctlR;
+        float e0 = env[0], e1 = env[1];
+        for (int start = 0; start < frames; start += ENV_DECIM) {
+            int end = start + ENV_DECIM;
+            if (end > frames) end = frames;
+            for (int i = start; i < end; i++) {
+                float x0, x1 = 0.0f;
+                if (mode == ENV_RMS) {
+                    x0 = l[i] * l[i];
+                    if (stereo) x1 = r[i] * r[i];
+                } else {
+                    x0 = fabsf(l[i]);
+                    if (stereo) x1 = fabsf(r[i]);
+                }
+                if (!split && stereo) {
+                    x0 = (mode == ENV_PEAK) ? fmaxf(x0, x1) : 0.5f * (x0 + x1);
+                }
+                e0 = envStep(e0, x0, att, rel);
+                if (split) e1 = envStep(e1, x1, att, rel);
+            }
+            ctl[count] = e0;
+            if (split) ctlR[count] = e1;
+            count++;
+        }
+        env[0] = e0;
+        env[1] = e1;
+        return count;
     }
 };
 
 // ==========================================================
-// 1. RIAA ENGINE (Vinyl Phono Stage)
+// SHARED HELPER: SLIDING HIGH SHELF (Dolby B/C)
 // ==========================================================
-class RIAA_Engine {
+// TPT state-variable filter with a FIXED cutoff. The shelf gain lives only
+// in the output mix: y = lp + k*A*bp + A^2*hp (A = 10^(dB/40)).
+// - Poles stay at fc, zeros slide to fc/A: the cut starts at fc and
+//   reaches full depth higher up (a sliding band).
+// - Modulating the gain never touches the filter state: per-sample
+//   tracking without zipper noise and without trig/pow on the audio path.
+// The mix coefficients come from a table indexed by the normalized
+// envelope (0 = full cut .. 1 = flat), linearly interpolated.
+#define SHELF_TABLE_SIZE   32
+#define VINTAGE_INV_FS     (1.0f / 2147483648.0f) // int32 scale -> +/-1.0
+
+class SlidingShelf {
 private:
-    Biquad lowShelf, highShelf;
+    float a1 = 0, a2 = 0, a3 = 0, k = 1.414f;
+    float ic1[2] = {0, 0}, ic2[2] = {0, 0};
+    float mixBp[SHELF_TABLE_SIZE + 1]; // k*A
+    float mixHp[SHELF_TABLE_SIZE + 1]; // A^2
+
 public:
-    void init() {
-        // Standard RIAA Curve: Bass Boost (+20dB), Treble Cut (-20dB)
-        lowShelf.setLowShelf(500.0, 19.0, 0.707);
-        highShelf.setHighShelf(2122.0, -19.0, 0.707);
+    // maxCutDb (< 0) at position 0, flat at position 1 (linear in dB)
+    void init(float fc, float maxCutDb, float q = 0.707f, float sampleRate = 44100.0f) {
+        float g = tanf(PI * fc / sampleRate);
+        k = 1.0f / q;
+        a1 = 1.0f / (1.0f + g * (g + k));
+        a2 = g * a1;
+        a3 = g * a2;
+        for (int i = 0; i <= SHELF_TABLE_SIZE; i++) {
+            float db = maxCutDb * (1.0f - (float)i / SHELF_TABLE_SIZE);
+            float A = powf(10.0f, db / 40.0f);
+            mixBp[i] = k * A;
+            mixHp[i] = A * A;
+        }
+        ic1[0] = ic1[1] = ic2[0] = ic2[1] = 0.0f;
     }
 
-    inline void process(float &l, float &r) {
-        lowShelf.process(l, r);
-        highShelf.process(l, r);
+    // pos: 0..1 (clamped by the caller)
+    inline void process(float &l, float &r, float pos) {
+        float idx = pos * SHELF_TABLE_SIZE;
+        int i = (int)idx;
+        if (i >= SHELF_TABLE_SIZE) i = SHELF_TABLE_SIZE - 1;
+        float f = idx - i;
+        float mb = mixBp[i] + f * (mixBp[i + 1] - mixBp[i]);
+        float mh = mixHp[i] + f * (mixHp[i + 1] - mixHp[i]);
+        l = tick(0, l, mb, mh);
+        r = tick(1, r, mb, mh);
+    }
+
+private:
+    inline float tick(int c, float x, float mb, float mh) {
+        float v3 = x - ic2[c];
+        float v1 = a1 * ic1[c] + a2 * v3; // Band pass
+        float v2 = ic2[c] + a2 * ic1[c] + a3 * v3; // Low pass
+        ic1[c] = 2.0f * v1 - ic1[c];
+        ic2[c] = 2.0f * v2 - ic2[c];
+        float hp = x - k * v1 - v2;
+        return v2 + mb * v1 + mh * hp;
     }
 };
 
 // ==========================================================
-// 2. DOLBY B ENGINE (Single Stage Tape NR)
+// SHARED HELPER: FIRST ORDER SHELF (emphasis networks)
 // ==========================================================
-class DolbyB_Engine {
+// H(s) = (1 + s/wz) / (1 + s/wp), bilinear with prewarped corners.
+// wz < wp: boost of wp/wz above the corners, wz > wp: cut.
+class FirstOrderShelf {
 private:
-    Biquad filter;
-    EnvelopeFollower env;
-    int skipCounter = 0;
+    float b0 = 1, b1 = 0, a1 = 0;
+    float x1[2] = {0, 0}, y1[2] = {0, 0};
 
 public:
-    void init() {
-        filter.setHighShelf(5000.0, 0.0, 1.0); // Start Flat
-        env.init(10.0f, 100.0f); // Fast attack (10ms), Medium release (100ms)
+    void init(float zeroHz, float poleHz, float sampleRate = 44100.0f) {
+        float K = 2.0f * sampleRate;
+        float wz = K * tanf(PI * zeroHz / sampleRate);
+        float wp = K * tanf(PI * poleHz / sampleRate);
+        float a0 = 1.0f + K / wp;
+        b0 = (1.0f + K / wz) / a0;
+        b1 = (1.0f - K / wz) / a0;
+        a1 = (1.0f - K / wp) / a0;
+        x1[0] = x1[1] = y1[0] = y1[1] = 0.0f;
+    }
+
+    // Direct z-domain section: g * (1 - zero z^-1) / (1 - pole z^-1)
+    void setZeroPole(float zero, float pole, float g = 1.0f) {
+        b0 = g;
+        b1 = -g * zero;
+        a1 = -pole;
+        x1[0] = x1[1] = y1[0] = y1[1] = 0.0f;
+    }
+
+    inline float process(int c, float x) {
+        float y = b0 * x + b1 * x1[c] - a1 * y1[c];
+        x1[c] = x;
+        y1[c] = y;
+        return y;
     }
+};
+
+// ==========================================================
+// 1. RIAA ENGINE (Vinyl Phono Stage)
+// ==========================================================
+// Playback curve from the time constants (RIAA / IEC 60098):
+//   H(s) = (1 + s*T2) / ((1 + s*T1) * (1 + s*T3))
+// 1. Biquad: poles and the 318 us zero by matched z (p = e^(-1/(T*fs))),
+//    second zero at -beta.
+// 2. First-order correction (zero zc, pole pc): matched z loses the HF
+//    slope towards Nyquist; beta/zc/pc are fitted offline per sample rate
+//    for < 0.035 dB error 20 Hz - 20 kHz.
+// 3. Optional IEC rumble filter (7950 us): one more first-order section.
+// Gain normalized to 0 dB at 1 kHz (+19.3 dB at 20 Hz, -19.6 dB at 20 kHz).
+#define RIAA_T1_US          3180.0f
+#define RIAA_T2_US          318.0f
+#define RIAA_T3_US          75.0f
+#define RIAA_IEC_US         7950.0f
+#define RIAA_IEC_DEFAULT    false   // IEC amendment (20 Hz rumble roll-off)
+#define RIAA_REF_HZ         1000.0f
+#define RIAA_CYCLE_BUDGET   60      // CPU cycles per stereo sample (with IEC)
+
+struct RiaaFit { float fs, beta, zc, pc; };
+
+// Minimax fit of the correction (max error 20 Hz - 20 kHz in the comment)
+static const RiaaFit RIAA_FITS[] = {
+    { 44100.0f, 0.487047f, -0.080480f, -0.394539f }, // 0.031 dB
+    { 48000.0f, 0.047866f, -0.372623f, -0.252835f }, // 0.025 dB
+    { 88200.0f, 0.044263f, -0.306590f, -0.195795f }, // < 0.001 dB
+    { 96000.0f, 0.056458f, -0.378975f, -0.267315f }, // < 0.001 dB
+};
+
+class RIAA_Engine {
+private:
+    Biquad curve;
+    FirstOrderShelf corr, iec;
+    bool rumble = false;
+
+public:
+    // Unlisted sample rates: matched z only (several dB off near Nyquist)
+    void init(bool iecRumble = RIAA_IEC_DEFAULT, float sampleRate = 44100.0f) {
+        RiaaFit fit = { sampleRate, 0.0f, 0.0f, 0.0f };
+        for (unsigned i = 0; i < sizeof(RIAA_FITS) / sizeof(RIAA_FITS[0]); i++) {
+            if (RIAA_FITS[i].fs == sampleRate) fit = RIAA_FITS[i];
+        }
+
+        float p1 = expf(-1e6f / (RIAA_T1_US * sampleRate));
+        float z2 = expf(-1e6f / (RIAA_T2_US * sampleRate));
+        float p3 = expf(-1e6f / (RIAA_T3_US * sampleRate));
 
-    inline void process(float &l, float &r) {
-        // Mono detection for stereo link
-        float lvl = env.process((l + r) * 0.5f);
+        // 1. Biquad (1 - z2 z^-1)(1 + beta z^-1) / ((1 - p1 z^-1)(1 - p3 z^-1))
+        curve.b0 = 1.0f;
+        curve.b1 = fit.beta - z2;
+        curve.b2 = -z2 * fit.beta;
+        curve.a1 = -(p1 + p3);
+        curve.a2 = p1 * p3;
 
-        // OPTIMIZATION: Update coefficients only every 64 samples
-        if (++skipCounter >= 64) {
-            float threshold = 0.25f; // ~ -12dB activation point
-            float gainCut = 0.0f;
+        // 2. Correction, then normalize both to 0 dB at the reference
+        corr.setZeroPole(fit.zc, fit.pc);
+        float w = 2.0f * PI * RIAA_REF_HZ / sampleRate;
+        float c1 = cosf(w), s1 = -sinf(w), c2 = cosf(2.0f * w), s2 = -sinf(2.0f * w);
+        float g = magnitude(curve.b0 + curve.b1 * c1 + curve.b2 * c2, curve.b1 * s1 + curve.b2 * s2)
+                / magnitude(1.0f + curve.a1 * c1 + curve.a2 * c2, curve.a1 * s1 + curve.a2 * s2)
+                * magnitude(1.0f - fit.zc * c1, -fit.zc * s1)
+                / magnitude(1.0f - fit.pc * c1, -fit.pc * s1);
+        curve.b0 /= g; curve.b1 /= g; curve.b2 /= g;
+        curve.resetState();
 
-            if (lvl < threshold) {
-                // Linear map: 0..Threshold -> -10dB..0dB
-                float ratio = (threshold - lvl) / threshold;
-                gainCut = -10.0f * ratio;
-                if (gainCut < -10.0f) gainCut = -10.0f;
+        // 3. IEC: s*T4 / (1 + s*T4), unity at Nyquist
+        rumble = iecRumble;
+        float p4 = expf(-1e6f / (RIAA_IEC_US * sampleRate));
+        iec.setZeroPole(1.0f, p4, 0.5f * (1.0f + p4));
+    }
+
+    inline void processBlock(float* l, float* r, int n) {
+        for (int i = 0; i < n; i++) {
+            curve.process(l[i], r[i]);
+            l[i] = corr.process(0, l[i]);
+            r[i] = corr.process(1, r[i]);
+        }
+        if (rumble) {
+            for (int i = 0; i < n; i++) {
+                l[i] = iec.process(0, l[i]);
+                r[i] = iec.process(1, r[i]);
             }
-            filter.setHighShelf(5000.0, gainCut, 0.707);
-            skipCounter = 0;
         }
+    }
+
+private:
+    static float magnitude(float re, float im) { return sqrtf(re * re + im * im); }
+};
+
+// ==========================================================
+// 2. DOLBY B ENGINE (Single Stage Tape NR)
+// ==========================================================
+#define DOLBY_B_CYCLE_BUDGET  120 // CPU cycles per stereo sample
+#define DOLBY_C_CYCLE_BUDGET  200
+
+// Shelf position from one control value per ENV_DECIM frames, ramped
+// linearly across the sub-block (the envelope is far slower than that).
+// Below threshold: cut rises linearly to full depth at silence.
+template <typename Fn>
+inline float vintageSlide(const float* ctl, int count, int n, float scale, float pos, Fn fn) {
+    for (int k = 0; k < count; k++) {
+        int start = k * ENV_DECIM;
+        int end = start + ENV_DECIM;
+        if (end > n) end = n;
+        float target = fminf(ctl[k] * scale, 1.0f);
+        float step = (target - pos) / (end - start);
+        for (int i = start; i < end; i++) {
+            pos += step;
+            fn(i, pos);
+        }
+    }
+    return pos;
+}
+
+class DolbyB_Engine {
+private:
+    SlidingShelf filter;
+    BlockEnvelope env;
+    float invThreshold = 1.0f / 0.25f; // ~ -12dB activation point (normalized level)
+    float pos = 0.0f;
+
+public:
+    void init() {
+        filter.init(5000.0f, -10.0f, 0.707f); // Up to -10dB above 5kHz
+        env.init(10.0f, 100.0f, ENV_MEAN_ABS, true); // Fast attack (10ms), Medium release (100ms)
+        pos = 0.0f;
+    }
 
-        filter.process(l, r);
+    // n <= ENV_MAX_BLOCK
+    inline void processBlock(float* l, float* r, int n) {
+        // Stereo-linked detection (normalized: the chain is int32 scale)
+        float ctl[ENV_MAX_CTL];
+        int count = env.process(l, r, n, ctl);
+        pos = vintageSlide(ctl, count, n, VINTAGE_INV_FS * invThreshold, pos,
+                           [&](int i, float p) { filter.process(l[i], r[i], p); });
     }
 };
 
@@ -94,92 +331,160 @@ public:
 // Implements two sliding bands (High and Mid) for ~20dB reduction
 class DolbyC_Engine {
 private:
-    Biquad highFilter, midFilter;
-    EnvelopeFollower env;
-    int skipCounter = 0;
+    SlidingShelf highFilter, midFilter;
+    BlockEnvelope env;
+    float invThreshold = 1.0f / 0.35f; // Activates earlier (~ -9dB)
+    float pos = 0.0f;
 
 public:
     void init() {
-        highFilter.setHighShelf(6000.0, 0.0, 1.0); // High Band
-        midFilter.setHighShelf(1000.0, 0.0, 1.0);  // Mid Band (Overlap)
-        env.init(5.0f, 80.0f); // Slightly faster than B
+        // Dolby C aggressive cut: highs up to 12dB, mids up to 10dB
+        highFilter.init(6000.0f, -12.0f, 0.707f); // High Band
+        midFilter.init(1000.0f, -10.0f, 0.707f);  // Mid Band (Overlap)
+        env.init(5.0f, 80.0f, ENV_MEAN_ABS, true); // Slightly faster than B
+        pos = 0.0f;
     }
 
-    inline void process(float &l, float &r) {
-        float lvl = env.process((l + r) * 0.5f);
+    // n <= ENV_MAX_BLOCK
+    inline void processBlock(float* l, float* r, int n) {
+        float ctl[ENV_MAX_CTL];
+        int count = env.process(l, r, n, ctl);
 
-        if (++skipCounter >= 64) {
-            float threshold = 0.35f; // Activates earlier (~ -9dB)
-            float hGain = 0.0f;
-            float mGain = 0.0f;
+        // Cascade Processing: Mid -> High (shared level)
+        pos = vintageSlide(ctl, count, n, VINTAGE_INV_FS * invThreshold, pos,
+                           [&](int i, float p) {
+                               midFilter.process(l[i], r[i], p);
+                               highFilter.process(l[i], r[i], p);
+                           });
+    }
+};
 
-            if (lvl < threshold) {
-                float ratio = (threshold - lvl) / threshold;
-                if(ratio > 1.0f) ratio = 1.0f;
+// ==========================================================
+// SHARED HELPER: FAST LOG2 / EXP2 (table based)
+// ==========================================================
+// Exponent from the float bits, mantissa through a 64-segment table with
+// linear interpolation: ~1e-4 log2 units (< 0.001 dB), no libm calls.
+#define FASTLOG_SEGMENTS 64
 
-                // Dolby C aggressive cut:
-                hGain = -12.0f * ratio; // Highs get cut up to 12dB
-                mGain = -10.0f * ratio; // Mids get cut up to 10dB
-                // Total perceived reduction ~22dB
-            }
+class FastLog2 {
+private:
+    float lg[FASTLOG_SEGMENTS + 1]; // log2(1 + i/N)
+    float ex[FASTLOG_SEGMENTS + 1]; // 2^(i/N)
 
-            highFilter.setHighShelf(6000.0, hGain, 0.707);
-            midFilter.setHighShelf(1000.0, mGain, 0.707);
-            skipCounter = 0;
+public:
+    void init() {
+        for (int i = 0; i <= FASTLOG_SEGMENTS; i++) {
+            lg[i] = log2f(1.0f + (float)i / FASTLOG_SEGMENTS);
+            ex[i] = exp2f((float)i / FASTLOG_SEGMENTS);
         }
+    }
 
-        // Cascade Processing: Mid -> High
-        midFilter.process(l, r);
-        highFilter.process(l, r);
+    // x > 0 (normal floats)
+    inline float log2(float x) {
+        uint32_t u;
+        memcpy(&u, &x, 4);
+        int e = (int)((u >> 23) & 255) - 127;
+        float pos = (u & 0x7FFFFF) * (FASTLOG_SEGMENTS / 8388608.0f);
+        int i = (int)pos;
+        float f = pos - i;
+        return e + lg[i] + f * (lg[i + 1] - lg[i]);
+    }
+
+    // y in [-126, 127]
+    inline float exp2(float y) {
+        int e = (int)y;
+        if (y < e) e--; // floor
+        float pos = (y - e) * FASTLOG_SEGMENTS;
+        int i = (int)pos;
+        float f = pos - i;
+        uint32_t u = (uint32_t)(e + 127) << 23;
+        float scale;
+        memcpy(&scale, &u, 4);
+        return scale * (ex[i] + f * (ex[i + 1] - ex[i]));
     }
 };
 
 // ==========================================================
-// 4. DBX TYPE II ENGINE (Broadband Expander)
+// 4. DBX TYPE II ENGINE (1:2 Expander, Decode)
 // ==========================================================
-// 1:2 Linear Expansion.
-// Logic: If input is below Pivot (-6dB), attenuate it further.
-// This pushes the noise floor down drastically.
+// Logic:
+// 1. Sidechain: mono sum, normalized to +/-1.0, HF weighting (same
+//    network as the encoder's detector).
+// 2. True RMS: BlockEnvelope in ENV_RMS mode (mean square), one value
+//    per ENV_DECIM frames.
+// 3. Gain computer in log2 domain at control rate (1:2 expansion around
+//    the reference): gain = rms / ref -> log2(gain) = 0.5*log2(ms) - log2(ref)
+// 4. Gain ramped linearly across each sub-block, applied to the signal,
+//    then de-emphasis (inverse of the encoder's pre-emphasis).
+// Emphasis corners approximate the dbx II curves (first order, 12 dB).
+#define DBX_REF_DBFS        -15.0f  // RMS level at unity gain (tape 0 VU)
+#define DBX_RMS_MS          20.0f   // RMS integration time
+#define DBX_MAX_BOOST_DB    6.0f    // Above reference
+#define DBX_MAX_CUT_DB      60.0f   // Below reference (noise floor)
+#define DBX_EMPH_LOW_HZ     1600.0f // Signal emphasis: 12 dB shelf between these
+#define DBX_EMPH_HIGH_HZ    6400.0f
+#define DBX_SC_LOW_HZ       400.0f  // Detector weighting: 20 dB shelf
+#define DBX_SC_HIGH_HZ      4000.0f
+#define DBX_CAL_HZ          1000.0f // Reference tone: unity gain at DBX_REF_DBFS
+#define DBX_CYCLE_BUDGET    150     // CPU cycles per stereo sample
+
 class DBX_Engine {
 private:
-    EnvelopeFollower env;
+    FastLog2 fl;
+    FirstOrderShelf scWeight;   // Detector weighting (channel 0 only)
+    FirstOrderShelf deEmph;     // Signal de-emphasis (L/R)
+    BlockEnvelope rms;          // Attack = release: plain one-pole mean square
+    float gain = 0.0f;          // Last applied (ramp start)
+    float log2Ref = 0.0f;
+    float minLog2 = 0.0f, maxLog2 = 0.0f;
 
 public:
     void init() {
-        // DBX timings are critical to avoid "pumping" artifacts.
-        // Type II uses RMS, we approximate with average.
-        // Attack 10ms, Release 50ms (Logarithmic feel)
-        env.init(10.0f, 50.0f);
-    }
-
-    inline void process(float &l, float &r) {
-        // 1. Detect Signal Level
-        float signal = (fabsf(l) + fabsf(r)) * 0.5f;
-        float lvl = env.process(signal);
-
-        // 2. Define Pivot Point (The "0VU" level)
-        // 0.5 (approx -6dBFS) is a safe "Line Level" assumption for 16/32bit audio.
-        // Signals above 0.5 get Boosted (Compressed on tape, Expanded here)
-        // Signals below 0.5 get Attenuated (Expanded downward)
-        float pivot = 0.5f;
-
-        float gain = 1.0f;
-
-        // 3. Calculate Expansion Gain
-        // For 1:2 Expansion Ratio: Gain = Envelope / Pivot
-        if (lvl > 0.001f) {
-            gain = lvl / pivot;
-
-            // Clamp gain to prevent infinite silence or explosion
-            if (gain < 0.1f) gain = 0.1f; // Max attenuation -20dB (Noise Floor)
-            if (gain > 2.0f) gain = 2.0f; // Max boost +6dB
-        } else {
-            gain = 0.0f; // Silence
-        }
+        fl.init();
+        rms.init(DBX_RMS_MS, DBX_RMS_MS, ENV_RMS);
+        // dB -> log2. The weighting's gain at the calibration tone is folded
+        // into the reference so a 1 kHz tone at DBX_REF_DBFS gets unity gain.
+        float fz = DBX_CAL_HZ / DBX_SC_LOW_HZ, fp = DBX_CAL_HZ / DBX_SC_HIGH_HZ;
+        float calDb = 10.0f * log10f((1.0f + fz * fz) / (1.0f + fp * fp));
+        log2Ref = (DBX_REF_DBFS + calDb) / 6.0206f;
+        minLog2 = -DBX_MAX_CUT_DB / 6.0206f;
+        maxLog2 = DBX_MAX_BOOST_DB / 6.0206f;
+        scWeight.init(DBX_SC_LOW_HZ, DBX_SC_HIGH_HZ);
+        deEmph.init(DBX_EMPH_HIGH_HZ, DBX_EMPH_LOW_HZ); // Zero above pole: cut
+        gain = 0.0f;
+    }
 
-        // 4. Apply
-        l *= gain;
-        r *= gain;
+    // n <= ENV_MAX_BLOCK
+    inline void processBlock(float* l, float* r, int n) {
+        // 1. Weighted, normalized sidechain (stereo-linked)
+        float sc[ENV_MAX_BLOCK];
+        for (int i = 0; i < n; i++) sc[i] = scWeight.process(0, (l[i] + r[i]) * (0.5f * VINTAGE_INV_FS));
+
+        // 2. True RMS at control rate
+        float ctl[ENV_MAX_CTL];
+        int count = rms.process(sc, nullptr, n, ctl);
+
+        for (int k = 0; k < count; k++) {
+            // 3. 1:2 expansion in log2 domain, then back to linear.
+            //    Floor at -140 dB: log2 stays finite.
+            float g = 0.5f * fl.log2(ctl[k] + 1e-14f) - log2Ref;
+            if (g < minLog2) g = minLog2;
+            if (g > maxLog2) g = maxLog2;
+            float target = fl.exp2(g);
+
+            // 4. Apply (ramped) + de-emphasis. Clamp: the preamp converts to int32.
+            int start = k * ENV_DECIM;
+            int end = start + ENV_DECIM;
+            if (end > n) end = n;
+            float step = (target - gain) / (end - start);
+            for (int i = start; i < end; i++) {
+                gain += step;
+                float yl = deEmph.process(0, l[i] * gain);
+                float yr = deEmph.process(1, r[i] * gain);
+                l[i] = constrain(yl, -2147483520.0f, 2147483520.0f);
+                r[i] = constrain(yr, -2147483520.0f, 2147483520.0f);
+            }
+        }
     }
 };
 
@@ -5,11 +5,26 @@
 #include <Preferences.h>
 #include <ArduinoJson.h>
 #include "dsp_engine.h"
+#include "settingstore.h"
+#include "fmradio.h"
+#include "displayinfo.h"
+#include "metadata.h"
+#include "meter.h"
+#include "spectrum.h"
+#include "dspbench.h"
 
 // --- Externs ---
 extern WebServer server;
 extern AudioDSP dsp;
 extern Preferences preferences;
+extern SettingsStore settings;
+extern RadioManager radio;
+extern DisplayUI ui;
+extern MetadataMailbox btMeta;
+extern Meter meter;
+extern Spectrum spectrum;
+extern DspBench bench;
+extern OperationMode currentMode; // Defined in main before this header
 extern String btName, wifiSSID, wifiPass;
 
 // Signal Generator Globals
@@ -18,6 +33,10 @@ extern int genSignalType;
 extern float genFreqStart;
 extern float genFreqEnd;
 extern float genPeriod;
+extern SignalGenerator gen;
+extern Measurement measure;
+extern AutoEQ autoEq;
+extern LufsMeter lufs;
 
 // Include the HTML content
 #include "html1.h"
@@ -28,6 +47,38 @@ void handleRoot() {
     server.send(200, "text/html", INDEX_HTML);
 }
 
+// Applies a DSP/preset document (stereo, subsonic, eqEnable, gain, eq[]) with safe pausing
+void applyDSPSettings(JsonObject doc) {
+    // --- STEP 1: PAUSE ENGINE ---
+    // Tell the audio thread to output silence
+    dsp.isUpdating = true;
+
+    // --- STEP 2: WAIT FOR BUFFER FLUSH ---
+    // Wait approx 150ms for existing audio in buffers to drain out
+    delay(150);
+
+    // --- STEP 3: APPLY SETTINGS ---
+    dsp.stereoExpand = doc["stereo"];
+    dsp.subsonicFilter = doc["subsonic"];
+    dsp.eqEnabled = doc["eqEnable"]; 
+    dsp.outputGain = (float)doc["gain"] / 100.0f;
+
+    // Update EQ Bands
+    JsonArray eq = doc["eq"];
+    if (!eq.isNull()) {
+        for(int i=0; i<EQ_BANDS; i++) {
+            dsp.updateEQBand(i, eq[i]);
+        }
+    }
+
+    // --- STEP 4: STABILIZATION DELAY ---
+    // Allow calculations to settle
+    delay(50);
+
+    // --- STEP 5: RESUME ENGINE ---
+    dsp.isUpdating = false;
+}
+
 // 2. Handle DSP Parameter Updates with Safe Pausing
 void handleDSPConfig() {
     if (server.hasArg("plain")) {
@@ -40,35 +91,7 @@ void handleDSPConfig() {
             return;
         }
 
-        // --- STEP 1: PAUSE ENGINE ---
-        // Tell the audio thread to output silence
-        dsp.isUpdating = true;
-
-        // --- STEP 2: WAIT FOR BUFFER FLUSH ---
-        // Wait approx 150ms for existing audio in buffers to drain out
-        delay(150);
-
-        // --- STEP 3: APPLY SETTINGS ---
-        dsp.stereoExpand = doc["stereo"];
-        dsp.subsonicFilter = doc["subsonic"];
-        dsp.eqEnabled = doc["eqEnable"]; 
-        dsp.outputGain = (float)doc["gain"] / 100.0f;
-
-        // Update EQ Bands
-        JsonArray eq = doc["eq"];
-        if (!eq.isNull()) {
-            for(int i=0; i<10; i++) {
-                dsp.updateEQBand(i, eq[i]);
-            }
-        }
-
-        // --- STEP 4: STABILIZATION DELAY ---
-        // Allow calculations to settle
-        delay(50);
-
-        // --- STEP 5: RESUME ENGINE ---
-        dsp.isUpdating = false;
-
+        applyDSPSettings(doc.as<JsonObject>());
         server.send(200, "text/plain", "DSP Updated");
     } else {
         server.send(400, "text/plain", "No Data");
@@ -85,11 +108,34 @@ void handleGenConfig() {
         genFreqStart = doc["fStart"];
         genFreqEnd = doc["fEnd"];
         genPeriod = doc["period"];
+        gen.configure(genSignalType, genFreqStart, genFreqEnd, genPeriod);
 
         server.send(200, "text/plain", "Gen Updated");
      }
 }
 
+// Writes the RELEVANT parts of a DSP document to preset slot 'id'.
+// This ensures "What You See (in UI) Is What You Save".
+void storePreset(int id, JsonObject doc) {
+    String key = "p" + String(id);
+    DynamicJsonDocument store(2048);
+
+    store["stereo"] = doc["stereo"];
+    store["subsonic"] = doc["subsonic"];
+    store["eqEnable"] = doc["eqEnable"];
+    store["gain"] = doc["gain"];
+
+    JsonArray eqVals = store.createNestedArray("eq");
+    JsonArray incomingEq = doc["eq"];
+    for(int i=0; i<EQ_BANDS; i++) {
+         eqVals.add(incomingEq[i]);
+    }
+
+    String output;
+    serializeJson(store, output);
+    preferences.putString(key.c_str(), output);
+}
+
 // 4. Handle Save Preset (Saves what the UI sends, ensuring consistency)
 void handleSavePreset() {
     if (server.hasArg("plain")) {
@@ -101,27 +147,7 @@ void handleSavePreset() {
             return;
         }
 
-        int id = doc["id"];
-        String key = "p" + String(id);
-
-        // We re-serialize the RELEVANT parts of the incoming JSON to storage.
-        // This ensures "What You See (in UI) Is What You Save".
-        DynamicJsonDocument store(2048);
-
-        store["stereo"] = doc["stereo"];
-        store["subsonic"] = doc["subsonic"];
-        store["eqEnable"] = doc["eqEnable"];
-        store["gain"] = doc["gain"]; 
-        
-        JsonArray eqVals = store.createNestedArray("eq");
-        JsonArray incomingEq = doc["eq"];
-        for(int i=0; i<10; i++) {
-             eqVals.add(incomingEq[i]);
-        }
-
-        String output;
-        serializeJson(store, output);
-        preferences.putString(key.c_str(), output);
+        storePreset(doc["id"], doc.as<JsonObject>());
         
         // Also update the live DSP to match what we just saved (Safety sync)
         dsp.stereoExpand = doc["stereo"];
@@ -168,6 +194,592 @@ void handleSystemConfig() {
     }
 }
 
+// Runtime Statistics (read-only)
+void handleStatus() {
+    DynamicJsonDocument doc(2048);
+
+    // NVS write-behind: how many flash writes were coalesced away
+    doc["nvsRequested"] = settings.writesRequested;
+    doc["nvsCommitted"] = settings.writesCommitted;
+    doc["nvsAvoided"] = settings.writesAvoided() + radio.nvsWritesAvoided();
+
+    // LCD framebuffer: HD44780 bytes sent by the last frame
+    doc["lcdFrameBytes"] = ui.getLastFrameBytes();
+    doc["lcdTotalBytes"] = ui.getTotalBytes();
+
+    // RDS decoder: I2C bursts vs. characters accepted by voting
+    doc["rdsReads"] = radio.getRDSReads();
+    doc["rdsChars"] = radio.getRDSChars();
+    doc["rdsPty"] = radio.getRDSPty();
+
+    // Output level (dBFS, ballistics applied at display rate)
+    doc["vuL"] = meter.getVU(0);
+    doc["vuR"] = meter.getVU(1);
+    doc["ppmL"] = meter.getPPM(0);
+    doc["ppmR"] = meter.getPPM(1);
+
+    // Master volume (DSP)
+    doc["volumeDb"] = dsp.getVolumeDb();
+
+    // Limiter: deepest gain reduction since the last poll
+    doc["limiterGR"] = dsp.limiter.getGainReductionDb();
+
+    // FIR room correction
+    doc["convTaps"] = dsp.conv.getTaps();
+    doc["convMaxTaps"] = dsp.conv.getTapLimit();
+
+    // DSP stage cost measured at boot
+    JsonArray b = doc.createNestedArray("bench");
+    for (int i = 0; i < bench.getCount(); i++) {
+        JsonObject e = b.createNestedObject();
+        e["name"] = bench.get(i).name;
+        e["cycles"] = bench.get(i).cyclesPerSample;
+        e["budget"] = bench.get(i).budget;
+    }
+
+    // Bluetooth track info (lock-free snapshot)
+    if (currentMode == MODE_BT) {
+        TrackInfo meta;
+        if (btMeta.read(meta)) {
+            doc["btTitle"] = meta.title;
+            doc["btArtist"] = meta.artist;
+            doc["btAlbum"] = meta.album;
+            doc["btPlayState"] = meta.playState;
+            uint32_t pos = meta.positionAt(millis());
+            if (pos != META_POS_UNKNOWN) doc["btPositionMs"] = pos;
+            doc["btDurationMs"] = meta.durationMs;
+        }
+    }
+
+    // Heap health: a shrinking largest block means fragmentation
+    doc["freeHeap"] = ESP.getFreeHeap();
+    doc["maxAllocHeap"] = ESP.getMaxAllocHeap();
+
+    String output;
+    serializeJson(doc, output);
+    server.send(200, "application/json", output);
+}
+
+// Spectrum: GET returns the bands (?bands=31 for third-octaves),
+// POST {"lcd": true} shows the 10 EQ bands on the LCD VU row
+void handleSpectrum() {
+    if (server.method() == HTTP_POST) {
+        DynamicJsonDocument req(128);
+        if (deserializeJson(req, server.arg("plain"))) {
+            server.send(400, "text/plain", "Invalid JSON");
+            return;
+        }
+        bool lcdRow = req["lcd"] | false;
+        ui.setSpectrumRow(lcdRow);
+        settings.putBool("spec_lcd", lcdRow);
+        server.send(200, "text/plain", "OK");
+        return;
+    }
+
+    spectrum.touch(); // Keeps the analyzer running while the page polls
+    int count = (server.arg("bands").toInt() == SPECTRUM_ISO_BANDS) ? SPECTRUM_ISO_BANDS : SPECTRUM_EQ_BANDS;
+    float bands[SPECTRUM_ISO_BANDS];
+    spectrum.getBands(bands, count);
+    const float* freqs = spectrum.getBandFreqs(count);
+
+    DynamicJsonDocument doc(2048);
+    JsonArray f = doc.createNestedArray("freqs");
+    JsonArray db = doc.createNestedArray("db");
+    for (int i = 0; i < count; i++) {
+        f.add(freqs[i]);
+        db.add(roundf(bands[i] * 10.0f) / 10.0f);
+    }
+    doc["active"] = spectrum.isActive();
+    doc["load"] = spectrum.getLoad();
+    doc["lcd"] = ui.isSpectrumRow();
+
+    String output;
+    serializeJson(doc, output);
+    server.send(200, "application/json", output);
+}
+
+// --- Crossover ---
+// Stored as one JSON string in NVS (like the presets). 'enabled' changes the
+// I2S1 routing, so it takes effect at the next boot; the rest applies live.
+void xoverWayFromJson(XoverWay& w, JsonObject o) {
+    if (o.isNull()) return;
+    w.gainDb = o["gain"] | w.gainDb;
+    w.invert = o["invert"] | w.invert;
+}
+
+void xoverFromJson(JsonObject o) {
+    dsp.xover.subMono = o["mono"] | dsp.xover.subMono;
+    dsp.xover.order = o["order"] | dsp.xover.order;
+    dsp.xover.freq = o["freq"] | dsp.xover.freq;
+    xoverWayFromJson(dsp.xover.high, o["high"]);
+    xoverWayFromJson(dsp.xover.low, o["low"]);
+}
+
+void xoverToJson(JsonObject o, bool enabled) {
+    o["enabled"] = enabled;
+    o["mono"] = dsp.xover.subMono;
+    o["order"] = dsp.xover.order;
+    o["freq"] = dsp.xover.freq;
+    const XoverWay* ways[2] = { &dsp.xover.high, &dsp.xover.low };
+    const char* names[2] = { "high", "low" };
+    for (int i = 0; i < 2; i++) {
+        JsonObject w = o.createNestedObject(names[i]);
+        w["gain"] = ways[i]->gainDb;
+        w["invert"] = ways[i]->invert;
+    }
+}
+
+// Boot: before the first switchMode (sets up the I2S routing)
+void loadCrossoverConfig() {
+    if (preferences.isKey("xover")) {
+        DynamicJsonDocument doc(512);
+        if (!deserializeJson(doc, preferences.getString("xover"))) {
+            xoverFromJson(doc.as<JsonObject>());
+            dsp.xover.enabled = doc["enabled"] | false;
+        }
+    }
+    dsp.xover.apply();
+}
+
+// GET: config, POST: apply + save
+void handleCrossover() {
+    bool pendingEnable = dsp.xover.enabled;
+    if (preferences.isKey("xover")) {
+        DynamicJsonDocument saved(512);
+        if (!deserializeJson(saved, preferences.getString("xover"))) pendingEnable = saved["enabled"] | false;
+    }
+
+    if (server.method() == HTTP_POST) {
+        DynamicJsonDocument req(512);
+        if (deserializeJson(req, server.arg("plain"))) {
+            server.send(400, "text/plain", "Invalid JSON");
+            return;
+        }
+
+        dsp.isUpdating = true;
+        delay(150);
+        xoverFromJson(req.as<JsonObject>());
+        dsp.xover.apply();
+        delay(50);
+        dsp.isUpdating = false;
+
+        pendingEnable = req["enabled"] | pendingEnable;
+        DynamicJsonDocument store(512);
+        xoverToJson(store.to<JsonObject>(), pendingEnable);
+        String output;
+        serializeJson(store, output);
+        preferences.putString("xover", output);
+    }
+
+    DynamicJsonDocument doc(512);
+    xoverToJson(doc.to<JsonObject>(), pendingEnable);
+    doc["active"] = dsp.xover.enabled; // Routing in use now
+    String output;
+    serializeJson(doc, output);
+    server.send(200, "application/json", output);
+}
+
+// --- Multiband Dynamics ---
+// Stored as one JSON string in NVS, applied live.
+// {"enabled", "fLow", "fHigh", "bands": [{thresh, ratio, attack, release, makeup, exp}] x3}
+void mbcFromJson(JsonObject o) {
+    dsp.mbc.enabled = o["enabled"] | dsp.mbc.enabled;
+    dsp.mbc.freqLow = o["fLow"] | dsp.mbc.freqLow;
+    dsp.mbc.freqHigh = o["fHigh"] | dsp.mbc.freqHigh;
+    JsonArray list = o["bands"];
+    if (list.isNull()) return;
+    for (int i = 0; i < MBC_BANDS; i++) {
+        JsonObject b = list[i];
+        if (b.isNull()) continue;
+        MbcBand& p = dsp.mbc.band[i];
+        p.threshDb = b["thresh"] | p.threshDb;
+        p.ratio = b["ratio"] | p.ratio;
+        p.attackMs = b["attack"] | p.attackMs;
+        p.releaseMs = b["release"] | p.releaseMs;
+        p.makeupDb = b["makeup"] | p.makeupDb;
+        p.expThreshDb = b["exp"] | p.expThreshDb;
+    }
+}
+
+void mbcToJson(JsonObject o) {
+    o["enabled"] = dsp.mbc.enabled;
+    o["fLow"] = dsp.mbc.freqLow;
+    o["fHigh"] = dsp.mbc.freqHigh;
+    JsonArray list = o.createNestedArray("bands");
+    for (int i = 0; i < MBC_BANDS; i++) {
+        const MbcBand& p = dsp.mbc.band[i];
+        JsonObject b = list.createNestedObject();
+        b["thresh"] = p.threshDb;
+        b["ratio"] = p.ratio;
+        b["attack"] = p.attackMs;
+        b["release"] = p.releaseMs;
+        b["makeup"] = p.makeupDb;
+        b["exp"] = p.expThreshDb;
+    }
+}
+
+void loadMultibandConfig() {
+    if (preferences.isKey("mbc")) {
+        DynamicJsonDocument doc(1024);
+        if (!deserializeJson(doc, preferences.getString("mbc"))) mbcFromJson(doc.as<JsonObject>());
+    }
+    dsp.mbc.apply();
+}
+
+// GET: config + gain reduction per band, POST: apply + save
+void handleMultiband() {
+    if (server.method() == HTTP_POST) {
+        DynamicJsonDocument req(1024);
+        if (deserializeJson(req, server.arg("plain"))) {
+            server.send(400, "text/plain", "Invalid JSON");
+            return;
+        }
+
+        dsp.isUpdating = true;
+        delay(150);
+        mbcFromJson(req.as<JsonObject>());
+        dsp.mbc.apply();
+        delay(50);
+        dsp.isUpdating = false;
+
+        DynamicJsonDocument store(1024);
+        mbcToJson(store.to<JsonObject>());
+        String output;
+        serializeJson(store, output);
+        preferences.putString("mbc", output);
+    }
+
+    DynamicJsonDocument doc(1024);
+    mbcToJson(doc.to<JsonObject>());
+    JsonArray gr = doc.createNestedArray("gr");
+    for (int i = 0; i < MBC_BANDS; i++) gr.add(roundf(dsp.mbc.getReduction(i) * 10.0f) / 10.0f);
+    String output;
+    serializeJson(doc, output);
+    server.send(200, "application/json", output);
+}
+
+// --- Time Alignment ---
+// Per-output delays (main L/R, low L/R), stored in samples as one NVS string.
+// POST {"unit": "cm" | "samples", "interp": bool, "delays": [mL, mR, lL, lR]}
+void applyDelayConfig(JsonArray list, bool cm, bool interp) {
+    float d[DELAY_CHANNELS];
+    for (int i = 0; i < DELAY_CHANNELS; i++) {
+        float v = list[i] | 0.0f;
+        d[i] = cm ? OutputDelay::cmToSamples(v) : v;
+    }
+    dsp.delays.configure(d, interp);
+}
+
+void loadDelayConfig() {
+    if (!preferences.isKey("delay")) return;
+    DynamicJsonDocument doc(256);
+    if (deserializeJson(doc, preferences.getString("delay"))) return;
+    applyDelayConfig(doc["samples"], false, doc["interp"] | false);
+}
+
+void handleDelay() {
+    if (server.method() == HTTP_POST) {
+        DynamicJsonDocument req(256);
+        if (deserializeJson(req, server.arg("plain"))) {
+            server.send(400, "text/plain", "Invalid JSON");
+            return;
+        }
+        String unit = req["unit"] | "cm";
+
+        dsp.isUpdating = true;
+        delay(150);
+        applyDelayConfig(req["delays"], unit != "samples", req["interp"] | false);
+        delay(50);
+        dsp.isUpdating = false;
+
+        DynamicJsonDocument store(256);
+        store["interp"] = dsp.delays.getInterp();
+        JsonArray smp = store.createNestedArray("samples");
+        for (int i = 0; i < DELAY_CHANNELS; i++) smp.add(dsp.delays.getSamples(i));
+        String output;
+        serializeJson(store, output);
+        preferences.putString("delay", output);
+    }
+
+    DynamicJsonDocument doc(512);
+    doc["interp"] = dsp.delays.getInterp();
+    doc["maxMs"] = DELAY_MAX_MS;
+    JsonArray smp = doc.createNestedArray("samples");
+    JsonArray cm = doc.createNestedArray("cm");
+    for (int i = 0; i < DELAY_CHANNELS; i++) {
+        smp.add(dsp.delays.getSamples(i));
+        cm.add(roundf(OutputDelay::samplesToCm(dsp.delays.getSamples(i)) * 10.0f) / 10.0f);
+    }
+    String output;
+    serializeJson(doc, output);
+    server.send(200, "application/json", output);
+}
+
+// --- FIR Room Correction ---
+// IR upload is staged in RAM (PSRAM if present) and decoded on completion.
+// Only the first IR_UPLOAD_MAX bytes are kept: the WAV parser clamps the
+// data chunk, so a longer IR is simply truncated. Not persisted.
+#define IR_UPLOAD_MAX (CONV_MAX_TAPS * 2 * 4 + 1024) // Stereo float32 + header
+
+static uint8_t* irUpload = nullptr;
+static size_t irUploadLen = 0;
+
+void sendIRStatus() {
+    DynamicJsonDocument doc(256);
+    doc["loaded"] = dsp.conv.isLoaded();
+    doc["taps"] = dsp.conv.getTaps();
+    doc["partitions"] = dsp.conv.getPartitions();
+    doc["latency"] = dsp.conv.isLoaded() ? dsp.conv.getLatency() : 0;
+    doc["truncated"] = dsp.conv.wasTruncated();
+    doc["maxTaps"] = dsp.conv.getTapLimit();
+
+    String output;
+    serializeJson(doc, output);
+    server.send(200, "application/json", output);
+}
+
+// Multipart chunks (called before handleIRLoad)
+void handleIRUpload() {
+    HTTPUpload& up = server.upload();
+    if (up.status == UPLOAD_FILE_START) {
+        if (!irUpload) irUpload = (uint8_t*)heap_caps_malloc(IR_UPLOAD_MAX, MALLOC_CAP_SPIRAM);
+        if (!irUpload) irUpload = (uint8_t*)malloc(IR_UPLOAD_MAX);
+        irUploadLen = 0;
+    } else if (up.status == UPLOAD_FILE_WRITE && irUpload) {
+        size_t n = up.currentSize;
+        if (n > IR_UPLOAD_MAX - irUploadLen) n = IR_UPLOAD_MAX - irUploadLen;
+        memcpy(irUpload + irUploadLen, up.buf, n);
+        irUploadLen += n;
+    } else if (up.status == UPLOAD_FILE_ABORTED) {
+        free(irUpload);
+        irUpload = nullptr;
+        irUploadLen = 0;
+    }
+}
+
+// POST: decode + load the staged file (audio paused while swapping)
+void handleIRLoad() {
+    if (!irUpload || irUploadLen == 0) {
+        server.send(400, "text/plain", "No IR file");
+        return;
+    }
+
+    dsp.isUpdating = true;
+    delay(150);
+    bool ok = dsp.conv.loadFile(irUpload, irUploadLen);
+    delay(50);
+    dsp.isUpdating = false;
+
+    free(irUpload);
+    irUpload = nullptr;
+    irUploadLen = 0;
+
+    if (!ok) {
+        server.send(400, "text/plain", "Invalid IR (WAV 44.1 kHz PCM/float, 1-2 ch, or raw float32)");
+        return;
+    }
+    sendIRStatus();
+}
+
+// GET: status, DELETE: back to bypass
+void handleIR() {
+    if (server.method() == HTTP_DELETE) {
+        dsp.isUpdating = true;
+        delay(150);
+        dsp.conv.clear();
+        dsp.isUpdating = false;
+    }
+    sendIRStatus();
+}
+
+// --- Measurement ---
+// POST starts a sweep (AUX input, RX only), GET returns progress and results
+void handleMeasure() {
+    if (server.method() == HTTP_POST) {
+        if (currentMode != MODE_AUX || isTxMode) {
+            server.send(409, "text/plain", "Measurement needs AUX mode");
+            return;
+        }
+        if (!measure.start()) {
+            server.send(503, "text/plain", measure.isBusy() ? "Busy" : "Out of memory");
+            return;
+        }
+    }
+
+    static const char* stateNames[] = { "idle", "prepare", "play", "deconv", "reference", "analyze", "done", "error" };
+    DynamicJsonDocument doc(4096);
+    int state = measure.getState();
+    doc["state"] = stateNames[state];
+    doc["progress"] = measure.getProgress();
+    if (state == MEAS_DONE) {
+        doc["latencyMs"] = measure.getLatencyMs();
+        doc["peakDb"] = roundf(measure.getPeakDb() * 10.0f) / 10.0f;
+        if (measure.getLatency() >= 0) {
+            JsonArray f = doc.createNestedArray("freqs");
+            JsonArray db = doc.createNestedArray("db");
+            JsonArray thd = doc.createNestedArray("thd");
+            for (int i = 0; i < measure.getPointCount(); i++) {
+                f.add(roundf(measure.getFreq(i)));
+                db.add(roundf(measure.getDb(i) * 10.0f) / 10.0f);
+                thd.add(roundf(measure.getThd(i) * 100.0f) / 100.0f);
+            }
+        }
+    }
+
+    String output;
+    serializeJson(doc, output);
+    server.send(200, "application/json", output);
+}
+
+// Auto EQ: POST {"fLo", "fHi", "tilt", "boost"} fits the last measurement,
+// POST {"apply": id} stores the fit in preset 'id' and applies it.
+// GET returns progress and the fitted gains.
+void handleAutoEQ() {
+    if (server.method() == HTTP_POST) {
+        DynamicJsonDocument req(256);
+        if (deserializeJson(req, server.arg("plain"))) {
+            server.send(400, "text/plain", "Invalid JSON");
+            return;
+        }
+
+        if (!req["apply"].isNull()) {
+            if (autoEq.getState() != AEQ_DONE) {
+                server.send(409, "text/plain", "No fit");
+                return;
+            }
+            // Current settings with the fitted EQ: the normal preset path
+            DynamicJsonDocument p(512);
+            p["stereo"] = dsp.stereoExpand;
+            p["subsonic"] = dsp.subsonicFilter;
+            p["eqEnable"] = true;
+            p["gain"] = (int)lroundf(dsp.outputGain * 100.0f);
+            JsonArray eq = p.createNestedArray("eq");
+            for (int i = 0; i < EQ_BANDS; i++) eq.add(autoEq.getGain(i));
+            storePreset(req["apply"], p.as<JsonObject>());
+            applyDSPSettings(p.as<JsonObject>());
+        } else {
+            if (measure.getState() != MEAS_DONE || measure.getLatency() < 0) {
+                server.send(409, "text/plain", "Measure first");
+                return;
+            }
+            float f[MEAS_POINTS], db[MEAS_POINTS];
+            for (int i = 0; i < MEAS_POINTS; i++) {
+                f[i] = measure.getFreq(i);
+                db[i] = measure.getDb(i);
+            }
+            if (!autoEq.start(f, db, MEAS_POINTS, req["fLo"] | AUTOEQ_F_LO, req["fHi"] | AUTOEQ_F_HI,
+                              req["tilt"] | 0.0f, req["boost"] | AUTOEQ_MAX_BOOST)) {
+                server.send(409, "text/plain", autoEq.isBusy() ? "Busy" : "Range too small");
+                return;
+            }
+        }
+    }
+
+    static const char* stateNames[] = { "idle", "running", "done", "error" };
+    DynamicJsonDocument doc(512);
+    int state = autoEq.getState();
+    doc["state"] = stateNames[state];
+    doc["iter"] = autoEq.getIterations();
+    if (state == AEQ_DONE) {
+        doc["errBefore"] = roundf(autoEq.getErrorBefore() * 100.0f) / 100.0f;
+        doc["errAfter"] = roundf(autoEq.getErrorAfter() * 100.0f) / 100.0f;
+        JsonArray eq = doc.createNestedArray("eq");
+        for (int i = 0; i < EQ_BANDS; i++) eq.add(autoEq.getGain(i));
+    }
+
+    String output;
+    serializeJson(doc, output);
+    server.send(200, "application/json", output);
+}
+
+// Linear IR as a mono float WAV (loads back into /api/ir after editing)
+void handleMeasureIR() {
+    const float* ir = measure.getIR();
+    if (!ir || measure.getLatency() < 0) {
+        server.send(404, "text/plain", "No measurement");
+        return;
+    }
+    uint32_t dataBytes = measure.getIRLength() * sizeof(float);
+    uint32_t rate = (uint32_t)MEAS_FS;
+    uint8_t h[44];
+    auto put32 = [&](int at, uint32_t v) { for (int i = 0; i < 4; i++) h[at + i] = (v >> (8 * i)) & 0xFF; };
+    auto put16 = [&](int at, uint16_t v) { h[at] = v & 0xFF; h[at + 1] = v >> 8; };
+    memcpy(h, "RIFF", 4); put32(4, 36 + dataBytes); memcpy(h + 8, "WAVEfmt ", 8);
+    put32(16, 16); put16(20, 3); put16(22, 1);   // IEEE float, mono
+    put32(24, rate); put32(28, rate * 4); put16(32, 4); put16(34, 32);
+    memcpy(h + 36, "data", 4); put32(40, dataBytes);
+
+    server.sendHeader("Content-Disposition", "attachment; filename=\"measure_ir.wav\"");
+    server.setContentLength(sizeof(h) + dataBytes);
+    server.send(200, "audio/wav", "");
+    server.sendContent((const char*)h, sizeof(h));
+    server.sendContent((const char*)ir, dataBytes); // ESP32: little-endian floats
+}
+
+// Loudness: GET returns the LUFS readings and the source trim,
+// POST {"enabled", "target", "loudLevel"} sets up the normalization and
+// the level-dependent loudness mode (saved)
+void handleLufs() {
+    if (server.method() == HTTP_POST) {
+        DynamicJsonDocument req(128);
+        if (deserializeJson(req, server.arg("plain"))) {
+            server.send(400, "text/plain", "Invalid JSON");
+            return;
+        }
+        bool on = req["enabled"] | lufs.isEnabled();
+        lufs.setEnabled(on);
+        lufs.setTarget(req["target"] | lufs.getTarget());
+        settings.putBool("lufs_on", on);
+        settings.putInt("lufs_tgt", (int)lroundf(lufs.getTarget()));
+        dsp.loudnessLevelMode = req["loudLevel"] | dsp.loudnessLevelMode;
+        settings.putBool("loud_lvl", dsp.loudnessLevelMode);
+        bool trimmed = on && !isTxMode && currentMode != MODE_GEN;
+        dsp.setSourceTrim(trimmed ? lufs.getTrim() : 0.0f);
+    }
+
+    DynamicJsonDocument doc(256);
+    doc["momentary"] = roundf(lufs.getMomentary() * 10.0f) / 10.0f;
+    doc["shortTerm"] = roundf(lufs.getShortTerm() * 10.0f) / 10.0f;
+    doc["integrated"] = roundf(lufs.getIntegrated() * 10.0f) / 10.0f;
+    doc["trim"] = roundf(lufs.getTrim() * 10.0f) / 10.0f;
+    doc["target"] = lufs.getTarget();
+    doc["enabled"] = lufs.isEnabled();
+    doc["loudLevel"] = dsp.loudnessLevelMode;
+
+    String output;
+    serializeJson(doc, output);
+    server.send(200, "application/json", output);
+}
+
+// Radio Band Scan: POST starts it, GET returns progress + station list
+void handleRadioScan() {
+    if (server.method() == HTTP_POST) {
+        if (currentMode != MODE_RADIO) {
+            server.send(409, "text/plain", "Radio not active");
+            return;
+        }
+        radio.startScan();
+        server.send(200, "text/plain", "Scan Started");
+        return;
+    }
+
+    DynamicJsonDocument doc(2048);
+    doc["busy"] = radio.isScanning();
+    doc["progress"] = radio.getScanProgress();
+    JsonArray list = doc.createNestedArray("stations");
+    for (int i = 0; i < radio.getStationCount(); i++) {
+        const StationInfo& st = radio.getStation(i);
+        JsonObject o = list.createNestedObject();
+        o["f"] = st.freq / 100.0f;
+        o["rssi"] = st.rssi;
+        o["ps"] = (const char*)st.ps;
+    }
+
+    String output;
+    serializeJson(doc, output);
+    server.send(200, "application/json", output);
+}
+
 void initWebServer() {
     server.on("/", handleRoot);
     server.on("/api/dsp", HTTP_POST, handleDSPConfig);
@@ -175,6 +787,19 @@ void initWebServer() {
     server.on("/api/savePreset", HTTP_POST, handleSavePreset);
     server.on("/api/preset", HTTP_GET, handleLoadPreset);
     server.on("/api/config", HTTP_POST, handleSystemConfig);
+    server.on("/api/status", HTTP_GET, handleStatus);
+    server.on("/api/scan", handleRadioScan);
+    server.on("/api/spectrum", handleSpectrum);
+    server.on("/api/xover", handleCrossover);
+    server.on("/api/mbc", handleMultiband);
+    server.on("/api/delay", handleDelay);
+    server.on("/api/ir", HTTP_POST, handleIRLoad, handleIRUpload);
+    server.on("/api/ir", HTTP_GET, handleIR);
+    server.on("/api/ir", HTTP_DELETE, handleIR);
+    server.on("/api/measure", handleMeasure);
+    server.on("/api/measure/ir", HTTP_GET, handleMeasureIR);
+    server.on("/api/autoeq", handleAutoEQ);
+    server.on("/api/lufs", handleLufs);
 
     server.begin();
 }